@@ -9,6 +9,7 @@ DECLARE_STATS_GROUP(TEXT("WaterStatics - BuoyancyData"), STATGROUP_BuoyancyStati
 DECLARE_CYCLE_STAT(TEXT("TriangleCreation"), STAT_BuoyantMeshDataTriangleCreation, STATGROUP_BuoyancyStatics);
 DECLARE_CYCLE_STAT(TEXT("VertexTransform"), STAT_BuoyantMeshDataVertexTransform, STATGROUP_BuoyancyStatics);
 DECLARE_CYCLE_STAT(TEXT("VertexDepthProjection"), STAT_VertexDepthProjection, STATGROUP_BuoyancyStatics);
+DECLARE_CYCLE_STAT(TEXT("VertexDepthFromSamples"), STAT_VertexDepthFromSamples, STATGROUP_BuoyancyStatics);
 
 
 USTRUCT()
@@ -141,6 +142,9 @@ struct FWaterGrid //Data representing an approximated water surface in a grid sy
 		FVector2D GridSize = FVector2D::ZeroVector;	//Represents the number of cells and the last index of the vertices
 	UPROPERTY()
 		FBox TargetBounds = FBox(); //The bounds of the target this grid is encompassing
+	FIntPoint MaskedCellRows = FIntPoint(0, -1); //The first and last row of cells inside the footprint mask, see SetFootprintMask()
+	TArray<FIntPoint> MaskedCellColumns; //Per row of cells, the first and last column inside the footprint mask - empty while the whole grid is sampled
+	TArray<FIntPoint> MaskedVertexColumns; //Per row of vertices, the first and last column belonging to a masked cell - empty while the whole grid is sampled
 
 	FWaterGrid() {};
 	FWaterGrid(float CellLength, FVector BoundingBoxSize, FVector TargetLocation)
@@ -257,6 +261,143 @@ struct FWaterGrid //Data representing an approximated water surface in a grid sy
 		return Verts;
 	}
 
+	/*
+	*	Restrict the grid to the cells covered by a footprint, only the vertices of those cells are sampled and read.
+	*	The footprint is the convex hull of the points, dilated by the margin. Every row of cells gets a single span of columns,
+	*	which is exact for convex footprints. The mask is cleared if the footprint doesn't overlap the grid.
+	*	@param	FootprintPoints - World space points whose convex hull is the footprint, e.g. the corners of a rotated bounding box
+	*	@param	Margin - The distance in cm the footprint is dilated by, covers the water's horizontal displacement and cut vertices
+	*/
+	void SetFootprintMask(const TArray<FVector2D>& FootprintPoints, float Margin)
+	{
+		ClearFootprintMask();
+		if (FootprintPoints.Num() == 0 || CellSize <= 0.0f)
+			return;
+
+		const int32 NumCellRows = int32(GridSize.X), NumCellColumns = int32(GridSize.Y);
+		float MinX = FootprintPoints[0].X, MaxX = FootprintPoints[0].X;
+		for (const FVector2D& Point : FootprintPoints)
+		{
+			MinX = FMath::Min(MinX, Point.X);
+			MaxX = FMath::Max(MaxX, Point.X);
+		}
+
+		const int32 FirstRow = FMath::Max(FMath::FloorToInt((MinX - Margin - GridOrigin.X) / CellSize), 0);
+		const int32 LastRow = FMath::Min(FMath::CeilToInt((MaxX + Margin - GridOrigin.X) / CellSize) - 1, NumCellRows - 1);
+		if (FirstRow > LastRow)
+			return;
+
+		MaskedCellColumns.Init(FIntPoint(0, -1), NumCellRows);
+		MaskedVertexColumns.Init(FIntPoint(0, -1), NumCellRows + 1);
+		MaskedCellRows = FIntPoint(NumCellRows, -1);
+		for (int32 Row = FirstRow; Row <= LastRow; Row++)
+		{
+			//The footprint's extent along Y inside the row's strip, found on the segments between every pair of points - the hull's edges are among them
+			const float StripMinX = GridOrigin.X + (Row * CellSize) - Margin;
+			const float StripMaxX = GridOrigin.X + ((Row + 1) * CellSize) + Margin;
+			float MinY = BIG_NUMBER, MaxY = -BIG_NUMBER;
+			for (int32 IndexA = 0; IndexA < FootprintPoints.Num(); IndexA++)
+			{
+				for (int32 IndexB = IndexA; IndexB < FootprintPoints.Num(); IndexB++)
+				{
+					const FVector2D& A = FootprintPoints[IndexA];
+					const FVector2D Segment = FootprintPoints[IndexB] - A;
+					float TMin = 0.0f, TMax = 1.0f;
+					if (FMath::IsNearlyZero(Segment.X))
+					{
+						if (A.X < StripMinX || A.X > StripMaxX)
+							continue;
+					}
+					else
+					{
+						const float TA = (StripMinX - A.X) / Segment.X, TB = (StripMaxX - A.X) / Segment.X;
+						TMin = FMath::Max(TMin, FMath::Min(TA, TB));
+						TMax = FMath::Min(TMax, FMath::Max(TA, TB));
+						if (TMin > TMax)
+							continue;
+					}
+
+					MinY = FMath::Min3(MinY, A.Y + Segment.Y * TMin, A.Y + Segment.Y * TMax);
+					MaxY = FMath::Max3(MaxY, A.Y + Segment.Y * TMin, A.Y + Segment.Y * TMax);
+				}
+			}
+
+			const int32 FirstColumn = FMath::Max(FMath::FloorToInt((MinY - Margin - GridOrigin.Y) / CellSize), 0);
+			const int32 LastColumn = FMath::Min(FMath::CeilToInt((MaxY + Margin - GridOrigin.Y) / CellSize) - 1, NumCellColumns - 1);
+			if (FirstColumn > LastColumn)
+				continue;
+
+			MaskedCellColumns[Row] = FIntPoint(FirstColumn, LastColumn);
+			MaskedCellRows = FIntPoint(FMath::Min(MaskedCellRows.X, Row), FMath::Max(MaskedCellRows.Y, Row));
+
+			//A cell's vertices lie on its own row and the next one
+			for (int32 VertexRow = Row; VertexRow <= Row + 1; VertexRow++)
+			{
+				FIntPoint& VertexColumns = MaskedVertexColumns[VertexRow];
+				VertexColumns = VertexColumns.X > VertexColumns.Y ? FIntPoint(FirstColumn, LastColumn + 1) : FIntPoint(FMath::Min(VertexColumns.X, FirstColumn), FMath::Max(VertexColumns.Y, LastColumn + 1));
+			}
+		}
+
+		if (MaskedCellRows.X > MaskedCellRows.Y)
+		{
+			ClearFootprintMask();
+			return;
+		}
+
+		//A convex footprint covers a contiguous run of rows, fall back to the whole grid rather than read an unsampled row
+		for (int32 Row = MaskedCellRows.X; Row <= MaskedCellRows.Y; Row++)
+		{
+			if (MaskedCellColumns[Row].X > MaskedCellColumns[Row].Y)
+			{
+				ClearFootprintMask();
+				return;
+			}
+		}
+	}
+
+	/* Sample and read the whole grid again */
+	void ClearFootprintMask()
+	{
+		MaskedCellRows = FIntPoint(0, int32(GridSize.X) - 1);
+		MaskedCellColumns.Reset();
+		MaskedVertexColumns.Reset();
+	}
+
+	/* Returns true if only the cells inside a footprint are sampled */
+	bool IsFootprintMasked() const { return MaskedCellColumns.Num() > 0; }
+
+	/*
+	*	Get the columns of a row of vertices that are sampled
+	*	@param	Row - The row of vertices
+	*	@return	The first and last sampled column, the first is greater than the last if none are
+	*/
+	FIntPoint GetSampledVertexColumns(const int32 Row) const
+	{
+		return IsFootprintMasked() ? MaskedVertexColumns[Row] : FIntPoint(0, int32(GridSize.Y));
+	}
+
+	/*
+	*	Get the columns of a row of cells that are sampled
+	*	@param	Row - The row of cells
+	*	@return	The first and last sampled column, the first is greater than the last if none are
+	*/
+	FIntPoint GetSampledCellColumns(const int32 Row) const
+	{
+		return IsFootprintMasked() ? MaskedCellColumns[Row] : FIntPoint(0, int32(GridSize.Y) - 1);
+	}
+
+	/* Returns the number of vertices that are sampled */
+	int32 GetNumSampledVertices() const
+	{
+		if (!IsFootprintMasked())
+			return (int32(GridSize.X) + 1) * (int32(GridSize.Y) + 1);
+
+		int32 NumVertices = 0;
+		for (const FIntPoint& Columns : MaskedVertexColumns)
+			NumVertices += FMath::Max(Columns.Y - Columns.X + 1, 0);
+		return NumVertices;
+	}
+
 	/*
 	*	Get the depth on the grid given a point to project in world space
 	*	@param	WorldPoint - The point in world space to project onto the grid to find its depth
@@ -268,6 +409,11 @@ struct FWaterGrid //Data representing an approximated water surface in a grid sy
 		FVector LocalizedGridPoint = FVector(GridOrigin - WorldPoint).GetAbs();
 		int CellColumnIndex = FMath::Clamp(FMath::CeilToInt(LocalizedGridPoint.Y / CellSize) - 1, 0, int(GridSize.Y) - 1);
 		int CellRowIndex = FMath::Clamp(FMath::CeilToInt(LocalizedGridPoint.X / CellSize) - 1, 0, int(GridSize.X) - 1);
+		if (IsFootprintMasked()) //Never read a cell outside the mask, its vertices aren't sampled
+		{
+			CellRowIndex = FMath::Clamp(CellRowIndex, MaskedCellRows.X, MaskedCellRows.Y);
+			CellColumnIndex = FMath::Clamp(CellColumnIndex, MaskedCellColumns[CellRowIndex].X, MaskedCellColumns[CellRowIndex].Y);
+		}
 		FVector LocalizedCellPoint = FVector(LocalizedGridPoint.X - (CellRowIndex * CellSize), LocalizedGridPoint.Y - (CellColumnIndex * CellSize), 0.0f);
 		return Cells[CellRowIndex][CellColumnIndex].Triangles[Cells[CellRowIndex][CellColumnIndex].GetTriangleIndexForPoint(LocalizedCellPoint)].GetDepthAtPoint(WorldPoint);
 	}
@@ -584,6 +730,21 @@ struct FBuoyantTriangle //Data representing a triangle consisting of three verti
 		return VertsByHeight;
 	}
 
+	/*
+	*	Interpolate the depth of a point on this triangle from its vertices' depths, treating the water as planar across the triangle
+	*	@param Point - A point on the triangle
+	*	@return - The depth of the point
+	*/
+	float GetInterpolatedDepth(const FVector& Point) const
+	{
+		const FVector Normal = FVector::CrossProduct(Vertices[1].Vertex - Vertices[0].Vertex, Vertices[2].Vertex - Vertices[0].Vertex);
+		if (Normal.SizeSquared() <= SMALL_NUMBER) //Degenerate triangles have no barycentric coordinates
+			return (Vertices[0].Depth + Vertices[1].Depth + Vertices[2].Depth) / 3.0f;
+
+		const FVector Weights = FMath::ComputeBaryCentric2D(Point, Vertices[0].Vertex, Vertices[1].Vertex, Vertices[2].Vertex);
+		return (Weights.X * Vertices[0].Depth) + (Weights.Y * Vertices[1].Depth) + (Weights.Z * Vertices[2].Depth);
+	}
+
 	/*
 	* Returns the water direction "theta"
 	* @return - Returns the dot product between the normal and velocity normal
@@ -652,6 +813,39 @@ struct FBuoyantMeshData //Data representing a mesh consisting of vertices and tr
 		}
 	};
 
+	/*
+	*	Build the mesh data from water heights sampled directly at the hull's vertices instead of a water grid.
+	*	The water is treated as planar across each triangle, so a triangle's depth at its center is the mean of its vertices' depths.
+	*	@param	WorldVertices - The mesh's unique vertices transformed to world space
+	*	@param	WaterHeights - The water height sampled at each of the world vertices
+	*	@param	MeshIndices - The mesh's triangle indices into the unique vertices
+	*	@param	Transform - The mesh's world transform
+	*	@param	BodyInstance - The mesh's body instance
+	*/
+	FBuoyantMeshData(const TArray<FVector>& WorldVertices, const TArray<float>& WaterHeights, const TArray<int32>& MeshIndices, const FTransform& Transform, const FBodyInstance* BodyInstance)
+	{
+		SCOPE_CYCLE_COUNTER(STAT_VertexDepthFromSamples)
+		{
+			UniqueVertices.Reserve(WorldVertices.Num());
+			for (int32 VertIndex = 0; VertIndex < WorldVertices.Num(); VertIndex++)
+				UniqueVertices.Add(FBuoyantVertex(WorldVertices[VertIndex], WorldVertices[VertIndex].Z - WaterHeights[VertIndex]));
+		}
+
+		Vertices = MeshIndices;
+		SCOPE_CYCLE_COUNTER(STAT_BuoyantMeshDataTriangleCreation)
+		{
+			Triangles.Reserve(Vertices.Num() / 3);
+			for (int TriIndex = 0; TriIndex < Vertices.Num() / 3; TriIndex++)
+			{
+				const FBuoyantVertex& VertexOne = UniqueVertices[Vertices[TriIndex * 3]];
+				const FBuoyantVertex& VertexTwo = UniqueVertices[Vertices[TriIndex * 3 + 1]];
+				const FBuoyantVertex& VertexThree = UniqueVertices[Vertices[TriIndex * 3 + 2]];
+				const float CenterDepth = (VertexOne.Depth + VertexTwo.Depth + VertexThree.Depth) / 3.0f;
+				Triangles.Add(FBuoyantTriangle(VertexOne, VertexTwo, VertexThree, CenterDepth, BodyInstance, Transform.GetLocation()));
+			}
+		}
+	};
+
 	void Clear()
 	{
 		Vertices.Empty();
@@ -664,6 +858,133 @@ struct FBuoyantMeshData //Data representing a mesh consisting of vertices and tr
 	}
 };
 
+USTRUCT()
+struct FBuoyancyWrench //The net force and torque about the center of mass accumulated from a buoyancy evaluation
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+		FVector Force = FVector::ZeroVector; //The net force, applied at the center of mass
+	UPROPERTY()
+		FVector Torque = FVector::ZeroVector; //The net torque about the center of mass
+	UPROPERTY()
+		FVector CenterOfMass = FVector::ZeroVector; //The world space center of mass the torque is accumulated about
+
+	FBuoyancyWrench() {};
+	FBuoyancyWrench(FVector COM)
+	{
+		CenterOfMass = COM;
+	}
+
+	/*
+	*	Accumulate a force applied at a point, this is equivalent to FBodyInstance::AddForceAtPosition() 
+	*	but doesn't touch the body so it's safe to use from multiple threads for different wrenches.
+	*	@param InForce - The force to accumulate
+	*	@param Position - The world space position the force is applied at
+	*/
+	void AddForceAtPosition(const FVector& InForce, const FVector& Position)
+	{
+		Force += InForce;
+		Torque += FVector::CrossProduct(Position - CenterOfMass, InForce);
+	}
+
+	/*
+	*	Apply the accumulated force and torque to a body instance
+	*	@param BodyInstance - The body to apply the wrench to
+	*/
+	void ApplyToBody(FBodyInstance* BodyInstance) const
+	{
+		if (!Force.IsNearlyZero())
+			BodyInstance->AddForce(Force, false);
+
+		if (!Torque.IsNearlyZero())
+			BodyInstance->AddTorqueInRadians(Torque, false);
+	}
+
+	void Reset(FVector COM = FVector::ZeroVector)
+	{
+		Force = FVector::ZeroVector;
+		Torque = FVector::ZeroVector;
+		CenterOfMass = COM;
+	}
+};
+
+USTRUCT()
+struct FHydrostaticStiffness //A linearization of the hydrostatic force about an equilibrium pose, valid for small heave, roll and pitch offsets
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+		float HeaveStiffness = 0.0f; //Change in buoyant force per centimeter of immersion - pgA(wp)
+	UPROPERTY()
+		float RollStiffness = 0.0f; //Restoring torque per radian about the world X axis - pg(I(x) + V * BG)
+	UPROPERTY()
+		float PitchStiffness = 0.0f; //Restoring torque per radian about the world Y axis - pg(I(y) + V * BG)
+	UPROPERTY()
+		FVector CenterOfFlotation = FVector::ZeroVector; //The centroid of the waterplane, heave forces act through this point
+
+	FHydrostaticStiffness() {};
+
+	/*
+	*	Build the stiffness from the submerged triangles of an evaluation.
+	*	Each triangle's projection onto the waterplane and the water column above it are integrated,
+	*	triangles facing up subtract from the ones below them so the waterplane and displaced volume come out exact for any closed hull.
+	*	@param SubmergedTriangles - The cut submerged triangles of the evaluation, with their depths
+	*	@param CenterOfMass - The world space center of mass of the body
+	*	@param WeightDensity - Fluid density multiplied by gravity
+	*/
+	FHydrostaticStiffness(const TArray<FBuoyantTriangle>& SubmergedTriangles, const FVector& CenterOfMass, float WeightDensity)
+	{
+		float WaterplaneArea = 0.0f, DisplacedVolume = 0.0f, VolumeMomentZ = 0.0f;
+		FVector2D AreaMoment = FVector2D::ZeroVector;
+		for (const FBuoyantTriangle& Triangle : SubmergedTriangles)
+		{
+			const float ProjectedArea = -Triangle.OutwardNormal.Z * Triangle.Area;
+			const float ColumnHeight = FMath::Max(-Triangle.Depth, 0.0f);
+			WaterplaneArea += ProjectedArea;
+			AreaMoment += FVector2D(Triangle.Center) * ProjectedArea;
+			DisplacedVolume += ProjectedArea * ColumnHeight;
+			VolumeMomentZ += ProjectedArea * ColumnHeight * (Triangle.Center.Z + ColumnHeight * 0.5f);
+		}
+
+		if (WaterplaneArea <= KINDA_SMALL_NUMBER || DisplacedVolume <= KINDA_SMALL_NUMBER)
+			return;
+
+		const FVector2D Flotation = AreaMoment / WaterplaneArea;
+		float SecondMomentX = 0.0f, SecondMomentY = 0.0f;
+		for (const FBuoyantTriangle& Triangle : SubmergedTriangles)
+		{
+			const float ProjectedArea = -Triangle.OutwardNormal.Z * Triangle.Area;
+			SecondMomentX += ProjectedArea * FMath::Square(Triangle.Center.Y - Flotation.Y);
+			SecondMomentY += ProjectedArea * FMath::Square(Triangle.Center.X - Flotation.X);
+		}
+
+		//BG - the height of the center of buoyancy above the center of mass, negative for most ships
+		const float BuoyancyToGravity = (VolumeMomentZ / DisplacedVolume) - CenterOfMass.Z;
+		HeaveStiffness = WeightDensity * WaterplaneArea;
+		RollStiffness = WeightDensity * (SecondMomentX + DisplacedVolume * BuoyancyToGravity);
+		PitchStiffness = WeightDensity * (SecondMomentY + DisplacedVolume * BuoyancyToGravity);
+		CenterOfFlotation = FVector(Flotation, CenterOfMass.Z);
+	}
+
+	/*
+	*	Estimate the wrench of a pose offset from the equilibrium the stiffness was built at
+	*	@param Reference - The wrench evaluated at the equilibrium pose
+	*	@param Immersion - How far the body has sunk relative to the water since the equilibrium, in centimeters
+	*	@param Rotation - The body's rotation since the equilibrium as a world space axis * angle in radians
+	*	@param CenterOfMass - The current world space center of mass
+	*	@return The estimated wrench
+	*/
+	FBuoyancyWrench Evaluate(const FBuoyancyWrench& Reference, float Immersion, const FVector& Rotation, const FVector& CenterOfMass) const
+	{
+		FBuoyancyWrench Wrench = FBuoyancyWrench(CenterOfMass);
+		Wrench.Torque = Reference.Torque - FVector(RollStiffness * Rotation.X, PitchStiffness * Rotation.Y, 0.0f);
+		Wrench.Force = Reference.Force;
+		Wrench.AddForceAtPosition(FVector(0.0f, 0.0f, HeaveStiffness * Immersion), CenterOfFlotation + (CenterOfMass - Reference.CenterOfMass));
+		return Wrench;
+	}
+};
+
 //UPDATE_TASK: OPTIMIZATION_UPDATE - Pre-allocate memory
 USTRUCT()
 struct FBuoyancyFrameData //Buoyancy information for a mesh over a single frame
@@ -680,6 +1001,8 @@ struct FBuoyancyFrameData //Buoyancy information for a mesh over a single frame
 		FVector CumulativePressureDragForces = FVector::ZeroVector; //The cumulative hydrostatic force from all submerged triangles
 	UPROPERTY()
 		FVector CumulativeWaterEntryForces = FVector::ZeroVector; //The cumulative hydrostatic force from all submerged triangles
+	UPROPERTY()
+		FBuoyancyWrench Wrench; //The net force and torque of every force accumulated this frame
 	UPROPERTY()
 		FTransform BodyTransform = FTransform(); //Transform of the bodyinstance in this frame
 	UPROPERTY()
@@ -694,6 +1017,7 @@ struct FBuoyancyFrameData //Buoyancy information for a mesh over a single frame
 	void Clear()
 	{
 		BuoyantData.Clear();
+		Wrench.Reset();
 		DeltaTime = 0.0f;
 	}
 };
@@ -0,0 +1,372 @@
+/*=================================================
+* FileName: BuoyancyWorldSubsystem.cpp
+*
+* Created by: Sails of War contributors
+* Project name: Sails of War
+* Unreal Engine version: 4.22
+* Created on: 2026/10/18
+*
+* Last Edited on: 2026/10/18
+* Last Edited by: Sails of War contributors
+*
+* -------------------------------------------------
+* Created for: Sails Of War - http://sailsofwargame.com/
+* -------------------------------------------------
+* For parts referencing UE4 code, the following copyright applies:
+* Copyright 1998-2020 Epic Games, Inc. All Rights Reserved.
+*
+* Feel free to use this software in any commercial/free game.
+* Selling this as a plugin/item, in whole or part, is not allowed.
+* =================================================*/
+//Libary Includes:
+#include "BuoyancyWorldSubsystem.h"
+#include "NetworkedBuoyantPawnMovementComponent.h"
+#include "BuoyantMeshComponent.h"
+
+//IMPORT_TASK: Change to Engine variants
+//Project Includes:
+#include "SOWGameplayStatics.h"
+#include "SOWOceanActor.h"
+#include "SOWGameState.h"
+
+//Engine Includes:
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "Engine/Engine.h"
+#include "Async/ParallelFor.h"
+
+DECLARE_CYCLE_STAT(TEXT("BatchPhysicsSubstep"), STAT_BatchSubstep, STATGROUP_BuoyancyWorld);
+DECLARE_CYCLE_STAT(TEXT("BatchBegin"), STAT_BatchBegin, STATGROUP_BuoyancyWorld);
+DECLARE_CYCLE_STAT(TEXT("BatchSampleWater"), STAT_BatchSampleWater, STATGROUP_BuoyancyWorld);
+DECLARE_CYCLE_STAT(TEXT("BatchEvaluate"), STAT_BatchEvaluate, STATGROUP_BuoyancyWorld);
+DECLARE_CYCLE_STAT(TEXT("BatchApply"), STAT_BatchApply, STATGROUP_BuoyancyWorld);
+DECLARE_CYCLE_STAT(TEXT("ScheduleBatch"), STAT_ScheduleBatch, STATGROUP_BuoyancyWorld);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Batched Bodies"), STAT_BatchedBodies, STATGROUP_BuoyancyWorld);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Held Bodies"), STAT_HeldBodies, STATGROUP_BuoyancyWorld);
+DECLARE_DWORD_COUNTER_STAT(TEXT("High Priority Evaluated"), STAT_HighPriorityEvaluated, STATGROUP_BuoyancyWorld);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Medium Priority Evaluated"), STAT_MediumPriorityEvaluated, STATGROUP_BuoyancyWorld);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Low Priority Evaluated"), STAT_LowPriorityEvaluated, STATGROUP_BuoyancyWorld);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Estimated Evaluation Cost (ms)"), STAT_EstimatedEvaluationMs, STATGROUP_BuoyancyWorld);
+
+void UBuoyancyWorldSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	OnCalculateBatchPhysics.BindUObject(this, &UBuoyancyWorldSubsystem::BatchPhysicsSubstep);
+}
+
+void UBuoyancyWorldSubsystem::Deinitialize()
+{
+	OnCalculateBatchPhysics.Unbind();
+	RegisteredBodies.Empty();
+	PendingBatch.Empty();
+	Super::Deinitialize();
+}
+
+UBuoyancyWorldSubsystem* UBuoyancyWorldSubsystem::Get(const UObject* WorldContextObject)
+{
+	UWorld* World = GEngine ? GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::ReturnNull) : nullptr;
+	return World ? World->GetSubsystem<UBuoyancyWorldSubsystem>() : nullptr;
+}
+
+void UBuoyancyWorldSubsystem::RegisterBuoyantBody(UNetworkedBuoyantPawnMovementComponent* Component)
+{
+	if (Component != nullptr)
+		RegisteredBodies.AddUnique(Component);
+}
+
+void UBuoyancyWorldSubsystem::UnregisterBuoyantBody(UNetworkedBuoyantPawnMovementComponent* Component)
+{
+	RegisteredBodies.Remove(Component);
+	FramesSinceEvaluation.Remove(Component);
+	PendingBatch.RemoveAll([Component](const FBuoyancyBatchEntry& Entry) { return Entry.Component == Component; });
+}
+
+bool UBuoyancyWorldSubsystem::RequestSubstep(UNetworkedBuoyantPawnMovementComponent* Component)
+{
+	return AddBatchEntry(Component) != nullptr;
+}
+
+bool UBuoyancyWorldSubsystem::RequestScheduledSubstep(UNetworkedBuoyantPawnMovementComponent* Component)
+{
+	FBuoyancyBatchEntry* Entry = AddBatchEntry(Component);
+	if (Entry == nullptr)
+		return false;
+
+	Entry->bScheduled = true;
+	Entry->Tier = GetPriorityTier(Component->GetOwner()->GetActorLocation());
+	return true;
+}
+
+FBuoyancyBatchEntry* UBuoyancyWorldSubsystem::AddBatchEntry(UNetworkedBuoyantPawnMovementComponent* Component)
+{
+	if (!bEnableBatching || Component == nullptr || !RegisteredBodies.Contains(Component) || Component->BuoyantMesh == nullptr)
+		return nullptr;
+
+	FBodyInstance* BodyInstance = Component->BuoyantMesh->GetBodyInstance();
+	if (BodyInstance == nullptr || !BodyInstance->IsValidBodyInstance())
+		return nullptr;
+
+	//Custom physics only lasts a single frame, the first request of a frame starts a new batch and carries its callback
+	if (PendingBatchFrame != GFrameCounter)
+	{
+		PendingBatchFrame = GFrameCounter;
+		PendingBatch.Reset();
+		BodyInstance->AddCustomPhysics(OnCalculateBatchPhysics);
+
+		//IMPORT_TASK: Change to AGameState instead
+		OceanActor = USOWGameplayStatics::GetOceanActor(GetWorld());
+		ASOWGameState* SOWGS = GetWorld()->GetGameState<ASOWGameState>();
+		PendingBatchOceanTime = SOWGS ? SOWGS->GetServerWorldTimeSeconds() : GetWorld()->GetTimeSeconds();
+	}
+
+	FBuoyancyBatchEntry NewEntry = FBuoyancyBatchEntry(Component, BodyInstance);
+	NewEntry.bEvaluateOnCallingThread = Component->WantsSubstepDebugDraw();
+	const int32 EntryIndex = PendingBatch.Add(NewEntry);
+	return &PendingBatch[EntryIndex];
+}
+
+EBuoyancyPriorityTier UBuoyancyWorldSubsystem::GetPriorityTier(const FVector& Location) const
+{
+	float ClosestDistanceSquared = MAX_FLT;
+	for (FConstPlayerControllerIterator Iterator = GetWorld()->GetPlayerControllerIterator(); Iterator; ++Iterator)
+	{
+		const APlayerController* PlayerController = Iterator->Get();
+		if (PlayerController)
+			ClosestDistanceSquared = FMath::Min(ClosestDistanceSquared, FVector::DistSquared(PlayerController->GetFocalLocation(), Location));
+	}
+
+	if (ClosestDistanceSquared <= FMath::Square(SchedulerSettings.HighPriorityDistance))
+		return EBuoyancyPriorityTier::High;
+	if (ClosestDistanceSquared <= FMath::Square(SchedulerSettings.MediumPriorityDistance))
+		return EBuoyancyPriorityTier::Medium;
+
+	return EBuoyancyPriorityTier::Low;
+}
+
+void UBuoyancyWorldSubsystem::ScheduleBatch()
+{
+	SCOPE_CYCLE_COUNTER(STAT_ScheduleBatch);
+
+	//Refine the per body cost from what the last frame's evaluations actually took
+	if (FrameEvaluationCount > 0)
+		AverageEvaluationMs = FMath::Lerp(AverageEvaluationMs, FrameEvaluationMs / FrameEvaluationCount, 0.1f);
+	FrameEvaluationMs = 0.0f;
+	FrameEvaluationCount = 0;
+	SET_FLOAT_STAT(STAT_EstimatedEvaluationMs, AverageEvaluationMs);
+
+	for (FBuoyancyTierStats& Stats : TierStats)
+	{
+		Stats.NumBodies = 0;
+		Stats.NumEvaluated = 0;
+	}
+
+	float RemainingBudgetMs = SchedulerSettings.FrameBudgetMs;
+	TArray<int32, TInlineAllocator<64>> Candidates;
+	for (int32 EntryIndex = 0; EntryIndex < PendingBatch.Num(); EntryIndex++)
+	{
+		FBuoyancyBatchEntry& Entry = PendingBatch[EntryIndex];
+		if (!Entry.bScheduled)
+			continue;
+
+		int32& FramesSince = FramesSinceEvaluation.FindOrAdd(Entry.Component);
+		FramesSince++;
+		TierStats[(uint8)Entry.Tier].NumBodies++;
+
+		//There's nothing to hold until a body has been evaluated once
+		if (Entry.Tier == EBuoyancyPriorityTier::High || !Entry.Component->HasEvaluatedBuoyancy())
+		{
+			RemainingBudgetMs -= AverageEvaluationMs;
+			continue;
+		}
+
+		const int32 FrameInterval = Entry.Tier == EBuoyancyPriorityTier::Medium ? SchedulerSettings.MediumPriorityFrameInterval : SchedulerSettings.LowPriorityFrameInterval;
+		Entry.bHoldForces = true;
+		if (FramesSince >= FrameInterval)
+			Candidates.Add(EntryIndex);
+	}
+
+	//Spend what's left of the budget on the most important, most stale bodies first
+	Candidates.Sort([this](int32 A, int32 B)
+	{
+		const FBuoyancyBatchEntry& EntryA = PendingBatch[A];
+		const FBuoyancyBatchEntry& EntryB = PendingBatch[B];
+		if (EntryA.Tier != EntryB.Tier)
+			return EntryA.Tier < EntryB.Tier;
+
+		return FramesSinceEvaluation.FindRef(EntryA.Component) > FramesSinceEvaluation.FindRef(EntryB.Component);
+	});
+
+	for (int32 EntryIndex : Candidates)
+	{
+		if (RemainingBudgetMs < AverageEvaluationMs)
+			break;
+
+		PendingBatch[EntryIndex].bHoldForces = false;
+		RemainingBudgetMs -= AverageEvaluationMs;
+	}
+
+	int32 NumHeld = 0;
+	for (const FBuoyancyBatchEntry& Entry : PendingBatch)
+	{
+		if (!Entry.bScheduled)
+			continue;
+
+		FBuoyancyTierStats& Stats = TierStats[(uint8)Entry.Tier];
+		Stats.TotalScheduled++;
+		if (Entry.bHoldForces)
+		{
+			NumHeld++;
+			continue;
+		}
+
+		FramesSinceEvaluation.FindOrAdd(Entry.Component) = 0;
+		Stats.NumEvaluated++;
+		Stats.TotalEvaluated++;
+	}
+
+	SET_DWORD_STAT(STAT_HeldBodies, NumHeld);
+	SET_DWORD_STAT(STAT_HighPriorityEvaluated, TierStats[(uint8)EBuoyancyPriorityTier::High].NumEvaluated);
+	SET_DWORD_STAT(STAT_MediumPriorityEvaluated, TierStats[(uint8)EBuoyancyPriorityTier::Medium].NumEvaluated);
+	SET_DWORD_STAT(STAT_LowPriorityEvaluated, TierStats[(uint8)EBuoyancyPriorityTier::Low].NumEvaluated);
+}
+
+FBuoyancyTierStats UBuoyancyWorldSubsystem::GetTierStats(EBuoyancyPriorityTier Tier) const
+{
+	return Tier < EBuoyancyPriorityTier::MAX ? TierStats[(uint8)Tier] : FBuoyancyTierStats();
+}
+
+void UBuoyancyWorldSubsystem::ResetTierStats()
+{
+	for (FBuoyancyTierStats& Stats : TierStats)
+	{
+		Stats = FBuoyancyTierStats();
+	}
+}
+
+void UBuoyancyWorldSubsystem::BatchPhysicsSubstep(float DeltaSubstepTime, FBodyInstance* LeadBodyInstance)
+{
+	SCOPE_CYCLE_COUNTER(STAT_BatchSubstep);
+	SET_DWORD_STAT(STAT_BatchedBodies, PendingBatch.Num());
+
+	//Scheduling decisions hold for every sub-step of the frame
+	if (ScheduledBatchFrame != PendingBatchFrame)
+	{
+		ScheduledBatchFrame = PendingBatchFrame;
+		ScheduleBatch();
+	}
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_BatchBegin);
+		WaterHeightCache.BeginTimeStep(OceanActor, PendingBatchOceanTime);
+		for (FBuoyancyBatchEntry& Entry : PendingBatch)
+		{
+			Entry.bSkipEvaluation = !Entry.bHoldForces && !Entry.Component->ShouldEvaluateBuoyancy(DeltaSubstepTime, Entry.BodyInstance);
+			if (Entry.ShouldHoldForces())
+				continue;
+
+			Entry.Component->BeginBuoyancySubstep(DeltaSubstepTime, Entry.BodyInstance, &WaterHeightCache);
+			if (Entry.Component->UsesDirectWaterSampling()) //Samples its own hull vertices, its grid isn't read
+				continue;
+
+			WaterHeightCache.RequestGridTiles(Entry.Component->WaterGrid);
+		}
+	}
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_BatchSampleWater);
+		WaterHeightCache.SampleRequestedTiles(bEvaluateInParallel);
+	}
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_BatchEvaluate);
+		const double EvaluateStartTime = FPlatformTime::Seconds();
+		const FWaterHeightTileCache* SharedCache = &WaterHeightCache;
+		//Bodies that draw debug visuals while evaluating stay on this thread, the line batcher isn't thread safe.
+		//Grids that missed the cache are left to this thread as well, workers only read what the batch sampled.
+		ParallelFor(PendingBatch.Num(), [this, DeltaSubstepTime, SharedCache](int32 EntryIndex)
+		{
+			FBuoyancyBatchEntry& Entry = PendingBatch[EntryIndex];
+			Entry.bMissedWaterCache = false;
+			Entry.EvaluationMs = 0.0f;
+			if (!Entry.bEvaluateOnCallingThread && !Entry.ShouldHoldForces())
+			{
+				const double StartTime = FPlatformTime::Seconds();
+				Entry.bMissedWaterCache = !Entry.Component->EvaluateBuoyancySubstep(DeltaSubstepTime, Entry.BodyInstance, SharedCache, false);
+				Entry.EvaluationMs = float((FPlatformTime::Seconds() - StartTime) * 1000.0);
+			}
+		}, !bEvaluateInParallel);
+
+		for (FBuoyancyBatchEntry& Entry : PendingBatch)
+		{
+			if (Entry.ShouldHoldForces() || !(Entry.bEvaluateOnCallingThread || Entry.bMissedWaterCache))
+				continue;
+
+			const double StartTime = FPlatformTime::Seconds();
+			Entry.Component->EvaluateBuoyancySubstep(DeltaSubstepTime, Entry.BodyInstance, SharedCache);
+			Entry.EvaluationMs += float((FPlatformTime::Seconds() - StartTime) * 1000.0);
+		}
+
+		//Only the scheduler's own bodies are charged to its budget, client and proxy bodies evaluated alongside them aren't
+		double TotalMs = 0.0, ScheduledMs = 0.0;
+		int32 NumScheduledEvaluated = 0;
+		for (const FBuoyancyBatchEntry& Entry : PendingBatch)
+		{
+			if (Entry.ShouldHoldForces())
+				continue;
+
+			TotalMs += Entry.EvaluationMs;
+			if (Entry.bScheduled)
+			{
+				ScheduledMs += Entry.EvaluationMs;
+				NumScheduledEvaluated++;
+			}
+		}
+
+		//The budget is in wall time, so the phase's wall time is split by each body's share of the work - parallel evaluation lowers the cost of each body
+		const double WallMs = (FPlatformTime::Seconds() - EvaluateStartTime) * 1000.0;
+		if (TotalMs > 0.0)
+			FrameEvaluationMs += float(WallMs * (ScheduledMs / TotalMs));
+		FrameEvaluationCount = FMath::Max(FrameEvaluationCount, NumScheduledEvaluated);
+	}
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_BatchApply);
+		for (const FBuoyancyBatchEntry& Entry : PendingBatch)
+		{
+			if (Entry.bHoldForces)
+				Entry.Component->ApplyHeldBuoyancySubstep(DeltaSubstepTime, Entry.BodyInstance, SchedulerSettings.HoldMode);
+			else if (Entry.bSkipEvaluation)
+				Entry.Component->ApplyHeldBuoyancySubstep(DeltaSubstepTime, Entry.BodyInstance, Entry.Component->GetEvaluationHoldMode());
+			else
+				Entry.Component->ApplyBuoyancySubstep(DeltaSubstepTime, Entry.BodyInstance);
+		}
+	}
+}
+
+float UBuoyancyWorldSubsystem::GetWaterHeightAtLocation(const FVector& Location) const
+{
+	float WaterHeight = 0.0f;
+	TryGetWaterHeightAtLocation(Location, WaterHeight);
+	return WaterHeight;
+}
+
+bool UBuoyancyWorldSubsystem::TryGetWaterHeightAtLocation(const FVector& Location, float& OutHeight) const
+{
+	//Nothing has been batched yet so there's no ocean or time to share, sample it directly
+	if (WaterHeightCache.GetTimeStep() == 0)
+	{
+		ASOWOceanActor* WorldOceanActor = USOWGameplayStatics::GetOceanActor(GetWorld());
+		ASOWGameState* SOWGS = GetWorld()->GetGameState<ASOWGameState>();
+		if (WorldOceanActor == nullptr || SOWGS == nullptr)
+			return false;
+
+		OutHeight = FWaterHeightTileCache::SampleOceanHeight(WorldOceanActor, Location, HeightQueryCellSize, SOWGS->GetServerWorldTimeSeconds());
+		return true;
+	}
+
+	if (WaterHeightCache.GetOceanActor() == nullptr)
+		return false;
+
+	OutHeight = WaterHeightCache.GetWaterHeightAtLocation(Location, HeightQueryCellSize);
+	return true;
+}
@@ -0,0 +1,280 @@
+/*=================================================
+* FileName: BuoyancyWorldSubsystem.h
+*
+* Created by: Sails of War contributors
+* Project name: Sails of War
+* Unreal Engine version: 4.22
+* Created on: 2026/10/18
+*
+* Last Edited on: 2026/10/18
+* Last Edited by: Sails of War contributors
+*
+* -------------------------------------------------
+* Created for: Sails Of War - http://sailsofwargame.com/
+* -------------------------------------------------
+* For parts referencing UE4 code, the following copyright applies:
+* Copyright 1998-2020 Epic Games, Inc. All Rights Reserved.
+*
+* Feel free to use this software in any commercial/free game.
+* Selling this as a plugin/item, in whole or part, is not allowed.
+* =================================================*/
+#pragma once
+
+//Libary Includes:
+#include "WaterHeightTileCache.h"
+#include "NetworkedBuoyantPawnMovementComponent.h"
+
+//Engine Includes:
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "PhysicsEngine/BodyInstance.h"
+
+#include "BuoyancyWorldSubsystem.generated.h"
+
+DECLARE_STATS_GROUP(TEXT("BuoyancyWorldSubsystem - Batched Buoyancy"), STATGROUP_BuoyancyWorld, STATCAT_Advanced);
+
+//Scheduling priority of a server owned body, derived from its distance to the closest player
+UENUM(BlueprintType)
+enum class EBuoyancyPriorityTier : uint8
+{
+	High,	//Evaluated every frame regardless of the budget
+	Medium,	//Evaluated every MediumPriorityFrameInterval frames while the budget allows
+	Low,	//Evaluated every LowPriorityFrameInterval frames while the budget allows
+	MAX UMETA(Hidden)
+};
+
+//Settings for time-slicing server owned bodies (AI and unpossessed ships)
+USTRUCT(BlueprintType)
+struct FBuoyancySchedulerSettings
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere)
+		float FrameBudgetMs = 2.0f; //Milliseconds per frame server owned bodies may spend evaluating buoyancy, high priority bodies are always evaluated
+
+	UPROPERTY(EditAnywhere)
+		float HighPriorityDistance = 15000.0f; //Bodies closer than this to any player are high priority
+
+	UPROPERTY(EditAnywhere)
+		float MediumPriorityDistance = 50000.0f; //Bodies closer than this to any player are medium priority, the rest are low
+
+	UPROPERTY(EditAnywhere)
+		int32 MediumPriorityFrameInterval = 2; //Minimum frames between evaluations of medium priority bodies
+
+	UPROPERTY(EditAnywhere)
+		int32 LowPriorityFrameInterval = 6; //Minimum frames between evaluations of low priority bodies
+
+	UPROPERTY(EditAnywhere)
+		EBuoyancyForceHoldMode HoldMode = EBuoyancyForceHoldMode::Hold; //How forces are estimated for frames a body isn't evaluated
+
+	FBuoyancySchedulerSettings() {};
+};
+
+//How often the bodies of a priority tier were actually evaluated
+USTRUCT(BlueprintType)
+struct FBuoyancyTierStats
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly)
+		int32 NumBodies = 0; //Bodies in the tier during the last scheduled frame
+
+	UPROPERTY(BlueprintReadOnly)
+		int32 NumEvaluated = 0; //Bodies of the tier evaluated during the last scheduled frame
+
+	UPROPERTY(BlueprintReadOnly)
+		int32 TotalScheduled = 0; //Frames bodies of this tier requested a sub-step since the stats were reset
+
+	UPROPERTY(BlueprintReadOnly)
+		int32 TotalEvaluated = 0; //Frames bodies of this tier were evaluated since the stats were reset
+
+	/* The fraction of requested frames that were evaluated, 1 means the tier was never time-sliced */
+	float GetUpdateFraction() const { return TotalScheduled > 0 ? float(TotalEvaluated) / float(TotalScheduled) : 1.0f; }
+
+	FBuoyancyTierStats() {};
+};
+
+//A single body taking part in this sub-step's batch
+struct FBuoyancyBatchEntry
+{
+	UNetworkedBuoyantPawnMovementComponent* Component = nullptr;
+	FBodyInstance* BodyInstance = nullptr;
+	bool bEvaluateOnCallingThread = false; //Set for bodies that draw debug visuals during their evaluation
+	bool bScheduled = false; //Server owned bodies are time-sliced by the scheduler
+	bool bHoldForces = false; //Set by the scheduler for bodies skipping evaluation this frame
+	bool bSkipEvaluation = false; //Set every sub-step for bodies whose decoupled evaluation rate skips it
+	bool bMissedWaterCache = false; //Set when the body's grid wasn't in the shared cache, it's evaluated on the calling thread instead of a worker
+	float EvaluationMs = 0.0f; //Time the body's evaluation took this sub-step, on whichever threads ran it
+	EBuoyancyPriorityTier Tier = EBuoyancyPriorityTier::High;
+
+	/* Returns true if the body reuses its last evaluations this sub-step */
+	bool ShouldHoldForces() const { return bHoldForces || bSkipEvaluation; }
+
+	FBuoyancyBatchEntry() {};
+	FBuoyancyBatchEntry(UNetworkedBuoyantPawnMovementComponent* InComponent, FBodyInstance* InBodyInstance) :
+		Component(InComponent), BodyInstance(InBodyInstance) {}
+};
+
+/*
+* Registers every buoyant body in the world and runs their sub-steps as a single batch.
+* Each frame the first body requesting a sub-step becomes the "lead" body and carries the batch's custom physics callback.
+* Every sub-step of the batch is split into phases:
+*	1. Begin - serial, caches transforms and centers of mass and requests the water tiles under each grid
+*	2. Sample - parallel, samples every unique water tile once into the shared FWaterHeightTileCache
+*	3. Evaluate - parallel, reads the grids from the cache and evaluates hull forces into each body's wrench, grids missing from the cache are evaluated serially after
+*	4. Apply - serial, applies each body's wrench and custom movement
+* Server owned bodies are time-sliced against a per frame budget, bodies skipping a frame hold or extrapolate their last forces.
+*/
+UCLASS(Config = Game)
+class SAILSOFWAR_API UBuoyancyWorldSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/**
+	*	Find the buoyancy subsystem for a world context object
+	*	@param	WorldContextObject - Any object living in the world
+	*	@return	UBuoyancyWorldSubsystem* - the subsystem, nullptr if the object has no world
+	*/
+	static UBuoyancyWorldSubsystem* Get(const UObject* WorldContextObject);
+
+	/**
+	*	Register a movement component so it can take part in batched sub-steps
+	*	@param	Component - the component to register
+	*/
+	void RegisterBuoyantBody(UNetworkedBuoyantPawnMovementComponent* Component);
+
+	/**
+	*	Remove a movement component from the batch
+	*	@param	Component - the component to unregister
+	*/
+	void UnregisterBuoyantBody(UNetworkedBuoyantPawnMovementComponent* Component);
+
+	/**
+	*	Request a buoyancy sub-step for this frame, must be called every frame the body should simulate - like FBodyInstance::AddCustomPhysics()
+	*	@param	Component - the registered component to simulate this frame
+	*	@return	bool - false if the component isn't registered or has no body, the caller should fall back to its own custom physics
+	*/
+	bool RequestSubstep(UNetworkedBuoyantPawnMovementComponent* Component);
+
+	/**
+	*	Request a time-sliced buoyancy sub-step for a server owned body this frame, the scheduler decides whether it's evaluated
+	*	@param	Component - the registered component to simulate this frame
+	*	@return	bool - false if the component couldn't join the batch, the caller should fall back to its own custom physics
+	*/
+	bool RequestScheduledSubstep(UNetworkedBuoyantPawnMovementComponent* Component);
+
+	/**
+	*	Get how often the server owned bodies of a priority tier were evaluated
+	*	@param	Tier - the tier to get the stats of
+	*	@return	FBuoyancyTierStats - the tier's stats
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Buoyancy")
+		FBuoyancyTierStats GetTierStats(EBuoyancyPriorityTier Tier) const;
+
+	/**
+	*	Reset the cumulative scheduler stats of every tier
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Buoyancy")
+		void ResetTierStats();
+
+	/**
+	*	Returns true if bodies should be simulated through the batch rather than their own custom physics delegate
+	*/
+	bool IsBatchingEnabled() const { return bEnableBatching; }
+
+	/**
+	*	Returns the number of registered buoyant bodies
+	*/
+	int32 GetNumRegisteredBodies() const { return RegisteredBodies.Num(); }
+
+	/**
+	*	Get the water height at a location, shares the samples taken by the buoyant bodies this sub-step when possible
+	*	@param	Location - the world space location to find the height at
+	*	@return	float - the water height in world space
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Buoyancy")
+		float GetWaterHeightAtLocation(const FVector& Location) const;
+
+	/**
+	*	Get the water height at a location, telling a world without an ocean apart from water at height 0
+	*	@param	Location - the world space location to find the height at
+	*	@param	OutHeight - the water height in world space, untouched if there's no ocean
+	*	@return	bool - false if there's no ocean to sample
+	*/
+	bool TryGetWaterHeightAtLocation(const FVector& Location, float& OutHeight) const;
+
+	/**
+	*	Returns the shared water height cache
+	*/
+	const FWaterHeightTileCache& GetWaterHeightCache() const { return WaterHeightCache; }
+
+protected:
+	/**
+	*	The batch's custom physics callback, executed once per sub-step on the lead body
+	*	@param	DeltaSubstepTime - The delta time for the sub frame
+	*	@param	LeadBodyInstance - The body the callback was registered on
+	*/
+	void BatchPhysicsSubstep(float DeltaSubstepTime, FBodyInstance* LeadBodyInstance);
+
+	/**
+	*	Add a body to this frame's batch, starting a new batch on the first request of a frame
+	*	@return	FBuoyancyBatchEntry* - the new entry, nullptr if the body can't be batched
+	*/
+	FBuoyancyBatchEntry* AddBatchEntry(UNetworkedBuoyantPawnMovementComponent* Component);
+
+	/**
+	*	Decide which scheduled bodies are evaluated this frame, run on the first sub-step of every frame
+	*/
+	void ScheduleBatch();
+
+	/**
+	*	Find the priority tier of a location from its distance to the closest player
+	*/
+	EBuoyancyPriorityTier GetPriorityTier(const FVector& Location) const;
+
+	UPROPERTY(Config)
+		bool bEnableBatching = true; //Disable to let every pawn sub-step through its own custom physics delegate
+
+	UPROPERTY(Config)
+		bool bEvaluateInParallel = true; //Disable to evaluate the batch on a single thread, useful for debugging
+
+	UPROPERTY(Config)
+		FBuoyancySchedulerSettings SchedulerSettings; //Time-slicing of server owned bodies
+
+	UPROPERTY(Config)
+		float HeightQueryCellSize = 400.0f; //The vertex spacing used for gameplay height queries, matches the default WaterGridCellSize so they share tiles with fixed size grids
+
+	FWaterHeightTileCache WaterHeightCache; //World aligned water heights shared by every grid and height query for the current sub-step
+
+	UPROPERTY()
+		class ASOWOceanActor* OceanActor = nullptr; //The ocean sampled by the batch, found on the game thread
+
+	float PendingBatchOceanTime = 0.0f; //The ocean time this frame's batch samples at, read on the game thread
+
+	UPROPERTY()
+		TArray<UNetworkedBuoyantPawnMovementComponent*> RegisteredBodies; //Every buoyant body in the world
+
+	TArray<FBuoyancyBatchEntry> PendingBatch; //The bodies requesting a sub-step this frame
+
+	uint64 PendingBatchFrame = 0; //The frame PendingBatch was built for
+
+	uint64 ScheduledBatchFrame = 0; //The last frame ScheduleBatch() ran for
+
+	TMap<UNetworkedBuoyantPawnMovementComponent*, int32> FramesSinceEvaluation; //Frames since each scheduled body was last evaluated
+
+	float AverageEvaluationMs = 0.1f; //Running estimate of the wall time one scheduled body's evaluation costs per frame
+
+	float FrameEvaluationMs = 0.0f; //Wall time spent evaluating scheduled bodies during the current frame
+
+	int32 FrameEvaluationCount = 0; //Scheduled bodies evaluated during the current frame
+
+	FBuoyancyTierStats TierStats[(uint8)EBuoyancyPriorityTier::MAX];
+
+	FCalculateCustomPhysics OnCalculateBatchPhysics; //Bound to BatchPhysicsSubstep() and added to the lead body every frame
+
+/*UWorldSubsystem Overrides*/
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+};
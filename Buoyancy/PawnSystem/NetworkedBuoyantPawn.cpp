@@ -3,7 +3,7 @@
 *
 * Created by: Tobias Moos
 * Project name: Sails of War
-* Unreal Engine version: 4.19
+* Unreal Engine version: 4.22
 * Created on: 2020/01/08
 *
 * Last Edited on: 2021/05/03
@@ -23,6 +23,8 @@
 #include "BuoyantMeshComponent.h"
 #include "NetworkedBuoyantPawnMovementComponent.h"
 #include "PhysicsMovementReplication.h"
+#include "BuoyancyWorldSubsystem.h"
+#include "ShipReplicationSubsystem.h"
 
 //IMPORT_TASK: Change to Engine variants
 //UPDATE_TASK: Provide the ability to override them in the constructor with custom classes 
@@ -40,8 +42,17 @@
 #include "DrawDebugHelpers.h"
 #include "Engine/Engine.h"
 #include "UnrealNetwork.h"
+#include "Engine/NetConnection.h"
 #include "Kismet/KismetSystemLibrary.h"
-#include "Kismet/KismetMathLibrary.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Proxy Snaps"), STAT_ProxySnaps, STATGROUP_PhysicsReplication);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Proxy Velocity Corrections"), STAT_ProxyCorrections, STATGROUP_PhysicsReplication);
+DECLARE_CYCLE_STAT(TEXT("ValidateSnapshot"), STAT_ValidateSnapshot, STATGROUP_PhysicsReplication);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Rejected Client Snapshots"), STAT_RejectedSnapshots, STATGROUP_PhysicsReplication);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Client Corrections Sent"), STAT_ClientCorrections, STATGROUP_PhysicsReplication);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Stale Client Snapshots"), STAT_StaleSnapshots, STATGROUP_PhysicsReplication);
+DECLARE_CYCLE_STAT(TEXT("ResolveShipCollision"), STAT_ResolveShipCollision, STATGROUP_PhysicsReplication);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Rewound Ship Collisions"), STAT_RewoundCollisions, STATGROUP_PhysicsReplication);
 
 #define PrintWarning(Text) if(GEngine) GEngine->AddOnScreenDebugMessage(-1, 10, FColor::Red, Text)
 #define PrintMessage(Text) if(GEngine) GEngine->AddOnScreenDebugMessage(-1, 10, FColor::Green, Text)
@@ -59,13 +70,14 @@ ANetworkedBuoyantPawn::ANetworkedBuoyantPawn(const FObjectInitializer& ObjectIni
 	RootComponent = BuoyantMeshComponent;
 	BuoyantMeshComponent->BodyInstance.bSimulatePhysics = true;
 	BuoyantMeshComponent->bAlwaysCreatePhysicsState = true;
+	BuoyantMeshComponent->BodyInstance.bNotifyRigidBodyCollision = true; //The server resolves ship on ship hits, see NotifyHit()
 	BuoyantMovementComponent = CreateDefaultSubobject<UNetworkedBuoyantPawnMovementComponent>(ANetworkedBuoyantPawn::BuoyantMovementComponentName);
 	BuoyantMovementComponent->UpdatedComponent = BuoyantMeshComponent;
 	OnCalculateCustomPhysics.BindUObject(BuoyantMovementComponent, &UNetworkedBuoyantPawnMovementComponent::PhysicsSubstep);
 	
 	PrimaryActorTick.bTickEvenWhenPaused = true;
 	PrimaryActorTick.bStartWithTickEnabled = true;
-	bAlwaysRelevant = true;
+	bAlwaysRelevant = true; //Every client needs the ship to resolve it in the snapshot bunches, the replication subsystem's interest grid thins far ships' snapshots instead
 	bReplicates = true;
 	bReplicateMovement = false; //We don't utilize the built in movement replication system
 	PhysicsReplicationData.AuthMovementReplication = FPhysicsMovementReplication_ClientAuth();
@@ -89,10 +101,28 @@ void ANetworkedBuoyantPawn::Tick(float DeltaTime)
 		BPDrawDebug(DeltaTime);
 	}
 
-	if (IsLocallyControlled())
+	if (IsLocallyControlled() && !IsServerOwned())
 	{
-		GetRootBodyInstance()->AddCustomPhysics(OnCalculateCustomPhysics);
+		//Simulate through the world's batch when possible, otherwise sub-step on our own
+		UBuoyancyWorldSubsystem* BuoyancySubsystem = UBuoyancyWorldSubsystem::Get(this);
+		if (BuoyancySubsystem == nullptr || !BuoyancySubsystem->RequestSubstep(BuoyantMovementComponent))
+			GetRootBodyInstance()->AddCustomPhysics(OnCalculateCustomPhysics);
+
 		ClientUpdateMovement(DeltaTime);
+
+		//A listen server's own ship is simulated here like the server owned ones, collisions with it rewind through its history too
+		if (Role == ROLE_Authority)
+			RecordServerPose(DeltaTime);
+	}
+	else if (IsServerOwned())
+	{
+		//AI and unpossessed ships share the server's buoyancy budget and may be time-sliced
+		UBuoyancyWorldSubsystem* BuoyancySubsystem = UBuoyancyWorldSubsystem::Get(this);
+		if (BuoyancySubsystem == nullptr || !BuoyancySubsystem->RequestScheduledSubstep(BuoyantMovementComponent))
+			GetRootBodyInstance()->AddCustomPhysics(OnCalculateCustomPhysics);
+
+		ClientUpdateMovement(DeltaTime);
+		RecordServerPose(DeltaTime);
 	}
 	else if(Role == ROLE_Authority)
 		ServerSimulateMovement(DeltaTime);
@@ -130,15 +160,22 @@ void ANetworkedBuoyantPawn::PostInitializeComponents()
 
 			BuoyantMovementComponent->SetBuoyantMesh(BuoyantMeshComponent);
 		}
+
+		PhysicsReplicationData.ApplySettingsToBuffers();
 	}
 }
 
 /** Networking **/
 void ANetworkedBuoyantPawn::ClientUpdateMovement(float DeltaTime)
 {
-	if (IsLocallyControlled())
+	//Stamps from before the clock converged would be on another base than the server's, the server would reject or misplace them
+	if (!HasReplicationTime())
+		return;
+
+	if (IsLocallyControlled() || IsServerOwned())
 	{
 		PhysicsReplicationData.AuthMovementReplication.TimeSinceLastPacketSent += DeltaTime;
+		PhysicsReplicationData.AuthMovementReplication.TimeSinceLastSnapshotSent += DeltaTime;
 		float SendRateFraction = 1.0f / PhysicsReplicationData.Settings.SendRate;
 		if (PhysicsReplicationData.AuthMovementReplication.TimeSinceLastPacketSent >= SendRateFraction)
 		{
@@ -150,35 +187,392 @@ void ANetworkedBuoyantPawn::ClientUpdateMovement(float DeltaTime)
 				FQuat Rot = Body->GetUnrealWorldTransform_AssumesLocked().GetRotation();
 				FVector LinVel = Body->GetUnrealWorldVelocity_AssumesLocked();
 				FVector AngVel = FMath::RadiansToDegrees(Body->GetUnrealWorldAngularVelocityInRadians_AssumesLocked());
-				float TimeStamp = GetWorld()->GetGameState<ASOWGameState>()->GetServerWorldTimeSeconds();
+				float TimeStamp = GetReplicationTime();
 				FMovementSnapshot NewSnapShot = FMovementSnapshot(LinVel, AngVel, Loc, Rot, TimeStamp);
-				ServerRecieveMovement(NewSnapShot);
+				NewSnapShot.Quantization = GetSnapshotQuantization();
+				const FQuantizedMovementSnapshot QuantizedSnapShot = FQuantizedMovementSnapshot::Quantize(NewSnapShot);
+
+				//Compare against what the receivers decode, not the unquantized state
+				const FMovementSnapshot SentSnapShot = QuantizedSnapShot.Dequantize();
+				if (!ShouldSendSnapshot(SentSnapShot))
+					return;
+
+				PhysicsReplicationData.AuthMovementReplication.LastSentSnapshot = SentSnapShot;
+				PhysicsReplicationData.AuthMovementReplication.bHasSentSnapshot = true;
+				PhysicsReplicationData.AuthMovementReplication.TimeSinceLastSnapshotSent = 0.0f;
+				FMovementSnapshotPacket Packet = PhysicsReplicationData.AuthMovementReplication.Encoder.Encode(QuantizedSnapShot, PhysicsReplicationData.Settings, true);
+
+				//The server rewinds the other ships by how far behind this client saw them when it resolves a collision
+				UShipReplicationSubsystem* ShipReplicationSubsystem = UShipReplicationSubsystem::Get(this);
+				if (ShipReplicationSubsystem && !IsServerOwned())
+					Packet.ViewDelayMs = uint16(FMath::Clamp(FMath::RoundToInt(ShipReplicationSubsystem->GetViewDelay()), 0, int32(MAX_uint16)));
+
+				ServerRecieveMovement(Packet);
 				//Experiment and see if storing a copy of the snapshot for Player collision resolution is needed
 			}
 		}
 	}
 }
 
-void ANetworkedBuoyantPawn::ServerRecieveMovement_Implementation(const FMovementSnapshot& SnapShot)
+void ANetworkedBuoyantPawn::ServerRecieveMovement_Implementation(const FMovementSnapshotPacket& Packet)
 {
-	ServerHandleRecievedMovement(SnapShot);
-	MultiCastRecieveMovement(SnapShot);
+	//A delta against a baseline we never received can't be used, the client falls back to a keyframe once its baselines age out
+	FQuantizedMovementSnapshot QuantizedSnapShot;
+	if (!Packet.Decode(PhysicsReplicationData.ServerMovementReplication.ReceivedSnapshots, GetReplicationTime(), QuantizedSnapShot))
+		return;
+
+	//Bounded by the history, a client can't rewind the other ships further than the server remembers them anyway
+	PhysicsReplicationData.ServerMovementReplication.ClientViewDelay = FMath::Min(Packet.ViewDelayMs / 1000.0f, PhysicsReplicationData.Settings.CollisionRewind.HistoryDuration);
+
+	//Server owned pawns send to themselves, there's no client to acknowledge
+	if (IsServerOwned())
+		PhysicsReplicationData.AuthMovementReplication.Encoder.Acknowledge(Packet.Sequence);
+	else
+		ClientAcknowledgeMovement(Packet.Sequence);
+
+	//Redundant copies fill the gaps left by lost packets, oldest first so they arrive in order - the buffer drops the ones it already has
+	UShipReplicationSubsystem* ReplicationSubsystem = UShipReplicationSubsystem::Get(this);
+	TArray<FQuantizedMovementSnapshot, TInlineAllocator<FMovementSnapshotPacket::MaxRedundantStates>> RedundantSnapShots;
+	Packet.DecodeRedundant(QuantizedSnapShot, PhysicsReplicationData.ServerMovementReplication.ReceivedSnapshots, RedundantSnapShots);
+
+	//Clamped after decoding, the received baselines have to stay what the client sent so its deltas still apply
+	ClampSnapshotTime(QuantizedSnapShot);
+	for (int32 Index = RedundantSnapShots.Num() - 1; Index >= 0; Index--)
+	{
+		ClampSnapshotTime(RedundantSnapShots[Index]);
+		if (ServerHandleRecievedMovement(RedundantSnapShots[Index].Dequantize(), uint16(Packet.Sequence - 1 - Index)) && ReplicationSubsystem)
+			ReplicationSubsystem->RecordSnapshot(this, RedundantSnapShots[Index]);
+	}
+
+	if (!ServerHandleRecievedMovement(QuantizedSnapShot.Dequantize(), Packet.Sequence))
+		return;
+
+	if (ReplicationSubsystem)
+		ReplicationSubsystem->RecordSnapshot(this, QuantizedSnapShot);
+
+	//The snapshot is already quantized, re-encoding it for the proxies is lossless
+	if (ReplicationSubsystem && ReplicationSubsystem->IsBatchingEnabled())
+		ReplicationSubsystem->QueueSnapshot(this, QuantizedSnapShot);
+	else
+		MultiCastRecieveMovement(PhysicsReplicationData.ServerMovementReplication.MultiCastEncoder.Encode(QuantizedSnapShot, PhysicsReplicationData.Settings, false));
 }
 
-//UPDATE_TASK: ADDITIONAL_NETWORKING - Implement cheating checks here
-bool ANetworkedBuoyantPawn::ServerRecieveMovement_Validate(const FMovementSnapshot& SnapShot)
+void ANetworkedBuoyantPawn::ClientAcknowledgeMovement_Implementation(uint16 Sequence)
 {
+	PhysicsReplicationData.AuthMovementReplication.Encoder.Acknowledge(Sequence);
+}
+
+FMovementSnapshotQuantization ANetworkedBuoyantPawn::GetSnapshotQuantization()
+{
+	//Velocities past the body's own limit can't happen, so don't spend bits on them
+	FMovementSnapshotQuantization Quantization = PhysicsReplicationData.Settings.Quantization;
+	const FBodyInstance* Body = GetRootBodyInstance();
+	if (Body != nullptr && Body->MaxAngularVelocity > 0.0f)
+		Quantization.MaxAngularSpeed = FMath::Min(Quantization.MaxAngularSpeed, Body->MaxAngularVelocity);
+
+	return Quantization;
+}
+
+//Failing here disconnects the client, so only malformed packets fail - implausible movement is rejected per snapshot in ServerHandleRecievedMovement()
+bool ANetworkedBuoyantPawn::ServerRecieveMovement_Validate(const FMovementSnapshotPacket& Packet)
+{
+	return FMovementValidator::IsWellFormed(Packet, PhysicsReplicationData.Settings.Quantization);
+}
+
+bool ANetworkedBuoyantPawn::ShouldSendSnapshot(const FMovementSnapshot& SnapShot) const
+{
+	return PhysicsReplicationData.AuthMovementReplication.ShouldSendSnapshot(SnapShot, PhysicsReplicationData.Settings.DeadReckoning);
+}
+
+bool ANetworkedBuoyantPawn::ServerHandleRecievedMovement(const FMovementSnapshot& ClientSnapShot, uint16 Sequence)
+{
+	if (IsLocallyControlled() || IsServerOwned() || Role != ROLE_Authority)
+		return true;
+
+	FPhysicsMovementReplication_Server& ServerData = PhysicsReplicationData.ServerMovementReplication;
+	const EMovementValidationFailure Failure = ValidateSnapshot(ClientSnapShot);
+	if (Failure == EMovementValidationFailure::Stale)
+	{
+		//Reordered packets and redundant copies of snapshots already handled land here too, they're dropped without a correction
+		INC_DWORD_STAT(STAT_StaleSnapshots);
+		return false;
+	}
+
+	if (Failure != EMovementValidationFailure::None)
+	{
+		INC_DWORD_STAT(STAT_RejectedSnapshots);
+
+		//Without an accepted snapshot there's nothing to correct to, the client just isn't replicated until it sends a plausible one
+		if (ServerData.bHasValidSnapshot && ServerData.TimeSinceLastCorrection >= PhysicsReplicationData.Settings.Validation.CorrectionInterval)
+		{
+			//Predicted to the server's time rather than the rejected snapshot's, which may be forged too
+			FMovementSnapshot Correction = FMovementSnapshot::Extrapolate(ServerData.LastValidSnapshot, GetReplicationTime());
+			Correction.EventFlag = EF_Correction;
+			Correction.Quantization = GetSnapshotQuantization();
+			ClientCorrectMovement(Correction);
+
+			//Later snapshots are checked against where the client was told to be
+			ServerData.LastValidSnapshot = Correction;
+			ServerData.TimeSinceLastCorrection = 0.0f;
+			INC_DWORD_STAT(STAT_ClientCorrections);
+		}
+
+		return false;
+	}
+
+	if (!ServerData.bHasValidSnapshot || ClientSnapShot.TimeStamp > ServerData.LastValidSnapshot.TimeStamp)
+	{
+		ServerData.LastValidSnapshot = ClientSnapShot;
+		ServerData.bHasValidSnapshot = true;
+	}
+
+	ServerData.PoseHistory.Record(ClientSnapShot);
+
+	//Arrivals are timed with the clock the snapshots are stamped and played out with, so the transit times don't drift
+	ServerData.SnapshotBuffer.ReceiveSnapshot(ClientSnapShot, GetReplicationTime(), Sequence);
+	ServerData.TimeSinceLastPacketRecieved = 0.0f; //We just received a packet so reset the time.
 	return true;
 }
 
-void ANetworkedBuoyantPawn::ServerHandleRecievedMovement(const FMovementSnapshot& ClientSnapShot)
+EMovementValidationFailure ANetworkedBuoyantPawn::ValidateSnapshot(const FMovementSnapshot& SnapShot) const
 {
-	if (!IsLocallyControlled() && Role == ROLE_Authority)
+	SCOPE_CYCLE_COUNTER(STAT_ValidateSnapshot);
+
+	const FMovementValidationSettings& Validation = PhysicsReplicationData.Settings.Validation;
+	if (!Validation.bEnableValidation)
+		return EMovementValidationFailure::None;
+
+	const FPhysicsMovementReplication_Server& ServerData = PhysicsReplicationData.ServerMovementReplication;
+	if (ServerData.bHasValidSnapshot)
+	{
+		const EMovementValidationFailure Failure = FMovementValidator::CheckKinematics(ServerData.LastValidSnapshot, SnapShot, Validation);
+		if (Failure != EMovementValidationFailure::None)
+			return Failure;
+	}
+
+	//The surface under the keel's corners and the origin, waves along a long hull differ from the height at its origin
+	const FBox HullBounds = GetHullBounds();
+	FFloatInterval WaterHeights;
+	UBuoyancyWorldSubsystem* BuoyancySubsystem = UBuoyancyWorldSubsystem::Get(this);
+	if (BuoyancySubsystem != nullptr && HullBounds.IsValid)
+	{
+		const FTransform Pose(SnapShot.Rotation, SnapShot.Location);
+		const FVector HullPoints[5] = { FVector::ZeroVector,
+			FVector(HullBounds.Min.X, HullBounds.Min.Y, HullBounds.Min.Z), FVector(HullBounds.Min.X, HullBounds.Max.Y, HullBounds.Min.Z),
+			FVector(HullBounds.Max.X, HullBounds.Min.Y, HullBounds.Min.Z), FVector(HullBounds.Max.X, HullBounds.Max.Y, HullBounds.Min.Z) };
+
+		//Left empty without an ocean, so only the attitude is checked rather than the draft against water at 0
+		for (const FVector& HullPoint : HullPoints)
+		{
+			float WaterHeight = 0.0f;
+			if (!BuoyancySubsystem->TryGetWaterHeightAtLocation(Pose.TransformPosition(HullPoint), WaterHeight))
+				break;
+
+			WaterHeights.Include(WaterHeight);
+		}
+	}
+
+	return FMovementValidator::CheckHydrostatics(SnapShot, HullBounds, WaterHeights, Validation);
+}
+
+void ANetworkedBuoyantPawn::ClampSnapshotTime(FQuantizedMovementSnapshot& SnapShot) const
+{
+	if (IsLocallyControlled() || IsServerOwned() || Role != ROLE_Authority || !PhysicsReplicationData.Settings.Validation.bEnableValidation)
+		return;
+
+	//A stamp is the client's estimate of the server's clock, it can lag by the trip here and be off by its clock's error - which the round trip bounds
+	UNetConnection* Connection = GetNetConnection();
+	const float RoundTripTime = Connection != nullptr ? Connection->AvgLag : 0.0f;
+	const float JitterWindow = PhysicsReplicationData.Settings.JitterBuffer.MaxBufferDelay / 1000.0f;
+	SnapShot.TimeStampMs = FMovementValidator::ClampTimeStamp(SnapShot.TimeStampMs, GetReplicationTime(), RoundTripTime + JitterWindow);
+}
+
+FBox ANetworkedBuoyantPawn::GetHullBounds() const
+{
+	//Snapshot locations are the body's origin, so the bounds are only scaled
+	if (BuoyantMeshComponent == nullptr)
+		return FBox(ForceInit);
+
+	return BuoyantMeshComponent->CalcBounds(FTransform(FQuat::Identity, FVector::ZeroVector, BuoyantMeshComponent->GetComponentScale())).GetBox();
+}
+
+void ANetworkedBuoyantPawn::RecordServerPose(float DeltaTime)
+{
+	FPhysicsMovementReplication_Server& ServerData = PhysicsReplicationData.ServerMovementReplication;
+	ServerData.TimeSinceLastPoseRecorded += DeltaTime;
+
+	const float RecordInterval = 1.0f / FMath::Max(PhysicsReplicationData.Settings.CollisionRewind.RecordRate, 1.0f);
+	if (!PhysicsReplicationData.Settings.CollisionRewind.bEnableLagCompensation || ServerData.TimeSinceLastPoseRecorded < RecordInterval)
+		return;
+
+	FBodyInstance* Body = GetRootBodyInstance();
+	if (Body == nullptr)
+		return;
+
+	ServerData.TimeSinceLastPoseRecorded = FMath::Min(ServerData.TimeSinceLastPoseRecorded - RecordInterval, RecordInterval);
+
+	//Recorded in the clock client snapshots are stamped with, so both kinds of ship rewind to the same time
+	const FTransform BodyTransform = Body->GetUnrealWorldTransform();
+	ServerData.PoseHistory.Record(FMovementSnapshot(Body->GetUnrealWorldVelocity(), FMath::RadiansToDegrees(Body->GetUnrealWorldAngularVelocityInRadians()), BodyTransform.GetLocation(), BodyTransform.GetRotation(), GetReplicationTime()));
+}
+
+void ANetworkedBuoyantPawn::NotifyHit(class UPrimitiveComponent* MyComp, AActor* Other, class UPrimitiveComponent* OtherComp, bool bSelfMoved, FVector HitLocation, FVector HitNormal, FVector NormalImpulse, const FHitResult& Hit)
+{
+	Super::NotifyHit(MyComp, Other, OtherComp, bSelfMoved, HitLocation, HitNormal, NormalImpulse, Hit);
+
+	ANetworkedBuoyantPawn* OtherShip = Cast<ANetworkedBuoyantPawn>(Other);
+	if (OtherShip != nullptr && Role == ROLE_Authority)
+		ServerResolveShipCollision(OtherShip, HitNormal);
+}
+
+void ANetworkedBuoyantPawn::ServerResolveShipCollision(ANetworkedBuoyantPawn* Other, const FVector& HitNormal)
+{
+	//The server simulated both ships itself, its physics already resolved them correctly
+	const FCollisionRewindSettings& CollisionRewind = PhysicsReplicationData.Settings.CollisionRewind;
+	if (!CollisionRewind.bEnableLagCompensation || Other == nullptr || Other == this || (IsServerSimulated() && Other->IsServerSimulated()))
+		return;
+
+	FBodyInstance* Body = GetRootBodyInstance();
+	FBodyInstance* OtherBody = Other->GetRootBodyInstance();
+	if (Body == nullptr || OtherBody == nullptr)
+		return;
+
+	//Both ships report the hit every frame they touch, the first report resolves it for both
+	const float Now = GetReplicationTime();
+	FPhysicsMovementReplication_Server& ServerData = PhysicsReplicationData.ServerMovementReplication;
+	FPhysicsMovementReplication_Server& OtherServerData = Other->PhysicsReplicationData.ServerMovementReplication;
+	if ((ServerData.LastCollisionTime >= 0.0f && Now - ServerData.LastCollisionTime < CollisionRewind.CollisionCooldown)
+		|| (OtherServerData.LastCollisionTime >= 0.0f && Now - OtherServerData.LastCollisionTime < CollisionRewind.CollisionCooldown))
+		return;
+
+	SCOPE_CYCLE_COUNTER(STAT_ResolveShipCollision);
+
+	//Resolve the hit as the client with the oldest report saw it, its own ship where it last reported it
+	const ANetworkedBuoyantPawn* Viewer = nullptr;
+	const ANetworkedBuoyantPawn* Ships[] = { this, Other };
+	for (const ANetworkedBuoyantPawn* Ship : Ships)
+	{
+		const FPhysicsMovementReplication_Server& ShipData = Ship->PhysicsReplicationData.ServerMovementReplication;
+		if (Ship->IsServerSimulated())
+			continue;
+
+		if (!ShipData.bHasValidSnapshot)
+			return;
+
+		if (Viewer == nullptr || ShipData.LastValidSnapshot.TimeStamp < Viewer->PhysicsReplicationData.ServerMovementReplication.LastValidSnapshot.TimeStamp)
+			Viewer = Ship;
+	}
+
+	if (Viewer == nullptr)
+		return;
+
+	//and the other ship where its interpolation buffers showed it, a view delay behind
+	const FPhysicsMovementReplication_Server& ViewerData = Viewer->PhysicsReplicationData.ServerMovementReplication;
+	const float ViewerTime = FMath::Min(ViewerData.LastValidSnapshot.TimeStamp, Now);
+	const float ViewedTime = ViewerTime - ViewerData.ClientViewDelay;
+	const float RewindTime = Viewer == this ? ViewerTime : ViewedTime;
+	const float OtherRewindTime = Viewer == this ? ViewedTime : ViewerTime;
+
+	FMovementSnapshot Pose, OtherPose;
+	if (!ServerData.PoseHistory.Sample(RewindTime, Pose) || !OtherServerData.PoseHistory.Sample(OtherRewindTime, OtherPose))
+		return;
+
+	//Ships collide side by side on the water, so the normal is kept horizontal and points from this ship to the other
+	FVector Normal = OtherPose.Location - Pose.Location;
+	Normal.Z = 0.0f;
+	if (!Normal.Normalize())
 	{
-		//UPDATE_TASK: Run anti-cheat and dynamic collision flags here
-		PhysicsReplicationData.ServerMovementReplication.SnapshotBuffer.AddToBuffer(ClientSnapShot);
-		PhysicsReplicationData.ServerMovementReplication.TimeSinceLastPacketRecieved = 0.0f; //We just received a packet so reset the time.
+		Normal = FVector(HitNormal.X, HitNormal.Y, 0.0f).GetSafeNormal();
+		if (Normal.IsZero())
+			return;
 	}
+
+	const float InvMass = 1.0f / FMath::Max(Body->GetBodyMass(), KINDA_SMALL_NUMBER);
+	const float OtherInvMass = 1.0f / FMath::Max(OtherBody->GetBodyMass(), KINDA_SMALL_NUMBER);
+	const float InvMassSum = InvMass + OtherInvMass;
+
+	//Push the rewound hulls apart along the normal, each by its share of the mass
+	auto GetSupport = [&Normal](const FBox& Bounds, const FMovementSnapshot& ShipPose)
+	{
+		const FVector Extent = Bounds.GetExtent();
+		return FMath::Abs(ShipPose.Rotation.GetAxisX() | Normal) * Extent.X + FMath::Abs(ShipPose.Rotation.GetAxisY() | Normal) * Extent.Y + FMath::Abs(ShipPose.Rotation.GetAxisZ() | Normal) * Extent.Z;
+	};
+
+	const FBox HullBounds = GetHullBounds();
+	const FBox OtherHullBounds = Other->GetHullBounds();
+	const float Center = (Pose.Location + Pose.Rotation.RotateVector(HullBounds.GetCenter())) | Normal;
+	const float OtherCenter = (OtherPose.Location + OtherPose.Rotation.RotateVector(OtherHullBounds.GetCenter())) | Normal;
+	const float Penetration = (Center + GetSupport(HullBounds, Pose)) - (OtherCenter - GetSupport(OtherHullBounds, OtherPose));
+	if (Penetration > 0.0f)
+	{
+		Pose.Location -= Normal * Penetration * (InvMass / InvMassSum);
+		OtherPose.Location += Normal * Penetration * (OtherInvMass / InvMassSum);
+	}
+
+	//An impulse along the normal removes the closing speed and bounces back its restitution
+	FVector VelocityChange = FVector::ZeroVector;
+	FVector OtherVelocityChange = FVector::ZeroVector;
+	const float ClosingSpeed = (Pose.LinearVelocity - OtherPose.LinearVelocity) | Normal;
+	if (ClosingSpeed > 0.0f)
+	{
+		const float Impulse = (1.0f + CollisionRewind.Restitution) * ClosingSpeed / InvMassSum;
+		VelocityChange = -Normal * Impulse * InvMass;
+		OtherVelocityChange = Normal * Impulse * OtherInvMass;
+		Pose.LinearVelocity += VelocityChange;
+		OtherPose.LinearVelocity += OtherVelocityChange;
+	}
+
+	FMovementSnapshot Corrected = FMovementSnapshot::Extrapolate(Pose, Now);
+	FMovementSnapshot OtherCorrected = FMovementSnapshot::Extrapolate(OtherPose, Now);
+	Corrected.EventFlag = EF_Collision;
+	OtherCorrected.EventFlag = EF_Collision;
+	ApplyCollisionCorrection(Corrected, VelocityChange);
+	Other->ApplyCollisionCorrection(OtherCorrected, OtherVelocityChange);
+
+	INC_DWORD_STAT(STAT_RewoundCollisions);
+}
+
+void ANetworkedBuoyantPawn::ApplyCollisionCorrection(const FMovementSnapshot& Corrected, const FVector& VelocityChange)
+{
+	FPhysicsMovementReplication_Server& ServerData = PhysicsReplicationData.ServerMovementReplication;
+	ServerData.LastCollisionTime = Corrected.TimeStamp;
+
+	//The server's physics already pushed its own ship out of the contact, it only takes on the rewound impulse.
+	//Its velocity now already holds whatever happened since the rewound time, so only the impulse's change is added to it
+	if (IsServerSimulated())
+	{
+		FBodyInstance* Body = GetRootBodyInstance();
+		if (Body != nullptr && !VelocityChange.IsNearlyZero())
+			Body->AddImpulse(VelocityChange, true);
+
+		return;
+	}
+
+	FMovementSnapshot Correction = Corrected;
+	Correction.Quantization = GetSnapshotQuantization();
+	ClientCorrectMovement(Correction);
+
+	//The client's snapshots after the collision are validated against its result, not the state before it
+	ServerData.LastValidSnapshot = Corrected;
+	ServerData.bHasValidSnapshot = true;
+	ServerData.TimeSinceLastCorrection = 0.0f;
+	INC_DWORD_STAT(STAT_ClientCorrections);
+}
+
+void ANetworkedBuoyantPawn::ClientCorrectMovement_Implementation(const FMovementSnapshot& Correction)
+{
+	FBodyInstance* Body = GetRootBodyInstance();
+	if (Body == nullptr)
+		return;
+
+	//The correction is as old as its trip here, predict it forward to now
+	const FMovementSnapshot Corrected = FMovementSnapshot::Extrapolate(Correction, GetReplicationTime());
+	Body->SetBodyTransform(FTransform(Corrected.Rotation, Corrected.Location), ETeleportType::TeleportPhysics);
+	Body->SetLinearVelocity(Corrected.LinearVelocity, false);
+	Body->SetAngularVelocityInRadians(FMath::DegreesToRadians(Corrected.AngularVelocity), false);
+
+	//Send the corrected state right away instead of letting dead reckoning suppress it
+	PhysicsReplicationData.AuthMovementReplication.bHasSentSnapshot = false;
 }
 
 void ANetworkedBuoyantPawn::ServerSimulateMovement(float DeltaTime)
@@ -186,121 +580,156 @@ void ANetworkedBuoyantPawn::ServerSimulateMovement(float DeltaTime)
 	if (!IsLocallyControlled() && Role == ROLE_Authority)
 	{
 		PhysicsReplicationData.ServerMovementReplication.TimeSinceLastPacketRecieved += DeltaTime;
+		PhysicsReplicationData.ServerMovementReplication.TimeSinceLastCorrection += DeltaTime;
 
-		//IMPORT_TASK: Change to AGameState instead
-		//UPDATE_TASK: Correctly update the time to prevent drift by overriding GetServerWorldTimeSeconds()
-		ASOWGameState* SOWGS = GetWorld()->GetGameState<ASOWGameState>();
-		if (SOWGS)
-		{
-			float Time = GetWorld()->GetUnpausedTimeSeconds();
-			const FMovementSnapShotBuffer& SnapShotBuffer = PhysicsReplicationData.ServerMovementReplication.SnapshotBuffer;		
-			int32 TargetIndex;
-			int32 CurrentIndex;
-			if (SnapShotBuffer.HasElapsedMinTime(Time))
-			{
-				if (SnapShotBuffer.GetTargetSnapshotIndex(Time, TargetIndex) &&  SnapShotBuffer.GetCurrentSnapshotIndex(Time, CurrentIndex))
-				{
-					FBodyInstance* Body = GetRootBodyInstance();
-					if (Body != nullptr)
-					{
-						const FMovementSnapshot& TargetSnapshot = SnapShotBuffer.Buffer[TargetIndex];
-						const FMovementSnapshot& CurrentSnapshot = SnapShotBuffer.Buffer[CurrentIndex];
-
-						/* TODO: IMPLEMENT BETTER SMOOTHING ALGORITHM? (CUBIC, HERMITE, ETC) */
-						/*
-						Interpolation alpha formula for a buffer containing missing and or continuous snapshots is the following:
-						(SnapshotInterval / (SnapshotB.Time - SnapshotA.Time)) * (CurrentTime - ((BufferSize * SnapshotInterval) + SnapshotA.Time))
-						*/
-						//UPDATE_TASK: Move this alpha calculation to a static function (used also by SimulateMovement)
-						const float AT = CurrentSnapshot.TimeStamp;
-						const float BT = TargetSnapshot.TimeStamp;
-						const float CT = Time;
-						const float BI = 1.0f / PhysicsReplicationData.Settings.SendRate; //Convert to a fraction of a second
-						const float BS = PhysicsReplicationData.Settings.BufferSize / 1000.0f; //Convert to milliseconds
-						const float BSI = BI * BS;
-						const float IS = BI / (BT - AT);
-						const float A = IS * (CT - (BSI + AT));
-						const float Alpha = A;
-						FQuat RotLerp = FQuat::Slerp(Body->GetUnrealWorldTransform_AssumesLocked().GetRotation(), TargetSnapshot.Rotation, Alpha);
-						FVector LocLerp = UKismetMathLibrary::VLerp(Body->GetUnrealWorldTransform_AssumesLocked().GetLocation(), TargetSnapshot.Location,Alpha);
-						FVector LinVelLerp = UKismetMathLibrary::VLerp(Body->GetUnrealWorldVelocity_AssumesLocked(), TargetSnapshot.LinearVelocity, Alpha);
-						FVector AngVelLerp = UKismetMathLibrary::VLerp(Body->GetUnrealWorldAngularVelocityInRadians_AssumesLocked(), TargetSnapshot.AngularVelocity, Alpha);\
-						FTransform NewTransform = FTransform(RotLerp, LocLerp);
-
-						Body->SetBodyTransform(NewTransform, ETeleportType::TeleportPhysics);
-						Body->SetLinearVelocity(LinVelLerp, false);
-						Body->SetAngularVelocityInRadians(AngVelLerp, false);
-					}
-				}
-			}
-			PhysicsReplicationData.ServerMovementReplication.SnapshotBuffer.Update(Time);
-		}	
+		UShipReplicationSubsystem* ShipReplicationSubsystem = UShipReplicationSubsystem::Get(this);
+		if (ShipReplicationSubsystem && ShipReplicationSubsystem->RequestServerInterpolation(this))
+			return;
+
+		const float Time = GetReplicationTime();
+		const FMovementSnapShotBuffer& SnapShotBuffer = PhysicsReplicationData.ServerMovementReplication.SnapshotBuffer;		
+		if (SnapShotBuffer.HasElapsedMinTime(Time))
+			ApplyInterpolatedMovement(SnapShotBuffer, Time, DeltaTime);
+
+		PhysicsReplicationData.ServerMovementReplication.SnapshotBuffer.Update(Time);
+		if (ShipReplicationSubsystem)
+			ShipReplicationSubsystem->ReportBufferDelay(PhysicsReplicationData.ServerMovementReplication.SnapshotBuffer);
 	}
 }
 
 void ANetworkedBuoyantPawn::SimulateMovement(float DeltaTime)
 {
 	//PhysicsReplicationData.LocalMovementReplication.TimeSinceLastPacketRecieved += DeltaTime;
+	if (!HasReplicationTime())
+		return;
+
+	const float Time = GetReplicationTime();
+	const FMovementSnapShotBuffer& SnapShotBuffer = PhysicsReplicationData.LocalMovementReplication.SnapshotBuffer;
+	if (SnapShotBuffer.HasElapsedMinTime(Time))
+		ApplyInterpolatedMovement(SnapShotBuffer, Time, DeltaTime);
+
+	PhysicsReplicationData.LocalMovementReplication.SnapshotBuffer.Update(Time);
+
+	UShipReplicationSubsystem* ShipReplicationSubsystem = UShipReplicationSubsystem::Get(this);
+	if (ShipReplicationSubsystem)
+		ShipReplicationSubsystem->ReportBufferDelay(PhysicsReplicationData.LocalMovementReplication.SnapshotBuffer);
+}
+
+bool ANetworkedBuoyantPawn::HasReplicationTime() const
+{
+	UShipReplicationSubsystem* ShipReplicationSubsystem = UShipReplicationSubsystem::Get(this);
+	return ShipReplicationSubsystem == nullptr || ShipReplicationSubsystem->HasReplicationTime();
+}
+
+float ANetworkedBuoyantPawn::GetReplicationTime() const
+{
+	UShipReplicationSubsystem* ShipReplicationSubsystem = UShipReplicationSubsystem::Get(this);
+	if (ShipReplicationSubsystem)
+		return ShipReplicationSubsystem->GetReplicationTime();
 
 	//IMPORT_TASK: Change to AGameState instead
-	//UPDATE_TASK: Correctly update the local time to prevent drift by overriding GetServerWorldTimeSeconds()
 	ASOWGameState* SOWGS = GetWorld()->GetGameState<ASOWGameState>();
-	if (SOWGS)
+	return SOWGS ? SOWGS->GetServerWorldTimeSeconds() : GetWorld()->GetTimeSeconds();
+}
+
+bool ANetworkedBuoyantPawn::ApplyInterpolatedMovement(const FMovementSnapShotBuffer& SnapShotBuffer, float Time, float DeltaTime)
+{
+	FMovementSnapshot Snapshot;
+	if (!SnapShotBuffer.Sample(Time, Snapshot))
+		return false;
+
+	return ApplyMovementState(Snapshot.Location, Snapshot.Rotation, Snapshot.LinearVelocity, Snapshot.AngularVelocity, DeltaTime);
+}
+
+bool ANetworkedBuoyantPawn::ApplyMovementState(const FVector& Location, const FQuat& Rotation, const FVector& LinearVelocity, const FVector& AngularVelocity, float DeltaTime)
+{
+	FBodyInstance* Body = GetRootBodyInstance();
+	if (Body == nullptr)
+		return false;
+
+	const FProxyCorrectionSettings& Correction = PhysicsReplicationData.Settings.Correction;
+	const FTransform BodyTransform = Body->GetUnrealWorldTransform();
+	const FVector LocationError = Location - BodyTransform.GetLocation();
+
+	//The shortest rotation from the body to the target as an axis scaled by its angle in degrees
+	FQuat RotationDelta = Rotation * BodyTransform.GetRotation().Inverse();
+	if (RotationDelta.W < 0.0f)
+		RotationDelta = RotationDelta * -1.0f;
+
+	FVector RotationAxis;
+	float RotationAngle;
+	RotationDelta.ToAxisAndAngle(RotationAxis, RotationAngle);
+	const FVector RotationError = RotationAxis * FMath::RadiansToDegrees(RotationAngle);
+
+	//Teleporting forces a broadphase update and drops contacts, only snap when steering can't catch up
+	const bool bSnap = !Correction.bEnableVelocityCorrection || LocationError.SizeSquared() > FMath::Square(Correction.SnapDistance) || RotationError.SizeSquared() > FMath::Square(Correction.SnapAngle);
+	if (bSnap)
 	{
-		float Time = SOWGS->GetServerWorldTimeSeconds();
-		const FMovementSnapShotBuffer& SnapShotBuffer = PhysicsReplicationData.LocalMovementReplication.SnapshotBuffer;
-		int32 TargetIndex;
-		int32 CurrentIndex;
-		if (SnapShotBuffer.HasElapsedMinTime(Time))
-		{
-			if (SnapShotBuffer.GetTargetSnapshotIndex(Time, TargetIndex) && SnapShotBuffer.GetCurrentSnapshotIndex(Time, CurrentIndex))
-			{
-				FBodyInstance* Body = GetRootBodyInstance();
-				if (Body != nullptr)
-				{
-					const FMovementSnapshot& TargetSnapshot = SnapShotBuffer.Buffer[TargetIndex];
-					const FMovementSnapshot& CurrentSnapshot = SnapShotBuffer.Buffer[CurrentIndex];
-					/* TODO: IMPLEMENT BETTER SMOOTHING ALGORITHM? (CUBIC, HERMITE, ETC) */
-					/*
-					Interpolation alpha formula for a buffer containing missing and or continuous snapshots is the following:
-					(SnapshotInterval / (SnapshotB.Time - SnapshotA.Time)) * (CurrentTime - ((BufferSize * SnapshotInterval) + SnapshotA.Time))
-					*/
-					//UPDATE_TASK: Move this alpha calculation to a static function (used also by ServerSimulateMovement)
-					const float AT = CurrentSnapshot.TimeStamp;
-					const float BT = TargetSnapshot.TimeStamp;
-					const float CT = Time;
-					const float BI = 1.0f / PhysicsReplicationData.Settings.SendRate; //Convert to a fraction of a second
-					const float BS = PhysicsReplicationData.Settings.BufferSize / 1000.0f; //Convert to milliseconds
-					const float BSI = BI * BS;
-					const float IS = BI / (BT - AT);
-					const float A = IS * (CT - (BSI + AT));
-
-					const float Alpha = A;
-					FQuat RotLerp = FQuat::Slerp(Body->GetUnrealWorldTransform_AssumesLocked().GetRotation(), TargetSnapshot.Rotation, Alpha); 
-					FVector LocLerp = UKismetMathLibrary::VLerp(Body->GetUnrealWorldTransform_AssumesLocked().GetLocation(), TargetSnapshot.Location, Alpha);
-					FVector LinVelLerp = UKismetMathLibrary::VLerp(Body->GetUnrealWorldVelocity_AssumesLocked(), TargetSnapshot.LinearVelocity, Alpha);
-					FVector AngVelLerp = UKismetMathLibrary::VLerp(Body->GetUnrealWorldAngularVelocityInRadians_AssumesLocked(), TargetSnapshot.AngularVelocity, Alpha);
-					FTransform NewTransform = FTransform(RotLerp, LocLerp);
-
-					Body->SetBodyTransform(NewTransform, ETeleportType::TeleportPhysics);
-					Body->SetLinearVelocity(LinVelLerp, false);
-					Body->SetAngularVelocityInRadians(AngVelLerp, false);
-				}
-			}
-		}
-		PhysicsReplicationData.LocalMovementReplication.SnapshotBuffer.Update(Time);
+		INC_DWORD_STAT(STAT_ProxySnaps);
+
+		//Snapshots carry their angular velocity in degrees per second
+		Body->SetBodyTransform(FTransform(Rotation, Location), ETeleportType::TeleportPhysics);
+		Body->SetLinearVelocity(LinearVelocity, false);
+		Body->SetAngularVelocityInRadians(FMath::DegreesToRadians(AngularVelocity), false);
+		return true;
 	}
+
+	INC_DWORD_STAT(STAT_ProxyCorrections);
+
+	//Kinematic bodies are moved to a kinematic target, which sweeps them there during the next physics step
+	if (!Body->IsInstanceSimulatingPhysics())
+	{
+		Body->SetBodyTransform(FTransform(Rotation, Location), ETeleportType::None);
+		return true;
+	}
+
+	//PD steering, the proportional term closes the error and the damping term eases the body's velocities toward the commanded ones,
+	//so contacts between ships still push them apart for a moment before they're pulled back onto their replicated path
+	const float Damping = FMath::Clamp(Correction.DampingGain * DeltaTime, 0.0f, 1.0f);
+	const FVector CommandedVelocity = LinearVelocity + LocationError * Correction.PositionGain;
+	const FVector CommandedAngularVelocity = AngularVelocity + RotationError * Correction.RotationGain;
+
+	const FVector BodyVelocity = Body->GetUnrealWorldVelocity();
+	const FVector BodyAngularVelocity = FMath::RadiansToDegrees(Body->GetUnrealWorldAngularVelocityInRadians());
+	Body->SetLinearVelocity(FMath::Lerp(BodyVelocity, CommandedVelocity, Damping), false);
+	Body->SetAngularVelocityInRadians(FMath::DegreesToRadians(FMath::Lerp(BodyAngularVelocity, CommandedAngularVelocity, Damping)), false);
+	return true;
 }
 
-void ANetworkedBuoyantPawn::MultiCastRecieveMovement_Implementation(const FMovementSnapshot& SentSnapShot)
+void ANetworkedBuoyantPawn::MultiCastRecieveMovement_Implementation(const FMovementSnapshotPacket& Packet)
+{
+	ReceiveReplicatedMovement(Packet);
+}
+
+void ANetworkedBuoyantPawn::ReceiveReplicatedMovement(const FMovementSnapshotPacket& Packet, uint8 RateDivisor)
 {
 	if (Role == ROLE_SimulatedProxy) //Proxy Client
 	{
-		PhysicsReplicationData.LocalMovementReplication.SnapshotBuffer.AddToBuffer(SentSnapShot);
+		//Thinned snapshots are further apart, the jitter buffer sizes its delay from the interval it actually receives
+		PhysicsReplicationData.LocalMovementReplication.SnapshotBuffer.BufferInterval = 1000.0f * FMath::Max<uint8>(RateDivisor, 1) / FMath::Max<uint32>(PhysicsReplicationData.Settings.SendRate, 1);
+
+		//Keyframe stamps are restored from the clock, so nothing is decoded until it's on the server's base - the next keyframe starts the baselines
+		if (!HasReplicationTime())
+			return;
+
+		//Deltas whose keyframe was lost are dropped until the next keyframe arrives
+		const float ArrivalTime = GetReplicationTime();
+		FQuantizedMovementSnapshot QuantizedSnapShot;
+		if (!Packet.Decode(PhysicsReplicationData.LocalMovementReplication.ReceivedSnapshots, ArrivalTime, QuantizedSnapShot))
+			return;
+
+		FMovementSnapShotBuffer& SnapShotBuffer = PhysicsReplicationData.LocalMovementReplication.SnapshotBuffer;
+		TArray<FQuantizedMovementSnapshot, TInlineAllocator<FMovementSnapshotPacket::MaxRedundantStates>> RedundantSnapShots;
+		Packet.DecodeRedundant(QuantizedSnapShot, PhysicsReplicationData.LocalMovementReplication.ReceivedSnapshots, RedundantSnapShots);
+		for (int32 Index = RedundantSnapShots.Num() - 1; Index >= 0; Index--)
+		{
+			SnapShotBuffer.ReceiveSnapshot(RedundantSnapShots[Index].Dequantize(), ArrivalTime, uint16(Packet.Sequence - 1 - Index));
+		}
+
+		SnapShotBuffer.ReceiveSnapshot(QuantizedSnapShot.Dequantize(), ArrivalTime, Packet.Sequence);
 	}
 }
 
-//UPDATE_TASK: ADDITIONAL_NETWORKING - Handle Player on Player Collision here?
 void ANetworkedBuoyantPawn::OnRep_ReplicatedMovement()
 {
 	Super::OnRep_ReplicatedMovement();
@@ -3,7 +3,7 @@
 *
 * Created by: Tobias Moos
 * Project name: Sails of War
-* Unreal Engine version: 4.19
+* Unreal Engine version: 4.22
 * Created on: 2020/01/08
 *
 * Last Edited on: 2021/02/03
@@ -89,6 +89,57 @@ public:
 
 	FCalculateCustomPhysics OnCalculateCustomPhysics; //Binds the pawn tick to our sub-steps in the MovementComponent
 
+	/**
+	*	Returns true if the server owns and simulates this pawn's movement itself - AI controlled or unpossessed pawns
+	*	@return	bool - true on the server for pawns not controlled by a player
+	*/
+	bool IsServerOwned() const { return Role == ROLE_Authority && !IsPlayerControlled(); }
+
+	/**
+	*	Returns true if the server's physics simulates this pawn - server owned pawns and a listen server's own pawn, no client reports their movement
+	*	@return	bool - true on the server for pawns that aren't controlled by a remote client
+	*/
+	bool IsServerSimulated() const { return Role == ROLE_Authority && (IsServerOwned() || IsLocallyControlled()); }
+
+	/**
+	*	Decode a snapshot sent by the server and add it to the local buffer of simulated proxies
+	*	@param	Packet - the encoded movement snapshot, a delta against the last keyframe sent to this connection
+	*	@param	RateDivisor - the server only sends every RateDivisor-th snapshot to this connection
+	*/
+	void ReceiveReplicatedMovement(const FMovementSnapshotPacket& Packet, uint8 RateDivisor = 1);
+
+	/**
+	*	Returns the settings this pawn's snapshots are replicated with
+	*/
+	const FPhysicsReplicationSettings& GetReplicationSettings() const { return PhysicsReplicationData.Settings; }
+
+	/**
+	*	Get the time snapshots are stamped and played out with, see UShipReplicationSubsystem::GetReplicationTime()
+	*	@return	float - the replication time in seconds
+	*/
+	float GetReplicationTime() const;
+
+	/**
+	*	Returns false until the replication time is on the server's clock, see UShipReplicationSubsystem::HasReplicationTime()
+	*/
+	bool HasReplicationTime() const;
+
+	/**
+	*	Returns the buffer the server plays out the owning client's snapshots from
+	*/
+	FMovementSnapShotBuffer& GetServerSnapshotBuffer() { return PhysicsReplicationData.ServerMovementReplication.SnapshotBuffer; }
+
+	/**
+	*	Move the body to a replicated state, steering it there with its velocities unless it's further than the snap threshold
+	*	@param	Location - The world location
+	*	@param	Rotation - The world rotation
+	*	@param	LinearVelocity - The linear velocity in cm/s
+	*	@param	AngularVelocity - The angular velocity in degrees per second
+	*	@param	DeltaTime - The time since the last correction, scales how far the velocities converge
+	*	@return	bool - false if there's no body
+	*/
+	bool ApplyMovementState(const FVector& Location, const FQuat& Rotation, const FVector& LinearVelocity, const FVector& AngularVelocity, float DeltaTime);
+
 /** Networking **/
 protected:
 	/**
@@ -100,20 +151,88 @@ protected:
 	//TODO: This should be marked to be done after simulation of the movement for this frame!
 	/**
 	*	Update the buffer on the server and multi-cast this snapshot to the clients.
-	*	@param	SnapShot - the movement snapshot received from the autonomous client
+	*	@param	Packet - the encoded movement snapshot received from the autonomous client
 	*/
 	UFUNCTION(Server, Unreliable, WithValidation)
-	virtual void ServerRecieveMovement(const FMovementSnapshot& SnapShot);
+	virtual void ServerRecieveMovement(const FMovementSnapshotPacket& Packet);
 
 	/**
-	*	Handle the recieved snapshot from the client by adding it to the buffer
+	*	Acknowledge a snapshot the server received, the client may delta compress against it from now on
+	*	@param	Sequence - the sequence number of the received snapshot
+	*/
+	UFUNCTION(Client, Unreliable)
+	virtual void ClientAcknowledgeMovement(uint16 Sequence);
+
+	/**
+	*	Handle the recieved snapshot from the client by adding it to the buffer, implausible snapshots are rejected and the client corrected
 	*	@param	SnapShot - The movement snapshot received from the autonomous client 
+	*	@param	Sequence - The sequence number of the packet it arrived in
+	*	@return	bool - false if the snapshot was rejected and mustn't be forwarded
+	*/
+	virtual bool ServerHandleRecievedMovement(const FMovementSnapshot& SnapShot, uint16 Sequence);
+
+	/**
+	*	Check a client snapshot against the ship's kinematic limits and whether its hull could float like that
+	*	@param	SnapShot - The movement snapshot received from the autonomous client
+	*	@return	EMovementValidationFailure - None if the snapshot is plausible
+	*/
+	EMovementValidationFailure ValidateSnapshot(const FMovementSnapshot& SnapShot) const;
+
+	/**
+	*	Clamp a client snapshot's timestamp to the server's clock, give or take the client's round trip and the jitter window
+	*	@param	SnapShot - The movement snapshot received from the autonomous client
 	*/
-	virtual void ServerHandleRecievedMovement(const FMovementSnapshot& SnapShot);
+	void ClampSnapshotTime(FQuantizedMovementSnapshot& SnapShot) const;
+
+	/**
+	*	Move the owning client's ship to a state the server decided on
+	*	@param	Correction - The state at the server's time, flagged EF_Correction for a rejected snapshot or EF_Collision for a resolved collision
+	*	Reliable, a lost collision correction would leave the client sailing through the other ship - both kinds are already rate limited
+	*/
+	UFUNCTION(Client, Reliable)
+	virtual void ClientCorrectMovement(const FMovementSnapshot& Correction);
+
+	/**
+	*	Returns the scaled bounds of the hull around the body's origin
+	*/
+	FBox GetHullBounds() const;
+
+	/**
+	*	Record the server simulated ship's pose into its history at the collision rewind's record rate
+	*	@param	DeltaTime - fractional time used to scale values by.
+	*/
+	void RecordServerPose(float DeltaTime);
+
+	/**
+	*	Resolve a collision with another ship where a client owned ship is involved, at the time the client reported its state.
+	*	Both ships are rewound through their pose histories, separated and given a collision impulse, and the results predicted to now and sent as EF_Collision corrections.
+	*	@param	Other - The ship collided with
+	*	@param	HitNormal - The contact normal reported by the physics scene, used when the ships' centers coincide
+	*/
+	void ServerResolveShipCollision(ANetworkedBuoyantPawn* Other, const FVector& HitNormal);
+
+	/**
+	*	Hand a resolved collision's result to whoever simulates this ship
+	*	@param	Corrected - The ship's state after the collision, at the server's current time
+	*	@param	VelocityChange - The change in linear velocity the collision impulse caused at the rewound time
+	*/
+	void ApplyCollisionCorrection(const FMovementSnapshot& Corrected, const FVector& VelocityChange);
+
+	/**
+	*	Returns true if the receivers' dead reckoning from the last sent snapshot is too far from the new one, or a heartbeat is due
+	*	@param	SnapShot - The snapshot that would be sent, as the receivers would decode it
+	*/
+	bool ShouldSendSnapshot(const FMovementSnapshot& SnapShot) const;
+
+	/**
+	*	Get the quantization settings for snapshots sent by this pawn, bounded by the body's limits
+	*	@return	FMovementSnapshotQuantization - the settings to send snapshots with
+	*/
+	FMovementSnapshotQuantization GetSnapshotQuantization();
 
 	/**
 	*	Simulate the movement on the server 
-	*	and update the server buffer after completion
+	*	and update the server buffer after completion, unless the ship replication subsystem interpolates it in its batch
 	*	@param	DeltaTime - fractional time used to scale values by. 
 	*/
 	virtual void ServerSimulateMovement(float DeltaTime);
@@ -126,11 +245,20 @@ protected:
 	virtual void SimulateMovement(float DeltaTime);
 
 	/**
-	*	
-	*	@param	SnapShot - 
+	*	Move the body to the snapshot buffer's interpolated state at the buffered time
+	*	@param	SnapShotBuffer - the buffer to sample
+	*	@param	Time - the current time, the buffer delay is subtracted from it
+	*	@param	DeltaTime - the time since the last correction
+	*	@return	bool - false if there's no body or the buffered time isn't surrounded by snapshots
+	*/
+	bool ApplyInterpolatedMovement(const FMovementSnapShotBuffer& SnapShotBuffer, float Time, float DeltaTime);
+
+	/**
+	*	Decode a snapshot multicast by the server, used when the ship replication subsystem doesn't batch snapshots
+	*	@param	Packet - the encoded movement snapshot, a delta against the server's last keyframe
 	*/
 	UFUNCTION(NetMulticast, Unreliable)
-	virtual void MultiCastRecieveMovement(const FMovementSnapshot& SentSnapShot);
+	virtual void MultiCastRecieveMovement(const FMovementSnapshotPacket& Packet);
 	
 	UPROPERTY(EditDefaultsOnly)
 		FPhysicsMovementReplication PhysicsReplicationData; //Physics Movement Replication Information and Data. Not replicated, but manually updated.
@@ -160,7 +288,8 @@ public:
 	virtual void Tick(float DeltaTime) override; //Overridden to allow us to update our custom movement
 	virtual UPawnMovementComponent* GetMovementComponent() const override;
 	virtual void PostInitializeComponents() override; //Overridden to set our required tick order & trigger the buoyant mesh setup
+	virtual void NotifyHit(class UPrimitiveComponent* MyComp, AActor* Other, class UPrimitiveComponent* OtherComp, bool bSelfMoved, FVector HitLocation, FVector HitNormal, FVector NormalImpulse, const FHitResult& Hit) override; //Overridden to resolve ship on ship collisions with lag compensation on the server
 protected:
 	UFUNCTION()
-	virtual void OnRep_ReplicatedMovement() override; //Overriden for collision resolution - STILL TODO.
+	virtual void OnRep_ReplicatedMovement() override; //ReplicatedMovement isn't used, see NotifyHit() for collision resolution
 };
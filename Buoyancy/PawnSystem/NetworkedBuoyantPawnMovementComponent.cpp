@@ -3,7 +3,7 @@
 *
 * Created by: Tobias Moos
 * Project name: Sails of War / OceanProject
-* Unreal Engine version: 4.19
+* Unreal Engine version: 4.22
 * Created on: 2020/01/08
 *
 * Last Edited on: 2020/03/6
@@ -23,6 +23,8 @@
 #include "NetworkedBuoyantPawnMovementComponent.h"
 #include "NetworkedBuoyantPawn.h"
 #include "BuoyantMeshComponent.h"
+#include "BuoyancyWorldSubsystem.h"
+#include "WaterHeightTileCache.h"
 
 // TODO FIX ME!
 //Project Includes:
@@ -47,6 +49,13 @@
 
 DECLARE_CYCLE_STAT(TEXT("UpdateWaterGrid"), STAT_WaterGrid, STATGROUP_BuoyancyPhysics);
 DECLARE_CYCLE_STAT(TEXT("UpdateBuoyantMeshData"), STAT_UpdateBuoyantMeshData, STATGROUP_BuoyancyPhysics);
+DECLARE_CYCLE_STAT(TEXT("SampleWaterAtHullVertices"), STAT_SampleWaterAtHullVertices, STATGROUP_BuoyancyPhysics);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Grid Sampled Evaluations"), STAT_GridSampledEvaluations, STATGROUP_BuoyancyPhysics);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Direct Sampled Evaluations"), STAT_DirectSampledEvaluations, STATGROUP_BuoyancyPhysics);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Water Height Samples"), STAT_WaterHeightSamples, STATGROUP_BuoyancyPhysics);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Grid Vertices Outside Footprint"), STAT_GridVerticesMaskedOut, STATGROUP_BuoyancyPhysics);
+DECLARE_CYCLE_STAT(TEXT("SeaStateProbe"), STAT_SeaStateProbe, STATGROUP_BuoyancyPhysics);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Water Grid Resolution Changes"), STAT_WaterGridResolutionChanges, STATGROUP_BuoyancyPhysics);
 DECLARE_CYCLE_STAT(TEXT("CutBuoyantTriangle"), STAT_CutPerTri, STATGROUP_BuoyancyPhysics);
 DECLARE_CYCLE_STAT(TEXT("SplitBuoyantTriangle"), STAT_SplitPerTri, STATGROUP_BuoyancyPhysics);
 DECLARE_CYCLE_STAT(TEXT("CalculateAndApplyWaterEntryForce"), STAT_WaterEntryForce, STATGROUP_BuoyancyPhysics);
@@ -145,15 +154,34 @@ void UNetworkedBuoyantPawnMovementComponent::SetBuoyantMesh(class UBuoyantMeshCo
 	{
 		BuoyantMesh = NewBuoyantMesh;
 		if (BuoyantMesh->GetStaticMesh() != nullptr)
-			CreateBuoyantData(BuoyantMesh, WaterGrid, BuoyancyData, BuoyantMesh->GetBodyInstance(), BuoyancyInformation.WaterGridCellSize, GetOwner()->GetActorLocation());
+		{
+			CreateBuoyantData(BuoyantMesh, WaterGrid, BuoyancyData, BuoyantMesh->GetBodyInstance(), GetWaterGridCellSize(), GetOwner()->GetActorLocation());
+			UpdateWaterSamplingMode(false);
+		}
 	}
 
 	OceanActor = USOWGameplayStatics::GetOceanActor(GetWorld());
+
+	UBuoyancyWorldSubsystem* BuoyancySubsystem = UBuoyancyWorldSubsystem::Get(this);
+	if (BuoyancySubsystem)
+		BuoyancySubsystem->RegisterBuoyantBody(this);
+}
+
+void UNetworkedBuoyantPawnMovementComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	UBuoyancyWorldSubsystem* BuoyancySubsystem = UBuoyancyWorldSubsystem::Get(this);
+	if (BuoyancySubsystem)
+		BuoyancySubsystem->UnregisterBuoyantBody(this);
+
+	Super::EndPlay(EndPlayReason);
 }
 
 void UNetworkedBuoyantPawnMovementComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction)
 {
 	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+	if (ShouldSimulateBuoyancy())
+		UpdateWaterGridResolution(DeltaTime);
+
 	ANetworkedBuoyantPawn* Pawn = Cast<ANetworkedBuoyantPawn>(GetOwner());
 	if (Pawn)
 	{
@@ -164,60 +192,526 @@ void UNetworkedBuoyantPawnMovementComponent::TickComponent(float DeltaTime, enum
 
 void UNetworkedBuoyantPawnMovementComponent::PhysicsSubstep(float DeltaSubstepTime, FBodyInstance* BodyInstance)
 {
-	ANetworkedBuoyantPawn* Pawn = Cast<ANetworkedBuoyantPawn>(GetOwner());
-	if (Pawn)
+	//Only update if the pawn is the authoritative (autonomous) client - this also supports listen servers
+	if (ShouldSimulateBuoyancy())
 	{
-		//Only update if the pawn is the authoritative (autonomous) client - this also supports listen servers
-		if (Pawn->Role == ROLE_AutonomousProxy || (Pawn->Role == ROLE_Authority && Pawn->IsLocallyControlled()))
+		SCOPE_CYCLE_COUNTER(STAT_Substep);
 		{
-			SCOPE_CYCLE_COUNTER(STAT_Substep);
+			if (ShouldEvaluateBuoyancy(DeltaSubstepTime, BodyInstance))
 			{
-				BuoyancyData.SubFrameCircularBuffer[0] = BuoyancyData.SubFrameCircularBuffer[1];
-				BuoyancyData.SubFrameCircularBuffer[1].Clear();
-				BodyInstanceTransform = BodyInstance->GetUnrealWorldTransform_AssumesLocked();
-				UpdateWaterGrid(DeltaSubstepTime, BodyInstance);
-				UpdateBuoyantMeshData(DeltaSubstepTime, BodyInstance);
-				PerformMovement(DeltaSubstepTime, BodyInstance);
+				BeginBuoyancySubstep(DeltaSubstepTime, BodyInstance);
+				EvaluateBuoyancySubstep(DeltaSubstepTime, BodyInstance);
+				ApplyBuoyancySubstep(DeltaSubstepTime, BodyInstance);
 			}
-		}	
+			else
+				ApplyHeldBuoyancySubstep(DeltaSubstepTime, BodyInstance, GetEvaluationHoldMode());
+		}
 	}
 }
 
-void UNetworkedBuoyantPawnMovementComponent::UpdateWaterGrid(float SubstepDeltaTime, FBodyInstance* BodyInstance)
+bool UNetworkedBuoyantPawnMovementComponent::ShouldSimulateBuoyancy() const
 {
-	SCOPE_CYCLE_COUNTER(STAT_WaterGrid);
+	const ANetworkedBuoyantPawn* Pawn = Cast<ANetworkedBuoyantPawn>(GetOwner());
+	if (Pawn)
+		return Pawn->Role == ROLE_AutonomousProxy || (Pawn->Role == ROLE_Authority && (Pawn->IsLocallyControlled() || Pawn->IsServerOwned()));
+
+	return false;
+}
+
+bool UNetworkedBuoyantPawnMovementComponent::WantsSubstepDebugDraw() const
+{
+#if ENABLE_DRAW_DEBUG
+	return bDebugDrawBuoyantForce || bDebugDrawWaterEntryForce || bDebugDrawPressureDragForce || bDebugDrawViscousWaterResistanceForce;
+#else
+	return false;
+#endif
+}
+
+bool UNetworkedBuoyantPawnMovementComponent::ShouldEvaluateBuoyancy(float SubstepDeltaTime, FBodyInstance* BodyInstance)
+{
+	if (UpdateRestState(SubstepDeltaTime, BodyInstance))
+	{
+		CurrentEvaluationRate = 0.0f;
+		return false;
+	}
+
+	const FBuoyancyEvaluationRate& EvaluationRate = BuoyancyInformation.EvaluationRate;
+	if (!EvaluationRate.bDecoupleFromSubsteps || !bHasEvaluatedBuoyancy)
+	{
+		CurrentEvaluationRate = 0.0f;
+		return true;
+	}
+
+	//Fast bodies and steep waves change the submerged hull quickly, raise the rate for whichever demands more
+	const float SpeedAlpha = EvaluationRate.SpeedForMaxRate > 0.0f ? BodyInstance->GetUnrealWorldVelocity_AssumesLocked().Size() / EvaluationRate.SpeedForMaxRate : 1.0f;
+	const float SteepnessAlpha = EvaluationRate.SteepnessForMaxRate > 0.0f ? WaterGridSteepness / EvaluationRate.SteepnessForMaxRate : 1.0f;
+	const float RateAlpha = FMath::Clamp(FMath::Max(SpeedAlpha, SteepnessAlpha), 0.0f, 1.0f);
+	CurrentEvaluationRate = FMath::Lerp(EvaluationRate.MinRate, FMath::Max(EvaluationRate.MinRate, EvaluationRate.MaxRate), RateAlpha);
+
+	//Evaluate on whichever sub-step lands closest to the interval
+	return TimeSinceBuoyancyEvaluation + (SubstepDeltaTime * 0.5f) >= 1.0f / CurrentEvaluationRate;
+}
+
+bool UNetworkedBuoyantPawnMovementComponent::UpdateRestState(float SubstepDeltaTime, FBodyInstance* BodyInstance)
+{
+	const FBuoyancyRestDetection& RestDetection = BuoyancyInformation.RestDetection;
+	if (!RestDetection.bEnableRestDetection || !bHasEvaluatedBuoyancy)
+	{
+		bAtRest = false;
+		TimeBelowRestThresholds = 0.0f;
+		return false;
+	}
+
+	const bool bBelowSpeedThresholds = BodyInstance->GetUnrealWorldVelocity_AssumesLocked().Size() <= RestDetection.MaxLinearSpeed
+		&& FMath::RadiansToDegrees(BodyInstance->GetUnrealWorldAngularVelocityInRadians_AssumesLocked().Size()) <= RestDetection.MaxAngularSpeed;
+	const FVector CenterOfMass = BodyInstance->GetCOMPosition();
+
+	if (!bAtRest)
+	{
+		TimeBelowRestThresholds = bBelowSpeedThresholds ? TimeBelowRestThresholds + SubstepDeltaTime : 0.0f;
+		if (TimeBelowRestThresholds < RestDetection.TimeBeforeRest || !SampleRestWaterHeight(CenterOfMass, RestWaterHeight))
+			return false;
+
+		//Come to rest about the pose of the last evaluation, it was made a sub-step ago at most
+		bAtRest = true;
+		TimeBelowRestThresholds = 0.0f;
+		RestTransform = BuoyancyData.SubFrameCircularBuffer[1].BodyTransform;
+		CurrentRestWaterHeight = RestWaterHeight;
+		if (RestDetection.bUseHydrostaticStiffness)
+		{
+			const float WeightDensity = BuoyancyInformation.BuoyancyCoefficient.Z * BuoyancyInformation.FluidDensity * -GetGravityZ();
+			RestStiffness = FHydrostaticStiffness(BuoyancyData.SubFrameCircularBuffer[1].BuoyantData.SubmergedTriangles, CenterOfMass, WeightDensity);
+		}
+
+		return true;
+	}
+
+	//Any threshold exceeded wakes the body, and it's re-evaluated right away
+	TimeBelowRestThresholds += SubstepDeltaTime;
+	const float OrientationChange = FMath::RadiansToDegrees(BodyInstance->GetUnrealWorldTransform_AssumesLocked().GetRotation().AngularDistance(RestTransform.GetRotation()));
+	const bool bRestExpired = RestDetection.MaxRestDuration > 0.0f && TimeBelowRestThresholds >= RestDetection.MaxRestDuration;
+	if (!bBelowSpeedThresholds || bRestExpired || OrientationChange > RestDetection.MaxOrientationChange
+		|| !SampleRestWaterHeight(CenterOfMass, CurrentRestWaterHeight) || FMath::Abs(CurrentRestWaterHeight - RestWaterHeight) > RestDetection.MaxWaterHeightChange)
+	{
+		bAtRest = false;
+		TimeBelowRestThresholds = 0.0f;
+		return false;
+	}
+
+	return true;
+}
+
+bool UNetworkedBuoyantPawnMovementComponent::SampleRestWaterHeight(const FVector& CenterOfMass, float& OutWaterHeight) const
+{
+	//IMPORT_TASK: Change to AGameState instead
+	ASOWGameState* SOWGS = GetWorld()->GetGameState<ASOWGameState>();
+	if (OceanActor == nullptr || SOWGS == nullptr)
+		return false;
+
+	OutWaterHeight = FWaterHeightTileCache::SampleOceanHeight(OceanActor, CenterOfMass, WaterGrid.CellSize, SOWGS->GetServerWorldTimeSeconds());
+	return true;
+}
+
+FBuoyancyWrench UNetworkedBuoyantPawnMovementComponent::GetRestWrench(FBodyInstance* BodyInstance) const
+{
+	const FBuoyancyWrench& Reference = BuoyancyData.SubFrameCircularBuffer[1].Wrench;
+	if (!BuoyancyInformation.RestDetection.bUseHydrostaticStiffness)
+		return Reference;
+
+	//Linearize about the rest pose - immersion is how far the body sank relative to the water
+	const FTransform CurrentTransform = BodyInstance->GetUnrealWorldTransform_AssumesLocked();
+	const FVector CenterOfMass = BodyInstance->GetCOMPosition();
+	const float Immersion = (Reference.CenterOfMass.Z - CenterOfMass.Z) + (CurrentRestWaterHeight - RestWaterHeight);
+
+	FVector RotationAxis;
+	float RotationAngle;
+	(CurrentTransform.GetRotation() * RestTransform.GetRotation().Inverse()).ToAxisAndAngle(RotationAxis, RotationAngle);
+	const FVector Rotation = RotationAxis * FMath::UnwindRadians(RotationAngle);
+
+	return RestStiffness.Evaluate(Reference, Immersion, Rotation, CenterOfMass);
+}
+
+void UNetworkedBuoyantPawnMovementComponent::BeginBuoyancySubstep(float SubstepDeltaTime, FBodyInstance* BodyInstance, const FWaterHeightTileCache* WaterHeightCache)
+{
+	BuoyancyData.SubFrameCircularBuffer[0] = BuoyancyData.SubFrameCircularBuffer[1];
+	BuoyancyData.SubFrameCircularBuffer[1].Clear();
+	BodyInstanceTransform = BodyInstance->GetUnrealWorldTransform_AssumesLocked();
+	BuoyancyData.SubFrameCircularBuffer[1].BodyTransform = BodyInstanceTransform;
+	BuoyancyData.SubFrameCircularBuffer[1].Wrench.Reset(BodyInstance->GetCOMPosition());
+	LastBuoyancyEvaluationInterval = TimeSinceBuoyancyEvaluation;
+	TimeSinceBuoyancyEvaluation = 0.0f;
+	bHasEvaluatedBuoyancy = true;
+
+	//Once per evaluation, the world's batch reads the grid's bounds and sampling mode before it's evaluated
+	UpdateWaterGridBounds(BodyInstance);
+
+	//Resolved on the calling thread, the evaluation may run on a worker that can't touch the world or its actors' state
+	if (WaterHeightCache != nullptr)
+	{
+		//Sample at the batch's ocean time so our heights agree with the grids of the bodies evaluated alongside us
+		SubstepOceanActor = WaterHeightCache->GetOceanActor();
+		SubstepOceanTime = WaterHeightCache->GetOceanTime();
+	}
+	else
 	{
-		UWorld* World = GetWorld();
-		if (!BodyInstance->GetBodyBounds().IsInsideXY(WaterGrid.GridBounds)) //We shouldn't need to transform the bounding box by the body's rotation
-			WaterGrid = FWaterGrid(BuoyancyInformation.WaterGridCellSize, BuoyantMesh->GetStaticMesh()->GetBoundingBox().GetSize(), BodyInstanceTransform.GetLocation());
-		
 		//IMPORT_TASK: Change to AGameState instead
 		//UPDATE_TASK: Correctly update the server time to prevent drift by overriding GetServerWorldTimeSeconds()
-		//UPDATE_TASK: Profile cost of using 2 non-linear equations instead of 4 extra queries.
 		ASOWGameState* SOWGS = GetWorld()->GetGameState<ASOWGameState>();
-		if (SOWGS)
+		SubstepOceanActor = SOWGS ? OceanActor : nullptr;
+		SubstepOceanTime = SOWGS ? SOWGS->GetServerWorldTimeSeconds() : 0.0f;
+	}
+}
+
+bool UNetworkedBuoyantPawnMovementComponent::EvaluateBuoyancySubstep(float SubstepDeltaTime, FBodyInstance* BodyInstance, const FWaterHeightTileCache* WaterHeightCache, bool bSampleCacheMisses)
+{
+	if (bUseDirectWaterSampling)
+	{
+		INC_DWORD_STAT(STAT_DirectSampledEvaluations);
+		SampleWaterAtHullVertices(BodyInstance);
+		if (BuoyancyInformation.EvaluationRate.bDecoupleFromSubsteps)
+			WaterGridSteepness = CalculateHullWaterSteepness();
+	}
+	else
+	{
+		if (!UpdateWaterGrid(SubstepDeltaTime, BodyInstance, WaterHeightCache, bSampleCacheMisses))
+			return false;
+
+		INC_DWORD_STAT(STAT_GridSampledEvaluations);
+		if (BuoyancyInformation.EvaluationRate.bDecoupleFromSubsteps)
+			WaterGridSteepness = CalculateWaterGridSteepness();
+	}
+
+	UpdateBuoyantMeshData(SubstepDeltaTime, BodyInstance);
+	return true;
+}
+
+void UNetworkedBuoyantPawnMovementComponent::ApplyBuoyancySubstep(float SubstepDeltaTime, FBodyInstance* BodyInstance)
+{
+	//Interpolated forces trail one evaluation behind, start from the previous wrench to stay continuous with the held sub-steps
+	if (BuoyancyInformation.EvaluationRate.bDecoupleFromSubsteps && GetEvaluationHoldMode() == EBuoyancyForceHoldMode::Interpolate)
+		GetHeldWrench(EBuoyancyForceHoldMode::Interpolate).ApplyToBody(BodyInstance);
+	else
+		BuoyancyData.SubFrameCircularBuffer[1].Wrench.ApplyToBody(BodyInstance);
+
+	PerformMovement(SubstepDeltaTime, BodyInstance);
+	TimeSinceBuoyancyEvaluation += SubstepDeltaTime;
+}
+
+void UNetworkedBuoyantPawnMovementComponent::ApplyHeldBuoyancySubstep(float SubstepDeltaTime, FBodyInstance* BodyInstance, EBuoyancyForceHoldMode HoldMode)
+{
+	//A resting body's cached forces are a better estimate than anything extrapolated from the last evaluations
+	const FBuoyancyWrench HeldWrench = bAtRest ? GetRestWrench(BodyInstance) : GetHeldWrench(HoldMode);
+	HeldWrench.ApplyToBody(BodyInstance);
+	PerformMovement(SubstepDeltaTime, BodyInstance);
+	TimeSinceBuoyancyEvaluation += SubstepDeltaTime;
+}
+
+FBuoyancyWrench UNetworkedBuoyantPawnMovementComponent::GetHeldWrench(EBuoyancyForceHoldMode HoldMode) const
+{
+	//The sub frame buffer only rotates when the hull is evaluated, so [0] is always the previous evaluation
+	const FBuoyancyWrench& Latest = BuoyancyData.SubFrameCircularBuffer[1].Wrench;
+	const FBuoyancyWrench& Previous = BuoyancyData.SubFrameCircularBuffer[0].Wrench;
+	if (HoldMode == EBuoyancyForceHoldMode::Hold || FMath::IsNearlyZero(LastBuoyancyEvaluationInterval))
+		return Latest;
+
+	//Never extrapolate further than one evaluation interval ahead
+	const float Alpha = FMath::Clamp(TimeSinceBuoyancyEvaluation / LastBuoyancyEvaluationInterval, 0.0f, 1.0f);
+	if (HoldMode == EBuoyancyForceHoldMode::Interpolate)
+	{
+		FBuoyancyWrench Interpolated = Latest;
+		Interpolated.Force = FMath::Lerp(Previous.Force, Latest.Force, Alpha);
+		Interpolated.Torque = FMath::Lerp(Previous.Torque, Latest.Torque, Alpha);
+		return Interpolated;
+	}
+
+	FBuoyancyWrench Extrapolated = Latest;
+	Extrapolated.Force += (Latest.Force - Previous.Force) * Alpha;
+	Extrapolated.Torque += (Latest.Torque - Previous.Torque) * Alpha;
+	return Extrapolated;
+}
+
+bool UNetworkedBuoyantPawnMovementComponent::UpdateWaterGrid(float SubstepDeltaTime, FBodyInstance* BodyInstance, const FWaterHeightTileCache* WaterHeightCache, bool bSampleCacheMisses)
+{
+	SCOPE_CYCLE_COUNTER(STAT_WaterGrid);
+	{
+		const int32 NumGridVertices = (int32(WaterGrid.GridSize.X) + 1) * (int32(WaterGrid.GridSize.Y) + 1);
+		INC_DWORD_STAT_BY(STAT_GridVerticesMaskedOut, NumGridVertices - WaterGrid.GetNumSampledVertices());
+
+		//The world's shared cache holds this sub-step's heights when we're simulated as part of its batch
+		if (WaterHeightCache != nullptr && WaterHeightCache->ReadGridHeights(WaterGrid))
+			return true;
+
+		//A worker leaves tiles the batch didn't sample to the calling thread
+		if (!bSampleCacheMisses)
+			return false;
+
+		if (SubstepOceanActor)
 		{
+			INC_DWORD_STAT_BY(STAT_WaterHeightSamples, WaterGrid.GetNumSampledVertices());
 			for (int PRow = 0; PRow < WaterGrid.Vertices.Num(); PRow++)
 			{
-				for (int PCol = 0; PCol < WaterGrid.Vertices[PRow].Num(); PCol++)
+				const FIntPoint Columns = WaterGrid.GetSampledVertexColumns(PRow);
+				for (int PCol = Columns.X; PCol <= Columns.Y; PCol++)
 				{
-					//FVector TempVector = OceanActor->GetOceanVector(WaterGrid.Vertices[PRow][PCol].Vertex, SOWGS->GetServerWorldTimeSeconds());
-					//WaterGrid.Vertices[PRow][PCol].Vertex.Z = OceanActor->GetOceanHeight(WaterGrid.Vertices[PRow][PCol].Vertex - TempVector, SOWGS->GetServerWorldTimeSeconds());
-					const FVector& InputVert = WaterGrid.Vertices[PRow][PCol].Vertex;
-					FVector A = FVector(WaterGrid.CellSize * 0.5f, -WaterGrid.CellSize * 0.5f, 0.0f);
-					FVector B = FVector(-WaterGrid.CellSize * 0.5f, -WaterGrid.CellSize * 0.5f, 0.0f);
-					FVector C = FVector(WaterGrid.CellSize * 0.5f, WaterGrid.CellSize * 0.5f, 0.0f);
-					FVector D = FVector(-WaterGrid.CellSize * 0.5f, WaterGrid.CellSize * 0.5f, 0.0f);
-					FVector OutputA = OceanActor->GetOceanVector(InputVert + A, SOWGS->GetServerWorldTimeSeconds());
-					FVector OutputB = OceanActor->GetOceanVector(InputVert + B, SOWGS->GetServerWorldTimeSeconds());
-					FVector OutputC = OceanActor->GetOceanVector(InputVert + C, SOWGS->GetServerWorldTimeSeconds());
-					FVector OutputD = OceanActor->GetOceanVector(InputVert + D, SOWGS->GetServerWorldTimeSeconds());
-					FVector Output = (OutputA + OutputB + OutputC + OutputD) / 4.0f;
-					WaterGrid.Vertices[PRow][PCol].Vertex.Z = OceanActor->GetOceanHeight(InputVert - Output, SOWGS->GetServerWorldTimeSeconds());
+					FVector& Vertex = WaterGrid.Vertices[PRow][PCol].Vertex;
+					Vertex.Z = FWaterHeightTileCache::SampleOceanHeight(SubstepOceanActor, Vertex, WaterGrid.CellSize, SubstepOceanTime);
 				}
 			}
 		}	
 	}
+
+	return true;
+}
+
+void UNetworkedBuoyantPawnMovementComponent::UpdateWaterGridBounds(FBodyInstance* BodyInstance)
+{
+	//A new cell size picked on the game thread is applied here, between evaluations
+	const float CellSize = GetWaterGridCellSize();
+	if (WaterGrid.CellSize != CellSize || !BodyInstance->GetBodyBounds().IsInsideXY(WaterGrid.GridBounds)) //We shouldn't need to transform the bounding box by the body's rotation
+		WaterGrid = FWaterGrid(CellSize, BuoyantMesh->GetStaticMesh()->GetBoundingBox().GetSize(), BodyInstanceTransform.GetLocation());
+
+	UpdateWaterGridFootprint();
+	UpdateWaterSamplingMode();
+}
+
+void UNetworkedBuoyantPawnMovementComponent::UpdateWaterGridResolution(float DeltaTime)
+{
+	const FWaterGridResolution& Resolution = BuoyancyInformation.GridResolution;
+	if (!Resolution.bAdaptiveCellSize || BuoyancyInformation.WaterSamplingMode == EWaterSamplingMode::Direct || OceanActor == nullptr || BuoyantMesh == nullptr || BuoyantMesh->GetStaticMesh() == nullptr)
+	{
+		AdaptiveWaterGridCellSize = 0;
+		return;
+	}
+
+	TimeUntilSeaStateProbe -= DeltaTime;
+	if (TimeUntilSeaStateProbe > 0.0f)
+		return;
+
+	//IMPORT_TASK: Change to AGameState instead
+	ASOWGameState* SOWGS = GetWorld()->GetGameState<ASOWGameState>();
+	if (SOWGS == nullptr)
+		return;
+
+	SCOPE_CYCLE_COUNTER(STAT_SeaStateProbe);
+	{
+		TimeUntilSeaStateProbe = Resolution.ProbeInterval;
+		const float OceanTime = SOWGS->GetServerWorldTimeSeconds();
+		EstimatedWavelength = Resolution.EstimateShortestWavelength([this, OceanTime](const FVector& Location) { return OceanActor->GetOceanHeight(Location, OceanTime); }, BuoyantMesh->GetComponentLocation(), ProbeHeights);
+
+		//Small changes of the sea state aren't worth resampling a new grid for
+		const float HullSize = BuoyantMesh->GetStaticMesh()->GetBoundingBox().GetSize().GetMax(); //FWaterGrid is sized by the largest side too
+		const int32 NewCellSize = Resolution.PickCellSize(EstimatedWavelength, HullSize);
+		const float CurrentCellSize = GetWaterGridCellSize();
+		if (AdaptiveWaterGridCellSize.Load() > 0 && FMath::Abs(NewCellSize - CurrentCellSize) <= CurrentCellSize * Resolution.ChangeThreshold)
+			return;
+
+		//Handed to the physics thread whole, the next sub-step rebuilds the grid with it
+		AdaptiveWaterGridCellSize = NewCellSize;
+		INC_DWORD_STAT(STAT_WaterGridResolutionChanges);
+		UE_LOG(LogTemp, Log, TEXT("%s: Water grid cell size %d cm for a %.0f cm wavelength, at most %d grid samples"), *GetNameSafe(GetOwner()), NewCellSize, EstimatedWavelength, FWaterGridResolution::GetMaxGridVertices(HullSize, NewCellSize));
+	}
+}
+
+float FWaterGridResolution::EstimateShortestWavelength(TFunctionRef<float(const FVector&)> GetWaterHeight, const FVector& Center, TArray<float>& Heights) const
+{
+	const int32 NumSamples = FMath::Max(NumProbeSamples, 8);
+	const float Spacing = ProbeSpacing;
+	const float HalfLength = Spacing * (NumSamples - 1) * 0.5f;
+
+	//Waves crossing a transect at an angle look longer along it, the perpendicular transect sees them closer to their true length
+	const FVector Directions[2] = { FVector(1.0f, 0.0f, 0.0f), FVector(0.0f, 1.0f, 0.0f) };
+	double SlopeSquaredSum = 0.0, CurvatureSquaredSum = 0.0;
+	int32 NumSlopes = 0, NumCurvatures = 0;
+	Heights.SetNumUninitialized(NumSamples, false);
+	for (const FVector& Direction : Directions)
+	{
+		for (int32 SampleIndex = 0; SampleIndex < NumSamples; SampleIndex++)
+			Heights[SampleIndex] = GetWaterHeight(Center + Direction * ((SampleIndex * Spacing) - HalfLength));
+
+		for (int32 SampleIndex = 1; SampleIndex < NumSamples; SampleIndex++)
+		{
+			const float Slope = (Heights[SampleIndex] - Heights[SampleIndex - 1]) / Spacing;
+			SlopeSquaredSum += Slope * Slope;
+			NumSlopes++;
+			if (SampleIndex + 1 < NumSamples)
+			{
+				const float Curvature = (Heights[SampleIndex + 1] - (2.0f * Heights[SampleIndex]) + Heights[SampleIndex - 1]) / (Spacing * Spacing);
+				CurvatureSquaredSum += Curvature * Curvature;
+				NumCurvatures++;
+			}
+		}
+	}
+
+	const double M2 = SlopeSquaredSum / NumSlopes;
+	const double M4 = CurvatureSquaredSum / NumCurvatures;
+	if (FMath::Sqrt(M2) < MinSignificantSlope || M4 <= 0.0)
+		return 0.0f;
+
+	return float(2.0 * PI * FMath::Sqrt(M2 / M4));
+}
+
+int32 FWaterGridResolution::PickCellSize(float Wavelength, float HullSize) const
+{
+	float CellSize = Wavelength > 0.0f ? Wavelength / SamplesPerWavelength : MaxCellSize;
+	CellSize = FMath::Clamp(CellSize, MinCellSize, FMath::Max(MaxCellSize, MinCellSize));
+	CellSize = FMath::Max(FMath::Min(CellSize, HullSize / FMath::Max(MinCellsAlongHull, 1)), MinCellSize);
+
+	//The sample budget wins over the waves and the hull
+	const float BudgetCellSize = HullSize / FMath::Max(FMath::FloorToFloat(FMath::Sqrt(float(MaxGridSamples))) - 2.0f, 1.0f);
+	CellSize = FMath::Max(CellSize, BudgetCellSize);
+
+	//Rounding up keeps the grid within the budget, and whole centimeters keep the grid on the vertices of the cache's tiles
+	const int32 Step = FMath::Max(CellSizeStep, 1);
+	int32 PickedCellSize = FMath::CeilToInt(CellSize / Step) * Step;
+
+	//A budget cell that divides the hull exactly can still round to one more cell per side, budgets under 9 samples can't be met at all
+	while (MaxGridSamples >= 9 && GetMaxGridVertices(HullSize, PickedCellSize) > MaxGridSamples)
+		PickedCellSize += Step;
+
+	return PickedCellSize;
+}
+
+int32 FWaterGridResolution::GetMaxGridVertices(float HullSize, float CellSize)
+{
+	const int32 VerticesPerSide = FMath::CeilToInt(HullSize / CellSize) + 2;
+	return VerticesPerSide * VerticesPerSide;
+}
+
+void UNetworkedBuoyantPawnMovementComponent::UpdateWaterGridFootprint()
+{
+	//The grid isn't sampled at all while the hull's vertices are
+	if (!BuoyancyInformation.bMaskGridToFootprint || BuoyancyInformation.WaterSamplingMode == EWaterSamplingMode::Direct || BuoyantMesh == nullptr || BuoyantMesh->GetStaticMesh() == nullptr)
+	{
+		if (WaterGrid.IsFootprintMasked())
+			WaterGrid.ClearFootprintMask();
+		return;
+	}
+
+	//The bounding box's corners rotated like FBuoyantMeshData's vertices, their convex hull on the water plane is the footprint
+	const FBox LocalBounds = BuoyantMesh->GetStaticMesh()->GetBoundingBox();
+	const FQuat Rotation = BodyInstanceTransform.GetRotation();
+	const FVector Translation = BodyInstanceTransform.GetTranslation();
+	FootprintPoints.SetNumUninitialized(8, false);
+	for (int32 Corner = 0; Corner < 8; Corner++)
+	{
+		const FVector LocalCorner = FVector((Corner & 1) ? LocalBounds.Max.X : LocalBounds.Min.X, (Corner & 2) ? LocalBounds.Max.Y : LocalBounds.Min.Y, (Corner & 4) ? LocalBounds.Max.Z : LocalBounds.Min.Z);
+		FootprintPoints[Corner] = FVector2D(Rotation.RotateVector(LocalCorner) + Translation);
+	}
+
+	WaterGrid.SetFootprintMask(FootprintPoints, BuoyancyInformation.FootprintMaskMargin);
+}
+
+void UNetworkedBuoyantPawnMovementComponent::UpdateWaterSamplingMode(bool bApplyHysteresis)
+{
+	switch (BuoyancyInformation.WaterSamplingMode)
+	{
+	case EWaterSamplingMode::Grid:
+		bUseDirectWaterSampling = false;
+		break;
+	case EWaterSamplingMode::Direct:
+		bUseDirectWaterSampling = true;
+		break;
+	default:
+		{
+			/*
+			* Both paths query the ocean 5 times per sample (see FWaterHeightTileCache::SampleOceanHeight()), so the cost comes down to
+			* the number of samples - every grid vertex against every unique hull vertex. Sampling directly also skips projecting
+			* each hull vertex onto the grid, which the scale doesn't account for.
+			*/
+			const int32 NumGridVertices = WaterGrid.GetNumSampledVertices();
+			const int32 NumHullVertices = BuoyancyData.MeshData.UniqueVertices.Num();
+			const float DirectCost = NumHullVertices * BuoyancyInformation.DirectSamplingCostScale;
+			if (NumHullVertices <= 0)
+				bUseDirectWaterSampling = false;
+			else if (!bApplyHysteresis)
+				bUseDirectWaterSampling = DirectCost < NumGridVertices;
+			//The two paths don't produce the same forces, only switch once the other one is clearly cheaper so the footprint's rotation can't flip it back and forth
+			else if (bUseDirectWaterSampling)
+				bUseDirectWaterSampling = DirectCost < NumGridVertices * (1.0f + BuoyancyInformation.SamplingModeHysteresis);
+			else
+				bUseDirectWaterSampling = DirectCost * (1.0f + BuoyancyInformation.SamplingModeHysteresis) < NumGridVertices;
+		}
+		break;
+	}
+}
+
+void UNetworkedBuoyantPawnMovementComponent::SampleWaterAtHullVertices(FBodyInstance* BodyInstance)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SampleWaterAtHullVertices);
+	{
+		const TArray<FMeshVertex>& UniqueVertices = BuoyancyData.MeshData.UniqueVertices;
+		DirectSamplePoints.SetNumUninitialized(UniqueVertices.Num(), false);
+		DirectSampleHeights.SetNumUninitialized(UniqueVertices.Num(), false);
+
+		const FQuat Rotation = BodyInstanceTransform.GetRotation();
+		const FVector Translation = BodyInstanceTransform.GetTranslation();
+		for (int32 VertIndex = 0; VertIndex < UniqueVertices.Num(); VertIndex++)
+			DirectSamplePoints[VertIndex] = Rotation.RotateVector(UniqueVertices[VertIndex].Vertex) + Translation; //Matches FBuoyantMeshData, ignores scale
+
+		//Without an ocean the hull sits on flat water at zero like a freshly built grid, the last sub-step's heights mustn't linger
+		if (SubstepOceanActor == nullptr)
+		{
+			for (float& Height : DirectSampleHeights)
+				Height = 0.0f;
+			return;
+		}
+
+		INC_DWORD_STAT_BY(STAT_WaterHeightSamples, DirectSamplePoints.Num());
+		for (int32 VertIndex = 0; VertIndex < DirectSamplePoints.Num(); VertIndex++)
+			DirectSampleHeights[VertIndex] = FWaterHeightTileCache::SampleOceanHeight(SubstepOceanActor, DirectSamplePoints[VertIndex], WaterGrid.CellSize, SubstepOceanTime);
+	}
+}
+
+float UNetworkedBuoyantPawnMovementComponent::CalculateHullWaterSteepness() const
+{
+	const TArray<int32>& Indices = BuoyancyData.MeshData.Vertices;
+	float MaxSlope = 0.0f;
+	for (int32 TriIndex = 0; TriIndex < Indices.Num() / 3; TriIndex++)
+	{
+		for (int32 Edge = 0; Edge < 3; Edge++)
+		{
+			const int32 IndexA = Indices[TriIndex * 3 + Edge];
+			const int32 IndexB = Indices[TriIndex * 3 + (Edge + 1) % 3];
+			if (!DirectSamplePoints.IsValidIndex(IndexA) || !DirectSamplePoints.IsValidIndex(IndexB))
+				continue;
+
+			//Near vertical edges span no water, their slope is meaningless
+			const float Distance = FVector::Dist2D(DirectSamplePoints[IndexA], DirectSamplePoints[IndexB]);
+			if (Distance > 1.0f)
+				MaxSlope = FMath::Max(MaxSlope, FMath::Abs(DirectSampleHeights[IndexA] - DirectSampleHeights[IndexB]) / Distance);
+		}
+	}
+
+	return MaxSlope;
+}
+
+float UNetworkedBuoyantPawnMovementComponent::GetDepthForPoint(const FVector& Point, const FBuoyantTriangle& Triangle)
+{
+	return bUseDirectWaterSampling ? Triangle.GetInterpolatedDepth(Point) : WaterGrid.GetDepthForPoint(Point);
+}
+
+float UNetworkedBuoyantPawnMovementComponent::CalculateWaterGridSteepness() const
+{
+	if (WaterGrid.CellSize <= 0.0f)
+		return 0.0f;
+
+	float MaxHeightDifference = 0.0f;
+	for (int32 Row = 0; Row < WaterGrid.Vertices.Num(); Row++)
+	{
+		//Only compare sampled vertices, the rest hold heights from whenever they were last inside the footprint
+		const FIntPoint Columns = WaterGrid.GetSampledVertexColumns(Row);
+		const FIntPoint NextColumns = Row + 1 < WaterGrid.Vertices.Num() ? WaterGrid.GetSampledVertexColumns(Row + 1) : FIntPoint(0, -1);
+		for (int32 Col = Columns.X; Col <= Columns.Y; Col++)
+		{
+			const float Height = WaterGrid.Vertices[Row][Col].Vertex.Z;
+			if (Col >= NextColumns.X && Col <= NextColumns.Y)
+				MaxHeightDifference = FMath::Max(MaxHeightDifference, FMath::Abs(WaterGrid.Vertices[Row + 1][Col].Vertex.Z - Height));
+			if (Col + 1 <= Columns.Y)
+				MaxHeightDifference = FMath::Max(MaxHeightDifference, FMath::Abs(WaterGrid.Vertices[Row][Col + 1].Vertex.Z - Height));
+		}
+	}
+
+	return MaxHeightDifference / WaterGrid.CellSize;
 }
 
 void UNetworkedBuoyantPawnMovementComponent::UpdateBuoyantMeshData(float SubstepDeltaTime, FBodyInstance* BodyInstance)
@@ -225,10 +719,16 @@ void UNetworkedBuoyantPawnMovementComponent::UpdateBuoyantMeshData(float Substep
 	SCOPE_CYCLE_COUNTER(STAT_UpdateBuoyantMeshData);
 	{
 		FBuoyantMeshData NewBuoyantMeshData;
+		float EvaluationDeltaTime = SubstepDeltaTime;
 		SCOPE_CYCLE_COUNTER(STAT_BuoyantMeshDataCreation);
 		{
 			BuoyancyData.SubFrameCircularBuffer[1].DeltaTime = SubstepDeltaTime;
-			NewBuoyantMeshData = FBuoyantMeshData(BuoyancyData.MeshData.UniqueVertices, BuoyancyData.MeshData.Vertices, WaterGrid, BodyInstanceTransform, BodyInstance);
+			//The slamming force compares against the previous evaluation, which may be several sub-steps old
+			EvaluationDeltaTime = LastBuoyancyEvaluationInterval > 0.0f ? LastBuoyancyEvaluationInterval : SubstepDeltaTime;
+			if (bUseDirectWaterSampling)
+				NewBuoyantMeshData = FBuoyantMeshData(DirectSamplePoints, DirectSampleHeights, BuoyancyData.MeshData.Vertices, BodyInstanceTransform, BodyInstance);
+			else
+				NewBuoyantMeshData = FBuoyantMeshData(BuoyancyData.MeshData.UniqueVertices, BuoyancyData.MeshData.Vertices, WaterGrid, BodyInstanceTransform, BodyInstance);
 		}
 
 		//Intersect the triangles and create the necessary sub-triangles
@@ -240,13 +740,13 @@ void UNetworkedBuoyantPawnMovementComponent::UpdateBuoyantMeshData(float Substep
 			{
 				for (FBuoyantTriangle& SubmergedTriangle : CutSubmergedTris)
 				{
-					SubmergedTriangle.Depth = WaterGrid.GetDepthForPoint(SubmergedTriangle.Center);
+					SubmergedTriangle.Depth = GetDepthForPoint(SubmergedTriangle.Center, NewBuoyantMeshData.Triangles[TriIndex]);
 					if (SubmergedTriangle.Depth < 0.0f) //Catch a case where the triangle's center could be above water, but its vertices aren't.
 						NewBuoyantMeshData.Triangles[TriIndex].CutSubmergedArea += SubmergedTriangle.Area;
 				}
 
-				//This force has to applied before getting velocities for other forces
-				CalculateAndApplyWaterEntryForce(TriIndex, NewBuoyantMeshData.Triangles[TriIndex], SubstepDeltaTime, BodyInstance);
+				//This force has to be accumulated before getting velocities for other forces
+				CalculateAndApplyWaterEntryForce(TriIndex, NewBuoyantMeshData.Triangles[TriIndex], EvaluationDeltaTime, BodyInstance);
 				
 				//Split each submerged triangle and apply their forces
 				for (FBuoyantTriangle& SubmergedTriangle : CutSubmergedTris)
@@ -264,11 +764,8 @@ void UNetworkedBuoyantPawnMovementComponent::UpdateBuoyantMeshData(float Substep
 							UKismetSystemLibrary::DrawDebugArrow(GetWorld(), SplitTriangleTwo.ForceCenter, SplitTriangleTwo.ForceCenter + SplitTriangleTwo.HydrostaticForce / ForceLengthScalar, 15.0f, FLinearColor::Blue, 0.0f, 1.0f);
 						}
 
-						if (!FMath::IsNearlyZero(SplitTriangleOne.HydrostaticForce.Size()))
-							BodyInstance->AddForceAtPosition(SplitTriangleOne.HydrostaticForce, SplitTriangleOne.ForceCenter, false);
-
-						if (!FMath::IsNearlyZero(SplitTriangleOne.HydrostaticForce.Size()))
-							BodyInstance->AddForceAtPosition(SplitTriangleTwo.HydrostaticForce, SplitTriangleTwo.ForceCenter, false);
+						BuoyancyData.SubFrameCircularBuffer[1].Wrench.AddForceAtPosition(SplitTriangleOne.HydrostaticForce, SplitTriangleOne.ForceCenter);
+						BuoyancyData.SubFrameCircularBuffer[1].Wrench.AddForceAtPosition(SplitTriangleTwo.HydrostaticForce, SplitTriangleTwo.ForceCenter);
 
 						ApplyDampingForcesForTriangle(SubmergedTriangle, SubstepDeltaTime, BodyInstance);
 					}
@@ -296,7 +793,7 @@ bool UNetworkedBuoyantPawnMovementComponent::CutBuoyantTriangle(const FBuoyantTr
 			if (VertsByDepth[VertH].IsSubmerged())
 			{
 				FVector TriCenter = (VertsByDepth[VertH].Vertex + VertsByDepth[VertM].Vertex + VertsByDepth[VertL].Vertex) / 3.0f;
-				FBuoyantTriangle SubmergedTriangle = FBuoyantTriangle(VertsByDepth[VertH], VertsByDepth[VertM], VertsByDepth[VertL], WaterGrid.GetDepthForPoint(TriCenter), BodyInstance, MeshCenterLocation);
+				FBuoyantTriangle SubmergedTriangle = FBuoyantTriangle(VertsByDepth[VertH], VertsByDepth[VertM], VertsByDepth[VertL], GetDepthForPoint(TriCenter, UnCutTriangle), BodyInstance, MeshCenterLocation);
 				CutSubmergedTriangles.Add(SubmergedTriangle);
 				return true;
 			}
@@ -319,8 +816,8 @@ bool UNetworkedBuoyantPawnMovementComponent::CutBuoyantTriangle(const FBuoyantTr
 					const FVector LH = VertexH - VertexL;
 					const float TL = -DepthL / (DepthH - DepthL);
 					FVector IL = (TL * LH) + VertexL;
-					FBuoyantVertex VertexIM = FBuoyantVertex(IM, WaterGrid.GetDepthForPoint(IM));
-					FBuoyantVertex VertexIL = FBuoyantVertex(IL, WaterGrid.GetDepthForPoint(IL));
+					FBuoyantVertex VertexIM = FBuoyantVertex(IM, GetDepthForPoint(IM, UnCutTriangle));
+					FBuoyantVertex VertexIL = FBuoyantVertex(IL, GetDepthForPoint(IL, UnCutTriangle));
 					WaterLineVertices.Add(VertexIM);
 					WaterLineVertices.Add(VertexIL);
 
@@ -328,12 +825,12 @@ bool UNetworkedBuoyantPawnMovementComponent::CutBuoyantTriangle(const FBuoyantTr
 
 					//Submerged Sub-Triangle One -  (IM, M, L)
 					FVector TriCenterOne = (VertexIM.Vertex + VertsByDepth[VertM].Vertex + VertsByDepth[VertL].Vertex) / 3.0f;
-					FBuoyantTriangle SubmergedTriangleOne = FBuoyantTriangle(VertexIM, VertsByDepth[VertM], VertsByDepth[VertL], WaterGrid.GetDepthForPoint(TriCenterOne), BodyInstance, MeshCenterLocation);
+					FBuoyantTriangle SubmergedTriangleOne = FBuoyantTriangle(VertexIM, VertsByDepth[VertM], VertsByDepth[VertL], GetDepthForPoint(TriCenterOne, UnCutTriangle), BodyInstance, MeshCenterLocation);
 					CutSubmergedTriangles.Add(SubmergedTriangleOne);
 
 					//Submerged Sub-Triangle Two - (IL, IM, L)
 					FVector TriCenterTwo = (VertexIL.Vertex + VertexIM.Vertex + VertsByDepth[VertL].Vertex) / 3.0f;
-					FBuoyantTriangle SubmergedTriangleTwo = FBuoyantTriangle(VertexIL, VertexIM, VertsByDepth[VertL], WaterGrid.GetDepthForPoint(TriCenterTwo), BodyInstance, MeshCenterLocation);
+					FBuoyantTriangle SubmergedTriangleTwo = FBuoyantTriangle(VertexIL, VertexIM, VertsByDepth[VertL], GetDepthForPoint(TriCenterTwo, UnCutTriangle), BodyInstance, MeshCenterLocation);
 					CutSubmergedTriangles.Add(SubmergedTriangleTwo);
 				}
 				//One submerged vertex - One submerged triangle, two surfaced triangles
@@ -346,14 +843,14 @@ bool UNetworkedBuoyantPawnMovementComponent::CutBuoyantTriangle(const FBuoyantTr
 					const FVector HL = VertexH - VertexL;
 					const float JLMult = -DepthL / (DepthH - DepthL);
 					FVector JL = (JLMult * HL) + VertexL;
-					FBuoyantVertex VertexJM = FBuoyantVertex(JM, WaterGrid.GetDepthForPoint(JM));
-					FBuoyantVertex VertexJL = FBuoyantVertex(JL, WaterGrid.GetDepthForPoint(JL));
+					FBuoyantVertex VertexJM = FBuoyantVertex(JM, GetDepthForPoint(JM, UnCutTriangle));
+					FBuoyantVertex VertexJL = FBuoyantVertex(JL, GetDepthForPoint(JL, UnCutTriangle));
 					WaterLineVertices.Add(VertexJM);
 					WaterLineVertices.Add(VertexJL);
 					
 					//Submerged Sub-Triangle - (L, JL, JM)
 					FVector TriCenter = (VertsByDepth[VertL].Vertex + VertexJL.Vertex + VertexJM.Vertex) / 3.0f;
-					FBuoyantTriangle SubmergedTriangle = FBuoyantTriangle(VertsByDepth[VertL], VertexJL, VertexJM, WaterGrid.GetDepthForPoint(TriCenter), BodyInstance, MeshCenterLocation);
+					FBuoyantTriangle SubmergedTriangle = FBuoyantTriangle(VertsByDepth[VertL], VertexJL, VertexJM, GetDepthForPoint(TriCenter, UnCutTriangle), BodyInstance, MeshCenterLocation);
 					CutSubmergedTriangles.Add(SubmergedTriangle);
 
 					//Surfaced Sub-Triangle One - (H, M, JM)
@@ -388,15 +885,15 @@ void UNetworkedBuoyantPawnMovementComponent::SplitBuoyantTriangle(FBuoyantTriang
 		float HeightHM = VertexH.Z - VertexM.Z;
 		float HeightHL = VertexH.Z - VertexL.Z;
 		FVector HorizontalCut = ((HL * HeightHM) / HeightHL) + VertexH;
-		float BandCutHeight = WaterGrid.GetDepthForPoint(HorizontalCut);
+		float BandCutHeight = GetDepthForPoint(HorizontalCut, UnSplitTriangle);
 		FBuoyantVertex FVertexL = FBuoyantVertex(VertexL, DepthL);
 		FBuoyantVertex FVertexM = FBuoyantVertex(VertexM, DepthM);
 		FBuoyantVertex FVertexH = FBuoyantVertex(VertexH, DepthH);
 		FBuoyantVertex FVertexCut = FBuoyantVertex(HorizontalCut, BandCutHeight);
 		FVector TriUpCenter = (FVertexH.Vertex + FVertexM.Vertex + FVertexCut.Vertex) / 3.0f;
-		SplitTriangleUp = FBuoyantTriangle(FVertexH, FVertexM, FVertexCut, WaterGrid.GetDepthForPoint(TriUpCenter), true, BodyInstance, MeshCenterLocation);
+		SplitTriangleUp = FBuoyantTriangle(FVertexH, FVertexM, FVertexCut, GetDepthForPoint(TriUpCenter, UnSplitTriangle), true, BodyInstance, MeshCenterLocation);
 		FVector TriDownCenter = (FVertexM.Vertex + FVertexCut.Vertex + FVertexL.Vertex) / 3.0f;
-		SplitTriangleDown = FBuoyantTriangle(FVertexM, FVertexCut, FVertexL, WaterGrid.GetDepthForPoint(TriDownCenter), false, BodyInstance, MeshCenterLocation);
+		SplitTriangleDown = FBuoyantTriangle(FVertexM, FVertexCut, FVertexL, GetDepthForPoint(TriDownCenter, UnSplitTriangle), false, BodyInstance, MeshCenterLocation);
 		//UPDATE_TASK: Refactor calc into struct, utilize multiple constructors. 
 		SplitTriangleUp.HydrostaticForce = BuoyancyInformation.BuoyancyCoefficient * SplitTriangleUp.OutwardNormal * -SplitTriangleUp.Area * FMath::Abs(SplitTriangleUp.Depth) * -BuoyancyInformation.FluidDensity * GetGravityZ();
 		SplitTriangleDown.HydrostaticForce = BuoyancyInformation.BuoyancyCoefficient * SplitTriangleDown.OutwardNormal * -SplitTriangleDown.Area * FMath::Abs(SplitTriangleDown.Depth) * -BuoyancyInformation.FluidDensity * GetGravityZ();
@@ -458,7 +955,7 @@ void UNetworkedBuoyantPawnMovementComponent::CalculateAndApplyWaterEntryForce(co
 
 				if (!FMath::IsNearlyZero(UnCutTriangle.WaterEntryForce.Size()))
 				{
-					BodyInstance->AddForceAtPosition(UnCutTriangle.WaterEntryForce, UnCutTriangle.Center, false);
+					BuoyancyData.SubFrameCircularBuffer[1].Wrench.AddForceAtPosition(UnCutTriangle.WaterEntryForce, UnCutTriangle.Center);
 
 					if (bDebugDrawWaterEntryForce)
 					{
@@ -496,7 +993,7 @@ void UNetworkedBuoyantPawnMovementComponent::ApplyDampingForcesForTriangle(FBuoy
 
 		FVector CumulativeDampingForces = PressureDragForce + WaterResistanceForce;
 		if (!FMath::IsNearlyZero(CumulativeDampingForces.Size()))
-			BodyInstance->AddForceAtPosition(CumulativeDampingForces, TriCenter, false);
+			BuoyancyData.SubFrameCircularBuffer[1].Wrench.AddForceAtPosition(CumulativeDampingForces, TriCenter);
 	}
 }
 
@@ -584,12 +1081,13 @@ void UNetworkedBuoyantPawnMovementComponent::CalculateTrianglesForces(FBuoyantTr
 void UNetworkedBuoyantPawnMovementComponent::DrawBuoyantDebug()
 {
 	UWorld* World = GetWorld();
-	//Draw the white debug grid (height map)
-	if (bDebugDrawGrid)
+	//Draw the white debug grid (height map), it isn't sampled while the hull's vertices are
+	if (bDebugDrawGrid && !bUseDirectWaterSampling)
 	{
 		for (int CRow = 0; CRow < WaterGrid.Cells.Num(); CRow++)
 		{
-			for (int CCol = 0; CCol < WaterGrid.Cells[CRow].Num(); CCol++)
+			const FIntPoint Columns = WaterGrid.GetSampledCellColumns(CRow);
+			for (int CCol = Columns.X; CCol <= Columns.Y; CCol++)
 			{
 				for (int TriIndex = 0; TriIndex < 2; TriIndex++)
 				{
@@ -3,7 +3,7 @@
 *
 * Created by: Tobias Moos
 * Project name: Sails of War
-* Unreal Engine version: 4.19
+* Unreal Engine version: 4.22
 * Created on: 2020/01/08
 *
 * Last Edited on: 2021/01/07
@@ -30,6 +30,7 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/PawnMovementComponent.h"
+#include "Templates/Atomic.h"
 #include "Libraries/Buoyancy/BuoyancyLibrary.h"
 #include "NetworkedBuoyantPawnMovementComponent.generated.h"
 
@@ -37,6 +38,156 @@ struct FBodyInstance;
 DECLARE_STATS_GROUP(TEXT("NetworkedBuoyantPawnMovementComponent - Buoyancy Physics"), STATGROUP_BuoyancyPhysics, STATCAT_Advanced);
 DECLARE_STATS_GROUP(TEXT("NetworkedBuoyantPawnMovementComponent - Movement Physics"), STATGROUP_PhysicsMovement, STATCAT_Advanced);
 
+//How forces are estimated for sub-steps that skip the full buoyancy evaluation
+UENUM(BlueprintType)
+enum class EBuoyancyForceHoldMode : uint8
+{
+	Hold,			//Re-apply the wrench of the last evaluation
+	Extrapolate,	//Linearly extrapolate the wrench from the last two evaluations
+	Interpolate,	//Linearly interpolate between the last two evaluations, never overshoots but lags the restoring and damping forces one evaluation behind - bodies can bob at low evaluation rates
+};
+
+//Where the water heights used for the hull's depths come from
+UENUM(BlueprintType)
+enum class EWaterSamplingMode : uint8
+{
+	Grid,			//Sample a water grid around the hull and project the hull's vertices onto it
+	Direct,			//Sample the water at each of the hull's vertices, cheaper for hulls with fewer vertices than their grid
+	Automatic,		//Pick whichever of the two samples the water fewer times, see FBuoyancyInformation::DirectSamplingCostScale
+};
+
+//Settings for evaluating the hull at a lower rate than the physics sub-steps
+USTRUCT()
+struct FBuoyancyEvaluationRate
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, Category = "Buoyancy|Evaluation Rate")
+		bool bDecoupleFromSubsteps = false; //Evaluate the hull at the rate below instead of every physics sub-step
+
+	UPROPERTY(EditAnywhere, Category = "Buoyancy|Evaluation Rate", meta = (EditCondition = "bDecoupleFromSubsteps", ClampMin = "1.0"))
+		float MinRate = 20.0f; //Evaluations per second of a slow body on calm water
+
+	UPROPERTY(EditAnywhere, Category = "Buoyancy|Evaluation Rate", meta = (EditCondition = "bDecoupleFromSubsteps", ClampMin = "1.0"))
+		float MaxRate = 60.0f; //Evaluations per second of a fast body or one on steep waves, rates above the sub-step rate evaluate every sub-step
+
+	UPROPERTY(EditAnywhere, Category = "Buoyancy|Evaluation Rate", meta = (EditCondition = "bDecoupleFromSubsteps"))
+		float SpeedForMaxRate = 1500.0f; //Centimeters per second, the body's speed at which MaxRate is reached
+
+	UPROPERTY(EditAnywhere, Category = "Buoyancy|Evaluation Rate", meta = (EditCondition = "bDecoupleFromSubsteps"))
+		float SteepnessForMaxRate = 0.25f; //The steepest slope of the water grid (height / distance) at which MaxRate is reached
+
+	UPROPERTY(EditAnywhere, Category = "Buoyancy|Evaluation Rate", meta = (EditCondition = "bDecoupleFromSubsteps"))
+		EBuoyancyForceHoldMode HoldMode = EBuoyancyForceHoldMode::Hold; //How forces are estimated for sub-steps between evaluations
+
+	FBuoyancyEvaluationRate() {};
+};
+
+//Settings for picking the water grid's cell size from the waves and the hull instead of a fixed size
+USTRUCT()
+struct FWaterGridResolution
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, Category = "Buoyancy|Grid Resolution")
+		bool bAdaptiveCellSize = true; //Pick the cell size from the sea state and the hull, otherwise WaterGridCellSize is used as is
+
+	UPROPERTY(EditAnywhere, Category = "Buoyancy|Grid Resolution", meta = (EditCondition = "bAdaptiveCellSize", ClampMin = "2.0"))
+		float SamplesPerWavelength = 6.0f; //Grid vertices across the shortest significant wavelength, the grid interpolates linearly between them
+
+	UPROPERTY(EditAnywhere, Category = "Buoyancy|Grid Resolution", meta = (EditCondition = "bAdaptiveCellSize", ClampMin = "1"))
+		int32 MinCellsAlongHull = 4; //The fewest cells across the hull's longest side, small hulls in long swells still resolve their pitch and roll
+
+	UPROPERTY(EditAnywhere, Category = "Buoyancy|Grid Resolution", meta = (EditCondition = "bAdaptiveCellSize", ClampMin = "16"))
+		int32 MaxGridSamples = 400; //The most vertices the grid may have, wins over every other limit
+
+	UPROPERTY(EditAnywhere, Category = "Buoyancy|Grid Resolution", meta = (EditCondition = "bAdaptiveCellSize", ClampMin = "10.0"))
+		float MinCellSize = 50.0f; //Centimeters
+
+	UPROPERTY(EditAnywhere, Category = "Buoyancy|Grid Resolution", meta = (EditCondition = "bAdaptiveCellSize"))
+		float MaxCellSize = 1600.0f; //Centimeters, used in calm water
+
+	UPROPERTY(EditAnywhere, Category = "Buoyancy|Grid Resolution", meta = (EditCondition = "bAdaptiveCellSize", ClampMin = "1"))
+		int32 CellSizeStep = 25; //Centimeters, cell sizes are rounded up to a multiple of this so ships in the same sea share the water height cache's tiles - which are keyed by whole centimeters
+
+	UPROPERTY(EditAnywhere, Category = "Buoyancy|Grid Resolution", meta = (EditCondition = "bAdaptiveCellSize", ClampMin = "0.1"))
+		float ProbeInterval = 5.0f; //Seconds between measurements of the sea state
+
+	UPROPERTY(EditAnywhere, Category = "Buoyancy|Grid Resolution", meta = (EditCondition = "bAdaptiveCellSize", ClampMin = "0.0"))
+		float ChangeThreshold = 0.2f; //The relative change of the picked cell size needed before the grid is rebuilt
+
+	UPROPERTY(EditAnywhere, Category = "Buoyancy|Grid Resolution", meta = (EditCondition = "bAdaptiveCellSize", ClampMin = "1.0"))
+		float ProbeSpacing = 50.0f; //Centimeters between the sea state probe's samples, waves shorter than about 4 times this aren't seen
+
+	UPROPERTY(EditAnywhere, Category = "Buoyancy|Grid Resolution", meta = (EditCondition = "bAdaptiveCellSize", ClampMin = "8"))
+		int32 NumProbeSamples = 48; //Samples along each of the probe's two transects
+
+	UPROPERTY(EditAnywhere, Category = "Buoyancy|Grid Resolution", meta = (EditCondition = "bAdaptiveCellSize"))
+		float MinSignificantSlope = 0.01f; //Root mean square slope of the water below which the sea counts as calm
+
+	FWaterGridResolution() {};
+
+	/**
+	*	Estimate the shortest significant wavelength of the water around a location from two perpendicular transects of height samples.
+	*	Uses the spectral moments measured through finite differences: 2 * PI * sqrt(m2 / m4), the rms slope over the rms curvature,
+	*	which weights the spectrum's short waves the most.
+	*	@param	GetWaterHeight - Samples the water height at a world space location
+	*	@param	Center - The world space location to probe around
+	*	@param	Heights - Scratch space for a transect's heights, kept by the caller to avoid reallocating each probe
+	*	@return	float - the wavelength in cm, zero if the water is calmer than MinSignificantSlope
+	*/
+	float EstimateShortestWavelength(TFunctionRef<float(const FVector&)> GetWaterHeight, const FVector& Center, TArray<float>& Heights) const;
+
+	/**
+	*	Pick the water grid's cell size for a wavelength within the hull and sample budget limits, the grid never has more than MaxGridSamples vertices
+	*	@param	Wavelength - The shortest significant wavelength in cm, zero for calm water
+	*	@param	HullSize - The largest side of the hull's bounding box in cm, FWaterGrid is sized by it
+	*	@return	int32 - the cell size in whole cm
+	*/
+	int32 PickCellSize(float Wavelength, float HullSize) const;
+
+	/**
+	*	The most vertices a square FWaterGrid around a hull can have, the grid snaps to the world so it spans up to one cell more than the hull
+	*	@param	HullSize - The largest side of the hull's bounding box in cm
+	*	@param	CellSize - The grid's cell size in cm
+	*	@return	int32 - the vertex count
+	*/
+	static int32 GetMaxGridVertices(float HullSize, float CellSize);
+};
+
+//Settings for detecting a body resting in calm water and skipping its evaluation
+USTRUCT()
+struct FBuoyancyRestDetection
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, Category = "Buoyancy|Rest Detection")
+		bool bEnableRestDetection = false; //Reuse the forces of bodies resting in calm water instead of evaluating the hull
+
+	UPROPERTY(EditAnywhere, Category = "Buoyancy|Rest Detection", meta = (EditCondition = "bEnableRestDetection"))
+		float MaxLinearSpeed = 25.0f; //Centimeters per second, faster bodies are never at rest
+
+	UPROPERTY(EditAnywhere, Category = "Buoyancy|Rest Detection", meta = (EditCondition = "bEnableRestDetection"))
+		float MaxAngularSpeed = 2.0f; //Degrees per second, faster rotating bodies are never at rest
+
+	UPROPERTY(EditAnywhere, Category = "Buoyancy|Rest Detection", meta = (EditCondition = "bEnableRestDetection"))
+		float MaxOrientationChange = 2.0f; //Degrees the body may rotate away from the pose it came to rest in
+
+	UPROPERTY(EditAnywhere, Category = "Buoyancy|Rest Detection", meta = (EditCondition = "bEnableRestDetection"))
+		float MaxWaterHeightChange = 10.0f; //Centimeters the water under the center of mass may move away from the height it came to rest at
+
+	UPROPERTY(EditAnywhere, Category = "Buoyancy|Rest Detection", meta = (EditCondition = "bEnableRestDetection"))
+		float TimeBeforeRest = 1.0f; //Seconds the body has to stay below the speed thresholds before coming to rest
+
+	UPROPERTY(EditAnywhere, Category = "Buoyancy|Rest Detection", meta = (EditCondition = "bEnableRestDetection"))
+		float MaxRestDuration = 2.0f; //Seconds before a resting body is evaluated again to refresh its forces, zero to rest indefinitely
+
+	UPROPERTY(EditAnywhere, Category = "Buoyancy|Rest Detection", meta = (EditCondition = "bEnableRestDetection"))
+		bool bUseHydrostaticStiffness = true; //Correct the cached forces for small heave, roll and pitch offsets, otherwise the last wrench is reused as is
+
+	FBuoyancyRestDetection() {};
+};
+
 //Container storing the values about the hydrodynamic forces and their damping values.
 USTRUCT()
 struct FBuoyancyInformationDampingForces
@@ -132,7 +283,25 @@ struct FBuoyancyInformation
 		FVector BuoyancyCoefficient = FVector(0.0f, 0.0f, 1.0f);
 
 	UPROPERTY(EditAnywhere)
-		float WaterGridCellSize = 400.0f; //The size of each of the water grid's cells
+		float WaterGridCellSize = 400.0f; //The size of each of the water grid's cells, used until the first sea state probe when GridResolution.bAdaptiveCellSize picks it, and always otherwise
+
+	UPROPERTY(EditAnywhere, Category = "Buoyancy")
+		FWaterGridResolution GridResolution;
+
+	UPROPERTY(EditAnywhere, Category = "Buoyancy|Water Sampling")
+		bool bMaskGridToFootprint = true; //Only sample the water grid's cells under the hull's rotated bounds, instead of the whole square around it
+
+	UPROPERTY(EditAnywhere, Category = "Buoyancy|Water Sampling", meta = (EditCondition = "bMaskGridToFootprint", ClampMin = "0.0"))
+		float FootprintMaskMargin = 100.0f; //Centimeters the hull's footprint is grown by before masking, covers the water's horizontal displacement
+
+	UPROPERTY(EditAnywhere, Category = "Buoyancy|Water Sampling")
+		EWaterSamplingMode WaterSamplingMode = EWaterSamplingMode::Automatic; //How the water under the hull is sampled
+
+	UPROPERTY(EditAnywhere, Category = "Buoyancy|Water Sampling", meta = (ClampMin = "0.0"))
+		float DirectSamplingCostScale = 1.0f; //The cost of a hull vertex sample relative to a grid vertex sample in the automatic choice, raise it to favour the grid when ships share the world's water height cache
+
+	UPROPERTY(EditAnywhere, Category = "Buoyancy|Water Sampling", meta = (ClampMin = "0.0"))
+		float SamplingModeHysteresis = 0.2f; //How much cheaper the other sampling path must be before the automatic choice switches to it, as a fraction of its cost
 
 	//UPDATE_TASK: REYNOLDS_NUMBER_LENGTH - Remove this variable
 	UPROPERTY(EditAnywhere, Category = "Physics")
@@ -144,6 +313,12 @@ struct FBuoyancyInformation
 	UPROPERTY(EditAnywhere, Category = "Physics")
 		FPhysicsOverrides PhysicsOverrides;
 
+	UPROPERTY(EditAnywhere, Category = "Buoyancy")
+		FBuoyancyEvaluationRate EvaluationRate;
+
+	UPROPERTY(EditAnywhere, Category = "Buoyancy")
+		FBuoyancyRestDetection RestDetection;
+
 	FBuoyancyInformation() {};
 };
 
@@ -187,9 +362,24 @@ public:
 
 	/**
 	*	returns the size of the water grid's cells
-	*	@return	float - the size of the cell
+	*	@return	float - the size of the cell in whole cm, picked from the sea state when GridResolution is adaptive - the water height cache's tiles are keyed by whole cm
+	*/
+	float GetWaterGridCellSize() const
+	{
+		const int32 AdaptiveCellSize = AdaptiveWaterGridCellSize.Load();
+		return AdaptiveCellSize > 0 ? float(AdaptiveCellSize) : FMath::Max(FMath::RoundToFloat(BuoyancyInformation.WaterGridCellSize), 1.0f);
+	}
+
+	/**
+	*	returns the shortest significant wavelength measured by the last sea state probe
+	*	@return	float - the wavelength in cm, zero in calm water or before the first probe
 	*/
-	float GetWaterGridCellSize() { return BuoyancyInformation.WaterGridCellSize; }
+	float GetEstimatedWavelength() const { return EstimatedWavelength; }
+
+	/**
+	*	Returns true if the water is sampled at the hull's vertices instead of on the water grid, see EWaterSamplingMode
+	*/
+	bool UsesDirectWaterSampling() const { return bUseDirectWaterSampling; }
 
 protected:
 	UPROPERTY(EditAnywhere)
@@ -263,6 +453,90 @@ public:
 	*/
 	virtual void PhysicsSubstep(float DeltaTime, FBodyInstance* BodyInstance); 
 
+	/**
+	*	Returns true if this component's owner is the one simulating buoyancy (autonomous client or locally controlled on the server)
+	*/
+	bool ShouldSimulateBuoyancy() const;
+
+	/**
+	*	Returns true if any of the per-triangle debug visuals drawn during the substep are enabled,
+	*	the debug line batcher isn't thread safe so these bodies can't be evaluated in parallel.
+	*/
+	bool WantsSubstepDebugDraw() const;
+
+protected:
+	/**
+	*	Rotates the sub frame buffer, caches the body's transform and center of mass for this sub-step and moves the water grid with it.
+	*	Also resolves the ocean and its time for the sub-step, evaluating it never touches the world.
+	*	@param	DeltaSubstepTime - The delta time for the sub frame
+	*	@param	BodyInstance - The FBodyInstance of a BuoyantMesh's static mesh
+	*	@param	WaterHeightCache - The world's shared water heights for this sub-step whose ocean and time are used, nullptr to look them up
+	*/
+	void BeginBuoyancySubstep(float SubstepDeltaTime, FBodyInstance* BodyInstance, const class FWaterHeightTileCache* WaterHeightCache = nullptr);
+
+	/**
+	*	Samples the water grid and evaluates the hull's forces into the current sub frame's wrench.
+	*	Doesn't apply anything to the body - it's safe to run for different components at the same time.
+	*	@param	DeltaSubstepTime - The delta time for the sub frame
+	*	@param	BodyInstance - The FBodyInstance of a BuoyantMesh's static mesh
+	*	@param	WaterHeightCache - The world's shared water heights for this sub-step, nullptr to sample the ocean directly
+	*	@param	bSampleCacheMisses - Sample the ocean for grid vertices missing from the cache, false to leave them to the calling thread
+	*	@return	bool - false if the grid missed the cache and bSampleCacheMisses is false, nothing was evaluated
+	*/
+	bool EvaluateBuoyancySubstep(float SubstepDeltaTime, FBodyInstance* BodyInstance, const class FWaterHeightTileCache* WaterHeightCache = nullptr, bool bSampleCacheMisses = true);
+
+	/**
+	*	Applies the current sub frame's wrench to the body and performs the custom movement
+	*	@param	DeltaSubstepTime - The delta time for the sub frame
+	*	@param	BodyInstance - The FBodyInstance of a BuoyantMesh's static mesh to apply forces to
+	*/
+	void ApplyBuoyancySubstep(float SubstepDeltaTime, FBodyInstance* BodyInstance);
+
+	/**
+	*	Applies a wrench estimated from the last evaluations instead of evaluating the hull and performs the custom movement
+	*	@param	DeltaSubstepTime - The delta time for the sub frame
+	*	@param	BodyInstance - The FBodyInstance of a BuoyantMesh's static mesh to apply forces to
+	*	@param	HoldMode - How to estimate the wrench from the last evaluations
+	*/
+	void ApplyHeldBuoyancySubstep(float SubstepDeltaTime, FBodyInstance* BodyInstance, EBuoyancyForceHoldMode HoldMode);
+
+	/**
+	*	Estimate the wrench for a sub-step that skips evaluation
+	*	@param	HoldMode - How to estimate the wrench from the last evaluations
+	*	@return	FBuoyancyWrench - the estimated wrench
+	*/
+	FBuoyancyWrench GetHeldWrench(EBuoyancyForceHoldMode HoldMode) const;
+
+	/**
+	*	Returns true once the hull has been evaluated at least once, held wrenches are meaningless before that
+	*/
+	bool HasEvaluatedBuoyancy() const { return bHasEvaluatedBuoyancy; }
+
+	/**
+	*	Decide whether this sub-step evaluates the hull or reuses the last evaluations, see FBuoyancyEvaluationRate
+	*	@param	DeltaSubstepTime - The delta time for the sub frame
+	*	@param	BodyInstance - The FBodyInstance of a BuoyantMesh's static mesh
+	*	@return	bool - true if the hull should be evaluated
+	*/
+	bool ShouldEvaluateBuoyancy(float SubstepDeltaTime, FBodyInstance* BodyInstance);
+
+	/**
+	*	Returns true while the body is resting in calm water and reusing its cached forces
+	*/
+	bool IsAtRest() const { return bAtRest; }
+
+	/**
+	*	Returns how forces are estimated for sub-steps between decoupled evaluations
+	*/
+	EBuoyancyForceHoldMode GetEvaluationHoldMode() const { return BuoyancyInformation.EvaluationRate.HoldMode; }
+
+	/**
+	*	Returns the rate the hull is currently evaluated at, in evaluations per second
+	*/
+	float GetCurrentEvaluationRate() const { return CurrentEvaluationRate; }
+
+	friend class UBuoyancyWorldSubsystem; //Batches the sub-step phases of every registered component
+
 protected:
 	/**
 	*	Override this function for any movement forces that need to be applied to the body
@@ -274,6 +548,71 @@ protected:
 protected:
 	UPROPERTY()
 		FTransform BodyInstanceTransform = FTransform(); //Performance Optimization grab the transform at the start of the sub-frame
+
+	float TimeSinceBuoyancyEvaluation = 0.0f; //Time passed since the start of the last sub-step that evaluated the hull
+
+	float LastBuoyancyEvaluationInterval = 0.0f; //Time between the last two evaluations of the hull
+
+	bool bHasEvaluatedBuoyancy = false;
+
+	float CurrentEvaluationRate = 0.0f; //The decoupled evaluation rate picked for the current sub-step, zero while evaluating every sub-step
+
+	class ASOWOceanActor* SubstepOceanActor = nullptr; //The ocean sampled this sub-step, nullptr if there's no ocean or game state to sample
+
+	float SubstepOceanTime = 0.0f; //The ocean time sampled this sub-step, shared with the bodies batched alongside us
+
+	float WaterGridSteepness = 0.0f; //The steepest slope between neighbouring water grid vertices at the last evaluation
+
+	bool bUseDirectWaterSampling = false; //True while the hull's vertices are sampled instead of the water grid
+
+	TArray<FVector> DirectSamplePoints; //The hull's unique vertices in world space at the last direct sampling
+
+	TArray<float> DirectSampleHeights; //The water height at each of the DirectSamplePoints
+
+	TAtomic<int32> AdaptiveWaterGridCellSize { 0 }; //Centimeters, the cell size picked from the sea state, zero until the first probe - written on the game thread, applied by the next sub-step on the physics thread
+
+	float EstimatedWavelength = 0.0f; //The shortest significant wavelength at the last sea state probe
+
+	float TimeUntilSeaStateProbe = 0.0f; //Seconds until the sea state is measured again
+
+	TArray<float> ProbeHeights; //The heights along a sea state probe's transect, kept to avoid reallocating each probe
+
+	TArray<FVector2D> FootprintPoints; //The corners of the hull's rotated bounding box on the water plane, kept to avoid reallocating each sub-step
+
+	bool bAtRest = false; //True while the body's evaluation is skipped by rest detection
+
+	float TimeBelowRestThresholds = 0.0f; //Seconds the body has stayed below the rest speed thresholds, or has been resting for
+
+	FTransform RestTransform = FTransform(); //The body's transform when it came to rest
+
+	float RestWaterHeight = 0.0f; //The water height under the center of mass when the body came to rest
+
+	float CurrentRestWaterHeight = 0.0f; //The water height under the center of mass at the last rest check
+
+	FHydrostaticStiffness RestStiffness; //The hydrostatic stiffness about the pose the body came to rest in
+
+	/**
+	*	Update the rest state for this sub-step, entering or leaving rest
+	*	@param	DeltaSubstepTime - The delta time for the sub frame
+	*	@param	BodyInstance - The FBodyInstance of a BuoyantMesh's static mesh
+	*	@return	bool - true if the body is at rest and can skip its evaluation
+	*/
+	bool UpdateRestState(float SubstepDeltaTime, FBodyInstance* BodyInstance);
+
+	/**
+	*	Sample the water height directly under the body's center of mass
+	*	@param	CenterOfMass - The world space center of mass
+	*	@param	OutWaterHeight - The water height
+	*	@return	bool - false if there's no ocean to sample
+	*/
+	bool SampleRestWaterHeight(const FVector& CenterOfMass, float& OutWaterHeight) const;
+
+	/**
+	*	Estimate the wrench of a resting body from its cached forces
+	*	@param	BodyInstance - The FBodyInstance of a BuoyantMesh's static mesh
+	*	@return	FBuoyancyWrench - the estimated wrench
+	*/
+	FBuoyancyWrench GetRestWrench(FBodyInstance* BodyInstance) const;
 	
 	/**
 	*	Returns the owner's RootComponent's BodyInstance's mass
@@ -312,11 +651,64 @@ protected:
 
 private:
 	/**
-	*	Resizes, Re-Samples and moves the water grid to be aligned with the BodyInstances's new location
+	*	Re-Samples the water grid's vertices inside the hull's footprint, BeginBuoyancySubstep() aligns it with the BodyInstance's new location first
 	*	@param	DeltaSubstepTime - The delta time for the sub frame
 	*	@param	BodyInstance - The FBodyInstance of a BuoyantMesh's static mesh to find its location during the sub-frame
+	*	@param	WaterHeightCache - The world's shared water heights for this sub-step, nullptr to sample the ocean directly
+	*	@param	bSampleCacheMisses - Sample the ocean if any of the grid's vertices are missing from the cache
+	*	@return	bool - false if the grid missed the cache and wasn't sampled
+	*/
+	bool UpdateWaterGrid(float SubstepDeltaTime, FBodyInstance* BodyInstance, const class FWaterHeightTileCache* WaterHeightCache = nullptr, bool bSampleCacheMisses = true);
+
+	/**
+	*	Resizes and moves the water grid if the body has left its bounds and masks it to the hull's footprint, without sampling it
+	*	@param	BodyInstance - The FBodyInstance of a BuoyantMesh's static mesh to find its location during the sub-frame
+	*/
+	void UpdateWaterGridBounds(FBodyInstance* BodyInstance);
+
+	/**
+	*	Measure the sea state around the body every ProbeInterval and pick the water grid's cell size from it, see FWaterGridResolution
+	*	@param	DeltaTime - Seconds since the last call
+	*/
+	void UpdateWaterGridResolution(float DeltaTime);
+
+	/**
+	*	Mask the water grid to the hull's bounding box rotated into this sub-step's transform and projected onto the water plane
+	*/
+	void UpdateWaterGridFootprint();
+
+	/**
+	*	Finds the steepest slope between neighbouring vertices of the sampled water grid
+	*	@return	float - the slope as height over distance
+	*/
+	float CalculateWaterGridSteepness() const;
+
+	/**
+	*	Pick between sampling the water grid and sampling the hull's vertices directly, see EWaterSamplingMode.
+	*	Called whenever the water grid's bounds or footprint mask change, the number of grid samples only changes then.
+	*	@param	bApplyHysteresis - Keep the current choice unless the other path is cheaper by SamplingModeHysteresis, false for a new mesh
+	*/
+	void UpdateWaterSamplingMode(bool bApplyHysteresis = true);
+
+	/**
+	*	Transforms the hull's unique vertices to world space and samples the water height at each of them
+	*	@param	BodyInstance - The FBodyInstance of a BuoyantMesh's static mesh
+	*/
+	void SampleWaterAtHullVertices(FBodyInstance* BodyInstance);
+
+	/**
+	*	Finds the steepest slope of the water along the edges of the hull's triangles at the last direct sampling
+	*	@return	float - the slope as height over distance
+	*/
+	float CalculateHullWaterSteepness() const;
+
+	/**
+	*	Get the depth of a point on one of the hull's triangles, from the water grid or interpolated across the triangle when sampling directly
+	*	@param	Point - The world space point
+	*	@param	Triangle - The triangle the point lies on
+	*	@return	float - the depth of the point
 	*/
-	void UpdateWaterGrid(float SubstepDeltaTime, FBodyInstance* BodyInstance);
+	float GetDepthForPoint(const FVector& Point, const FBuoyantTriangle& Triangle);
 
 	/**
 	*	Iterate through the BuoyantMesh's triangles and vertices, transform them to world space
@@ -348,4 +740,5 @@ private:
 /*UMovementComponent Overrides*/
 public:
 	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction) override; //Overridden to draw debug information every frame
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override; //Overridden to unregister from the buoyancy world subsystem
 };
@@ -1 +1,589 @@
-#include "PhysicsMovementReplication.h"
\ No newline at end of file
+#include "PhysicsMovementReplication.h"
+
+//Engine Includes:
+#include "Engine/NetSerialization.h"
+
+DECLARE_CYCLE_STAT(TEXT("UpdateBufferDelay"), STAT_UpdateBufferDelay, STATGROUP_PhysicsReplication);
+
+namespace MovementSnapshotSerialization
+{
+	static const float SmallestThreeRange = 0.70710678f; //The largest value the three smallest components of a normalized quaternion can have
+	static const int32 RotationComponentMax = (1 << (FMovementSnapshot::RotationComponentBits - 1)) - 1;
+	static const float LinearVelocityScale = 1.0f;
+	static const float AngularVelocityScale = 10.0f;
+
+	float GetPositionScale(ESnapshotPositionPrecision Precision)
+	{
+		switch (Precision)
+		{
+		case ESnapshotPositionPrecision::TenthMillimeter:
+			return 100.0f;
+		case ESnapshotPositionPrecision::Millimeter:
+			return 10.0f;
+		default:
+			return 1.0f;
+		}
+	}
+
+	FIntVector QuantizeVector(const FVector& Vector, float Scale)
+	{
+		return FIntVector(FMath::RoundToInt(Vector.X * Scale), FMath::RoundToInt(Vector.Y * Scale), FMath::RoundToInt(Vector.Z * Scale));
+	}
+
+	FVector DequantizeVector(const FIntVector& Vector, float Scale)
+	{
+		return FVector(Vector.X, Vector.Y, Vector.Z) / Scale;
+	}
+
+	/* Maps signed values to unsigned ones so small magnitudes of either sign need few bits */
+	uint32 ZigZagEncode(int32 Value) { return (uint32(Value) << 1) ^ uint32(Value >> 31); }
+	int32 ZigZagDecode(uint32 Value) { return int32(Value >> 1) ^ -int32(Value & 1); }
+
+	/* Writes the bits needed by the largest component once, then every component with that many bits - the count is 0 to 32 so it takes 6 bits, all a zero vector costs */
+	void SerializePackedIntVector(FArchive& Ar, FIntVector& Vector)
+	{
+		uint32 Encoded[3] = { ZigZagEncode(Vector.X), ZigZagEncode(Vector.Y), ZigZagEncode(Vector.Z) };
+		uint32 Bits = Ar.IsSaving() ? 32 - FMath::CountLeadingZeros(Encoded[0] | Encoded[1] | Encoded[2]) : 0;
+		Ar.SerializeInt(Bits, 33);
+		for (uint32& Component : Encoded)
+		{
+			if (Ar.IsLoading())
+				Component = 0;
+			if (Bits > 0)
+				Ar.SerializeBits(&Component, Bits);
+		}
+
+		if (Ar.IsLoading())
+			Vector = FIntVector(ZigZagDecode(Encoded[0]), ZigZagDecode(Encoded[1]), ZigZagDecode(Encoded[2]));
+	}
+
+	/* Smallest three quaternion compression - the largest component is dropped and rebuilt from the others, as q and -q are the same rotation it's always positive */
+	void QuantizeRotation(const FQuat& Rotation, FIntVector& OutComponents, uint8& OutLargestIndex)
+	{
+		const FQuat Normalized = Rotation.GetNormalized();
+		const float Components[4] = { Normalized.X, Normalized.Y, Normalized.Z, Normalized.W };
+		OutLargestIndex = 0;
+		for (uint8 Index = 1; Index < 4; Index++)
+		{
+			if (FMath::Abs(Components[Index]) > FMath::Abs(Components[OutLargestIndex]))
+				OutLargestIndex = Index;
+		}
+
+		const float Sign = Components[OutLargestIndex] < 0.0f ? -1.0f : 1.0f;
+		int32 Quantized[3];
+		int32 QuantizedIndex = 0;
+		for (uint8 Index = 0; Index < 4; Index++)
+		{
+			if (Index != OutLargestIndex)
+				Quantized[QuantizedIndex++] = FMath::Clamp(FMath::RoundToInt(Components[Index] * Sign / SmallestThreeRange * RotationComponentMax), -RotationComponentMax, RotationComponentMax);
+		}
+
+		OutComponents = FIntVector(Quantized[0], Quantized[1], Quantized[2]);
+	}
+
+	FQuat DequantizeRotation(const FIntVector& QuantizedComponents, uint8 LargestIndex)
+	{
+		const int32 Quantized[3] = { QuantizedComponents.X, QuantizedComponents.Y, QuantizedComponents.Z };
+		float Components[4];
+		float SumOfSquares = 0.0f;
+		int32 QuantizedIndex = 0;
+		for (uint8 Index = 0; Index < 4; Index++)
+		{
+			if (Index == LargestIndex)
+				continue;
+
+			Components[Index] = (float(Quantized[QuantizedIndex++]) / RotationComponentMax) * SmallestThreeRange;
+			SumOfSquares += FMath::Square(Components[Index]);
+		}
+
+		Components[LargestIndex] = FMath::Sqrt(FMath::Max(1.0f - SumOfSquares, 0.0f));
+		return FQuat(Components[0], Components[1], Components[2], Components[3]).GetNormalized();
+	}
+}
+
+FQuantizedMovementSnapshot FQuantizedMovementSnapshot::Quantize(const FMovementSnapshot& Snapshot)
+{
+	using namespace MovementSnapshotSerialization;
+
+	//Velocities are clamped to their limits so their packed size stays bounded
+	FQuantizedMovementSnapshot Quantized;
+	Quantized.Precision = Snapshot.Quantization.PositionPrecision;
+	Quantized.Location = QuantizeVector(Snapshot.Location, GetPositionScale(Quantized.Precision));
+	QuantizeRotation(Snapshot.Rotation, Quantized.Rotation, Quantized.RotationLargestIndex);
+	Quantized.LinearVelocity = QuantizeVector(Snapshot.LinearVelocity.GetClampedToMaxSize(Snapshot.Quantization.MaxLinearSpeed), LinearVelocityScale);
+	Quantized.AngularVelocity = QuantizeVector(Snapshot.AngularVelocity.GetClampedToMaxSize(Snapshot.Quantization.MaxAngularSpeed), AngularVelocityScale);
+	Quantized.TimeStampMs = uint32(FMath::Max(double(Snapshot.TimeStamp) * 1000.0 + 0.5, 0.0));
+	Quantized.EventFlag = uint8(FMath::Max<int8>(Snapshot.EventFlag, 0));
+	return Quantized;
+}
+
+FMovementSnapshot FQuantizedMovementSnapshot::Dequantize() const
+{
+	using namespace MovementSnapshotSerialization;
+
+	FMovementSnapshot Snapshot = FMovementSnapshot(
+		DequantizeVector(LinearVelocity, LinearVelocityScale),
+		DequantizeVector(AngularVelocity, AngularVelocityScale),
+		DequantizeVector(Location, GetPositionScale(Precision)),
+		DequantizeRotation(Rotation, RotationLargestIndex),
+		float(TimeStampMs / 1000.0));
+	Snapshot.EventFlag = int8(EventFlag);
+	Snapshot.Quantization.PositionPrecision = Precision;
+	return Snapshot;
+}
+
+void FQuantizedMovementSnapshot::Serialize(FArchive& Ar, bool bDelta, bool bWrapTimeStamp)
+{
+	using namespace MovementSnapshotSerialization;
+
+	//SerializeInt sends the bits its range needs, 2 for each of these
+	uint32 PrecisionValue = (uint32)Precision;
+	uint32 LargestIndexValue = RotationLargestIndex;
+	uint32 FlagValue = EventFlag;
+	Ar.SerializeInt(PrecisionValue, 3);
+	Ar.SerializeInt(LargestIndexValue, 4);
+	Ar.SerializeInt(FlagValue, 4);
+	SerializePackedIntVector(Ar, Location);
+	SerializePackedIntVector(Ar, Rotation);
+	SerializePackedIntVector(Ar, LinearVelocity);
+	SerializePackedIntVector(Ar, AngularVelocity);
+
+	//A delta's time is usually a single send interval, a keyframe's is the full session time unless it's wrapped
+	if (bDelta)
+		Ar.SerializeIntPacked(TimeStampMs);
+	else if (bWrapTimeStamp)
+	{
+		uint32 WrappedTimeStamp = TimeStampMs & ((1u << WrappedTimeStampBits) - 1);
+		Ar.SerializeBits(&WrappedTimeStamp, WrappedTimeStampBits);
+		if (Ar.IsLoading())
+			TimeStampMs = WrappedTimeStamp;
+	}
+	else
+		Ar << TimeStampMs;
+
+	if (Ar.IsLoading())
+	{
+		Precision = (ESnapshotPositionPrecision)PrecisionValue;
+		RotationLargestIndex = uint8(LargestIndexValue);
+		EventFlag = uint8(FlagValue);
+	}
+}
+
+void FQuantizedMovementSnapshot::UnwrapTimeStamp(float ReferenceTime)
+{
+	const int64 Period = int64(1) << WrappedTimeStampBits;
+	const int64 ReferenceMs = int64(FMath::Max(double(ReferenceTime) * 1000.0 + 0.5, 0.0));
+	int64 Unwrapped = (ReferenceMs & ~(Period - 1)) | (int64(TimeStampMs) & (Period - 1));
+	if (Unwrapped - ReferenceMs > Period / 2)
+		Unwrapped -= Period;
+	else if (ReferenceMs - Unwrapped > Period / 2)
+		Unwrapped += Period;
+
+	TimeStampMs = uint32(FMath::Max<int64>(Unwrapped, 0));
+}
+
+FQuantizedMovementSnapshot FQuantizedMovementSnapshot::GetDelta(const FQuantizedMovementSnapshot& Baseline) const
+{
+	FQuantizedMovementSnapshot Delta = *this;
+	Delta.Location = Location - Baseline.Location;
+	Delta.LinearVelocity = LinearVelocity - Baseline.LinearVelocity;
+	Delta.AngularVelocity = AngularVelocity - Baseline.AngularVelocity;
+	Delta.TimeStampMs = TimeStampMs - Baseline.TimeStampMs;
+
+	//Components of different dropped indices don't line up, the receiver sees the index change and reads them as absolute
+	if (RotationLargestIndex == Baseline.RotationLargestIndex)
+		Delta.Rotation = Rotation - Baseline.Rotation;
+
+	return Delta;
+}
+
+FQuantizedMovementSnapshot FQuantizedMovementSnapshot::ApplyDelta(const FQuantizedMovementSnapshot& Baseline, const FQuantizedMovementSnapshot& Delta)
+{
+	FQuantizedMovementSnapshot Snapshot = Delta;
+	Snapshot.Location = Baseline.Location + Delta.Location;
+	Snapshot.LinearVelocity = Baseline.LinearVelocity + Delta.LinearVelocity;
+	Snapshot.AngularVelocity = Baseline.AngularVelocity + Delta.AngularVelocity;
+	Snapshot.TimeStampMs = Baseline.TimeStampMs + Delta.TimeStampMs;
+	if (Delta.RotationLargestIndex == Baseline.RotationLargestIndex)
+		Snapshot.Rotation = Baseline.Rotation + Delta.Rotation;
+
+	return Snapshot;
+}
+
+bool FMovementSnapshot::NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess)
+{
+	FQuantizedMovementSnapshot Quantized = Ar.IsSaving() ? FQuantizedMovementSnapshot::Quantize(*this) : FQuantizedMovementSnapshot();
+	Quantized.Serialize(Ar, false);
+	if (Ar.IsLoading())
+		*this = Quantized.Dequantize();
+
+	//Vectors past their limits are clamped rather than failed, only a broken archive fails the snapshot
+	bOutSuccess = !Ar.IsError();
+	return true;
+}
+
+FMovementSnapshot FMovementSnapshot::Interpolate(const FMovementSnapshot& A, const FMovementSnapshot& B, float Alpha)
+{
+	const float Interval = B.TimeStamp - A.TimeStamp;
+	if (Interval <= KINDA_SMALL_NUMBER)
+		return B;
+
+	FMovementSnapshot Result = B;
+	Result.TimeStamp = FMath::Lerp(A.TimeStamp, B.TimeStamp, Alpha);
+	InterpolateLocation(A.Location, A.LinearVelocity, B.Location, B.LinearVelocity, Interval, Alpha, Result.Location, Result.LinearVelocity);
+	Result.Rotation = InterpolateRotation(A.Rotation, A.AngularVelocity, B.Rotation, B.AngularVelocity, Interval, Alpha);
+	Result.AngularVelocity = FMath::Lerp(A.AngularVelocity, B.AngularVelocity, Alpha);
+	return Result;
+}
+
+void FMovementSnapshot::InterpolateLocation(const FVector& FromLocation, const FVector& FromVelocity, const FVector& ToLocation, const FVector& ToVelocity, float Interval, float Alpha, FVector& OutLocation, FVector& OutVelocity)
+{
+	//Cubic hermite basis functions and their derivatives
+	const float T = Alpha, T2 = Alpha * Alpha, T3 = T2 * Alpha;
+	const float H00 = 2.0f * T3 - 3.0f * T2 + 1.0f, H10 = T3 - 2.0f * T2 + T;
+	const float H01 = -2.0f * T3 + 3.0f * T2, H11 = T3 - T2;
+	const float DH00 = 6.0f * T2 - 6.0f * T, DH10 = 3.0f * T2 - 4.0f * T + 1.0f;
+	const float DH01 = -6.0f * T2 + 6.0f * T, DH11 = 3.0f * T2 - 2.0f * T;
+
+	OutLocation = H00 * FromLocation + H10 * Interval * FromVelocity + H01 * ToLocation + H11 * Interval * ToVelocity;
+	OutVelocity = (DH00 * FromLocation + DH10 * Interval * FromVelocity + DH01 * ToLocation + DH11 * Interval * ToVelocity) / Interval;
+}
+
+FQuat FMovementSnapshot::InterpolateRotation(const FQuat& FromRotation, const FVector& FromAngularVelocity, const FQuat& ToRotation, const FVector& ToAngularVelocity, float Interval, float Alpha)
+{
+	const FQuat Q0 = FromRotation;
+	FQuat Q3 = ToRotation;
+	if ((Q0 | Q3) < 0.0f)
+		Q3 = Q3 * -1.0f;
+
+	//Bezier control points a third of the interval along each end's angular velocity
+	const FQuat Q1 = IntegrateRotation(Q0, FromAngularVelocity, Interval / 3.0f);
+	const FQuat Q2 = IntegrateRotation(Q3, ToAngularVelocity, -Interval / 3.0f);
+
+	//De Casteljau's algorithm with slerps
+	const FQuat Q01 = FQuat::Slerp(Q0, Q1, Alpha), Q12 = FQuat::Slerp(Q1, Q2, Alpha), Q23 = FQuat::Slerp(Q2, Q3, Alpha);
+	return FQuat::Slerp(FQuat::Slerp(Q01, Q12, Alpha), FQuat::Slerp(Q12, Q23, Alpha), Alpha).GetNormalized();
+}
+
+FQuat FMovementSnapshot::IntegrateRotation(const FQuat& Rotation, const FVector& AngularVelocity, float DeltaTime)
+{
+	//Angular velocities are in degrees per second and world space
+	const float Angle = FMath::DegreesToRadians(AngularVelocity.Size()) * DeltaTime;
+	return FMath::IsNearlyZero(Angle) ? Rotation : (FQuat(AngularVelocity.GetSafeNormal(), Angle) * Rotation).GetNormalized();
+}
+
+FMovementSnapshot FMovementSnapshot::Extrapolate(const FMovementSnapshot& From, float Time)
+{
+	const float DeltaTime = Time - From.TimeStamp;
+	FMovementSnapshot Result = From;
+	Result.TimeStamp = Time;
+	Result.Location = From.Location + From.LinearVelocity * DeltaTime;
+	Result.Rotation = IntegrateRotation(From.Rotation, From.AngularVelocity, DeltaTime);
+	return Result;
+}
+
+bool FMovementSnapshotPacket::Decode(FSnapshotBaselineHistory& History, float ReceiveTime, FQuantizedMovementSnapshot& OutSnapshot) const
+{
+	if (bKeyframe)
+	{
+		OutSnapshot = State;
+		OutSnapshot.UnwrapTimeStamp(ReceiveTime);
+	}
+	else
+	{
+		const FQuantizedMovementSnapshot* Baseline = History.Find(BaselineSequence);
+		if (Baseline == nullptr)
+			return false;
+
+		OutSnapshot = FQuantizedMovementSnapshot::ApplyDelta(*Baseline, State);
+	}
+
+	History.Add(Sequence, OutSnapshot);
+	return true;
+}
+
+void FMovementSnapshotPacket::DecodeRedundant(const FQuantizedMovementSnapshot& Snapshot, FSnapshotBaselineHistory& History, TArray<FQuantizedMovementSnapshot, TInlineAllocator<MaxRedundantStates>>& OutSnapshots) const
+{
+	OutSnapshots.Reset();
+	for (int32 Index = 0; Index < RedundantStates.Num(); Index++)
+	{
+		FQuantizedMovementSnapshot Redundant = FQuantizedMovementSnapshot::ApplyDelta(Snapshot, RedundantStates[Index]);
+		Redundant.TimeStampMs = Snapshot.TimeStampMs - RedundantStates[Index].TimeStampMs;
+		OutSnapshots.Add(Redundant);
+
+		const uint16 RedundantSequence = uint16(Sequence - 1 - Index);
+		if (History.Find(RedundantSequence) == nullptr)
+			History.Add(RedundantSequence, Redundant);
+	}
+}
+
+bool FMovementSnapshotPacket::NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess)
+{
+	Ar << Sequence;
+	uint8 KeyframeBit = bKeyframe ? 1 : 0;
+	Ar.SerializeBits(&KeyframeBit, 1);
+	bKeyframe = KeyframeBit != 0;
+
+	//Baselines are recent, send how far back they are rather than their sequence
+	if (!bKeyframe)
+	{
+		uint32 BaselineAge = uint16(Sequence - BaselineSequence);
+		Ar.SerializeInt(BaselineAge, FSnapshotBaselineHistory::Capacity);
+		BaselineSequence = uint16(Sequence - BaselineAge);
+	}
+
+	//Keyframes are decoded against the receiver's clock, their stamp only needs the low bits
+	State.Serialize(Ar, !bKeyframe, true);
+
+	//Only clients report a view delay, the multicast packets leave it at zero
+	uint8 ViewDelayBit = ViewDelayMs > 0 ? 1 : 0;
+	Ar.SerializeBits(&ViewDelayBit, 1);
+	if (ViewDelayBit != 0)
+	{
+		uint32 ViewDelay = ViewDelayMs;
+		Ar.SerializeIntPacked(ViewDelay);
+		ViewDelayMs = uint16(FMath::Min<uint32>(ViewDelay, MAX_uint16));
+	}
+	else
+		ViewDelayMs = 0;
+
+	uint32 NumRedundant = FMath::Min(RedundantStates.Num(), MaxRedundantStates);
+	Ar.SerializeInt(NumRedundant, MaxRedundantStates + 1);
+	if (Ar.IsLoading())
+		RedundantStates.SetNum(NumRedundant);
+
+	for (uint32 Index = 0; Index < NumRedundant; Index++)
+	{
+		RedundantStates[Index].Serialize(Ar, true);
+	}
+
+	bOutSuccess = !Ar.IsError();
+	return true;
+}
+
+FMovementSnapshotPacket FSnapshotDeltaEncoder::Encode(const FQuantizedMovementSnapshot& Snapshot, const FPhysicsReplicationSettings& Settings, bool bAcknowledgedBaselines)
+{
+	FMovementSnapshotPacket Packet;
+	Packet.Sequence = NextSequence++;
+	Packet.State = Snapshot;
+
+	//Baselines that fell out of the history or the receiver can't decode anymore force a keyframe
+	const FQuantizedMovementSnapshot* Baseline = bHasBaseline ? SentSnapshots.Find(BaselineSequence) : nullptr;
+	const bool bBaselineUsable = Baseline != nullptr && Baseline->Precision == Snapshot.Precision
+		&& uint16(Packet.Sequence - BaselineSequence) < FSnapshotBaselineHistory::Capacity;
+	const bool bKeyframeDue = SnapshotsSinceKeyframe + 1 >= Settings.KeyframeInterval;
+	if (Settings.bEnableDeltaCompression && bBaselineUsable && !bKeyframeDue)
+	{
+		Packet.bKeyframe = false;
+		Packet.BaselineSequence = BaselineSequence;
+		Packet.State = Snapshot.GetDelta(*Baseline);
+		SnapshotsSinceKeyframe++;
+	}
+	else
+	{
+		SnapshotsSinceKeyframe = 0;
+
+		//Nobody acknowledges multicasts, assume the keyframe arrives - if it didn't the receiver waits for the next one
+		if (!bAcknowledgedBaselines)
+		{
+			BaselineSequence = Packet.Sequence;
+			bHasBaseline = true;
+		}
+	}
+
+	//Repeat the previous snapshots as deltas against this one, they stop at the first that fell out of the history
+	const int32 NumRedundant = FMath::Clamp(Settings.RedundantSnapshots, 0, (int32)FMovementSnapshotPacket::MaxRedundantStates);
+	for (int32 Index = 0; Index < NumRedundant; Index++)
+	{
+		const FQuantizedMovementSnapshot* Previous = SentSnapshots.Find(uint16(Packet.Sequence - 1 - Index));
+		if (Previous == nullptr || Previous->Precision != Snapshot.Precision)
+			break;
+
+		FQuantizedMovementSnapshot Redundant = Previous->GetDelta(Snapshot);
+		Redundant.TimeStampMs = Snapshot.TimeStampMs - Previous->TimeStampMs;
+		Packet.RedundantStates.Add(Redundant);
+	}
+
+	SentSnapshots.Add(Packet.Sequence, Snapshot);
+	return Packet;
+}
+
+void FSnapshotDeltaEncoder::Acknowledge(uint16 Sequence)
+{
+	if (SentSnapshots.Find(Sequence) == nullptr)
+		return;
+
+	if (!bHasBaseline || FSnapshotBaselineHistory::IsNewerSequence(Sequence, BaselineSequence))
+	{
+		BaselineSequence = Sequence;
+		bHasBaseline = true;
+	}
+}
+
+void FSnapshotJitterEstimator::AddArrival(float TimeStamp, float ArrivalTime, uint16 Sequence, const FJitterBufferSettings& Settings)
+{
+	const int32 Window = FMath::Max(Settings.SampleWindow, 8);
+	if (Transits.Num() != Window)
+	{
+		Transits.Reset(Window);
+		NextTransit = 0;
+	}
+
+	if (Transits.Num() < Window)
+		Transits.Add(ArrivalTime - TimeStamp);
+	else
+		Transits[NextTransit] = ArrivalTime - TimeStamp;
+	NextTransit = (NextTransit + 1) % Window;
+
+	//Late arrivals filled a gap that was already counted as lost
+	if (bHasSequence && !FSnapshotBaselineHistory::IsNewerSequence(Sequence, NewestSequence))
+	{
+		LossRate = FMath::Max(LossRate - 1.0f / Window, 0.0f);
+		return;
+	}
+
+	//Every expected snapshot moves the average, the skipped ones toward 1 and this one toward 0
+	if (bHasSequence)
+	{
+		const int32 Lost = FMath::Clamp(int32(uint16(Sequence - NewestSequence)) - 1, 0, Window);
+		for (int32 Index = 0; Index < Lost; Index++)
+		{
+			LossRate += (1.0f - LossRate) / Window;
+		}
+
+		//Senders thinning out their snapshots by distance or interest space them further apart than the send rate, lost ones are covered by the loss rate
+		const float Gap = (TimeStamp - NewestTimeStamp) / (Lost + 1);
+		if (Gap > 0.0f)
+			ArrivalInterval = ArrivalInterval > 0.0f ? FMath::Lerp(ArrivalInterval, Gap, 0.125f) : Gap;
+	}
+	LossRate -= LossRate / Window;
+	NewestSequence = Sequence;
+	NewestTimeStamp = TimeStamp;
+	bHasSequence = true;
+}
+
+float FSnapshotJitterEstimator::GetTargetDelay(float Interval, const FJitterBufferSettings& Settings, FJitterBufferStats& OutStats) const
+{
+	TArray<float, TInlineAllocator<128>> Sorted;
+	Sorted.Append(Transits);
+	Sorted.Sort();
+
+	const int32 PercentileIndex = FMath::Clamp(FMath::CeilToInt(Settings.TargetPercentile * Sorted.Num()) - 1, 0, Sorted.Num() - 1);
+	OutStats.TransitPercentile = Sorted[PercentileIndex] * 1000.0f;
+	OutStats.Jitter = (Sorted[PercentileIndex] - Sorted[0]) * 1000.0f;
+	OutStats.LossRate = LossRate;
+
+	//The snapshot after the buffered time has to have arrived, which takes its transit plus up to a send interval, plus whatever interval lost snapshots leave open
+	const float SnapshotInterval = FMath::Max(Interval, ArrivalInterval) * 1000.0f;
+	const float Delay = OutStats.TransitPercentile + SnapshotInterval * (1.0f + LossRate * Settings.LossCompensation);
+	const float MaxDelay = FMath::Max3(Settings.MaxBufferDelay, Settings.MinBufferDelay, SnapshotInterval * Settings.MaxDelayIntervals);
+	return FMath::Clamp(Delay, Settings.MinBufferDelay, MaxDelay);
+}
+
+void FMovementSnapShotBuffer::UpdateBufferDelay(float Time)
+{
+	SCOPE_CYCLE_COUNTER(STAT_UpdateBufferDelay);
+
+	const float DeltaTime = LastDelayUpdateTime >= 0.0f ? FMath::Max(Time - LastDelayUpdateTime, 0.0f) : 0.0f;
+	LastDelayUpdateTime = Time;
+
+	if (!JitterSettings.bAdaptiveDelay || !JitterEstimator.HasSamples())
+	{
+		JitterStats.PlayoutRate = 1.0f;
+		return;
+	}
+
+	JitterStats.TargetDelay = JitterEstimator.GetTargetDelay(GetBufferInterval(), JitterSettings, JitterStats);
+
+	//Changing the delay by d over t plays the snapshots at 1 - d/t speed, bounding d keeps the motion smooth
+	const float MaxChange = DeltaTime * 1000.0f * JitterSettings.MaxTimeScale;
+	const float Change = FMath::Clamp(JitterStats.TargetDelay - BufferDelay, -MaxChange, MaxChange);
+	BufferDelay += Change;
+	JitterStats.PlayoutRate = DeltaTime > 0.0f ? 1.0f - Change / (DeltaTime * 1000.0f) : 1.0f;
+}
+
+bool FMovementValidator::IsWellFormed(const FMovementSnapshotPacket& Packet, const FMovementSnapshotQuantization& Quantization)
+{
+	//NetSerialize already bounds the count, the baseline age and the packed enums - these are what it can't know
+	if (!Packet.bKeyframe && Packet.BaselineSequence == Packet.Sequence)
+		return false;
+
+	//Senders clamp their velocities before quantizing, a keyframe's are absolute so they can be checked before decoding
+	if (Packet.bKeyframe)
+	{
+		const FMovementSnapshot State = Packet.State.Dequantize();
+		if (State.LinearVelocity.SizeSquared() > FMath::Square(Quantization.MaxLinearSpeed + 1.0f)
+			|| State.AngularVelocity.SizeSquared() > FMath::Square(Quantization.MaxAngularSpeed + 1.0f))
+			return false;
+	}
+
+	//Redundant states are the previous sends newest first, so each is at least as old as the one before it
+	uint32 PreviousAge = 0;
+	for (const FQuantizedMovementSnapshot& Redundant : Packet.RedundantStates)
+	{
+		if (Redundant.TimeStampMs < PreviousAge)
+			return false;
+
+		PreviousAge = Redundant.TimeStampMs;
+	}
+
+	return true;
+}
+
+EMovementValidationFailure FMovementValidator::CheckKinematics(const FMovementSnapshot& Previous, const FMovementSnapshot& Snapshot, const FMovementValidationSettings& Settings)
+{
+	//A stamp from before the last accepted one would let the client put the ship anywhere it was allowed to be back then, checked first so a replay isn't counted as anything else
+	const float DeltaTime = Snapshot.TimeStamp - Previous.TimeStamp;
+	if (DeltaTime <= KINDA_SMALL_NUMBER)
+		return EMovementValidationFailure::Stale;
+
+	if (Snapshot.LinearVelocity.SizeSquared() > FMath::Square(Settings.MaxSpeed))
+		return EMovementValidationFailure::Speed;
+
+	if ((Snapshot.LinearVelocity - Previous.LinearVelocity).SizeSquared() > FMath::Square(Settings.MaxAcceleration * DeltaTime)
+		|| (Snapshot.AngularVelocity - Previous.AngularVelocity).SizeSquared() > FMath::Square(Settings.MaxAngularAcceleration * DeltaTime))
+		return EMovementValidationFailure::Acceleration;
+
+	//Trapezoidal integration of the velocities, the velocity between the snapshots may only have strayed as far as the acceleration limit allows
+	const FVector Expected = Previous.Location + (Previous.LinearVelocity + Snapshot.LinearVelocity) * 0.5f * DeltaTime;
+	const float Tolerance = Settings.PositionTolerance + 0.5f * Settings.MaxAcceleration * DeltaTime * DeltaTime;
+	if (FVector::DistSquared(Expected, Snapshot.Location) > FMath::Square(Tolerance))
+		return EMovementValidationFailure::Displacement;
+
+	return EMovementValidationFailure::None;
+}
+
+uint32 FMovementValidator::ClampTimeStamp(uint32 TimeStampMs, float ServerTime, float MaxClockError)
+{
+	//Without the clamp a stamp far in the future buys the client an unbounded displacement tolerance
+	const double ServerTimeMs = double(ServerTime) * 1000.0;
+	const double MaxErrorMs = double(FMath::Max(MaxClockError, 0.0f)) * 1000.0;
+	return uint32(FMath::Clamp(double(TimeStampMs), FMath::Max(ServerTimeMs - MaxErrorMs, 0.0), ServerTimeMs + MaxErrorMs) + 0.5);
+}
+
+EMovementValidationFailure FMovementValidator::CheckHydrostatics(const FMovementSnapshot& Snapshot, const FBox& HullBounds, const FFloatInterval& WaterHeights, const FMovementValidationSettings& Settings)
+{
+	const FRotator Attitude = Snapshot.Rotation.Rotator();
+	if (FMath::Abs(Attitude.Roll) > Settings.MaxHeelAngle || FMath::Abs(Attitude.Pitch) > Settings.MaxTrimAngle)
+		return EMovementValidationFailure::Attitude;
+
+	//A floating hull's keel is under the highest wave under it and its deck above the lowest trough
+	if (HullBounds.IsValid && WaterHeights.IsValid())
+	{
+		const FBox WorldBounds = HullBounds.TransformBy(FTransform(Snapshot.Rotation, Snapshot.Location));
+		if (WorldBounds.Min.Z > WaterHeights.Max + Settings.DraftTolerance || WorldBounds.Max.Z < WaterHeights.Min - Settings.DraftTolerance)
+			return EMovementValidationFailure::Draft;
+	}
+
+	return EMovementValidationFailure::None;
+}
+
+void FShipPoseHistory::Reset(float Duration, float RecordRate)
+{
+	//One more than the duration needs, so the oldest pose still brackets the oldest time
+	Poses.Capacity = FMath::Max(FMath::CeilToInt(Duration * RecordRate) + 1, 2);
+	Poses.BufferDelay = 0.0f;
+	Poses.MaxExtrapolationTime = Duration;
+	Poses.JitterSettings.bAdaptiveDelay = false;
+	Poses.Reset();
+}
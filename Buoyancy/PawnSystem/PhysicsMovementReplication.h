@@ -4,7 +4,7 @@
 *
 * Created by: Tobias Moos
 * Project name: Sails of War
-* Unreal Engine version: 4.19
+* Unreal Engine version: 4.22
 * Created on: 2020/01/08
 *
 * Last Edited on: 2020/12/11
@@ -28,6 +28,8 @@
 
 #include "PhysicsMovementReplication.generated.h"
 
+DECLARE_STATS_GROUP(TEXT("PhysicsMovementReplication - Snapshot Replication"), STATGROUP_PhysicsReplication, STATCAT_Advanced);
+
 UENUM()
 enum EEventFlag
 {
@@ -36,6 +38,198 @@ enum EEventFlag
 	EF_Correction,
 };
 
+//The precision snapshot locations are quantized to on the wire
+UENUM(BlueprintType)
+enum class ESnapshotPositionPrecision : uint8
+{
+	Centimeter,
+	Millimeter,
+	TenthMillimeter,
+};
+
+//Settings for quantizing snapshots, only the precision is sent - the velocity limits just bound what the sender writes
+USTRUCT(BlueprintType)
+struct FMovementSnapshotQuantization
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere)
+		ESnapshotPositionPrecision PositionPrecision = ESnapshotPositionPrecision::Centimeter;
+
+	UPROPERTY(EditAnywhere)
+		float MaxLinearSpeed = 10000.0f; //Centimeters per second, faster linear velocities are clamped
+
+	UPROPERTY(EditAnywhere)
+		float MaxAngularSpeed = 360.0f; //Degrees per second, faster angular velocities are clamped - also bounded by the body's MaxAngularVelocity
+
+	FMovementSnapshotQuantization() {};
+};
+
+//Settings for sizing the playout delay of a snapshot buffer from the jitter and loss of the snapshots it receives
+USTRUCT(BlueprintType)
+struct FJitterBufferSettings
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere)
+		bool bAdaptiveDelay = true; //Size the delay from the measured transit times, otherwise BufferSize is used as is
+
+	UPROPERTY(EditAnywhere, meta = (EditCondition = "bAdaptiveDelay", ClampMin = "0.5", ClampMax = "1.0"))
+		float TargetPercentile = 0.95f; //The fraction of snapshots that should arrive before they're needed
+
+	UPROPERTY(EditAnywhere, meta = (EditCondition = "bAdaptiveDelay"))
+		float MinBufferDelay = 50.0f; //in milliseconds
+
+	UPROPERTY(EditAnywhere, meta = (EditCondition = "bAdaptiveDelay"))
+		float MaxBufferDelay = 500.0f; //in milliseconds, raised for buffers whose snapshots arrive further apart, see MaxDelayIntervals
+
+	UPROPERTY(EditAnywhere, meta = (EditCondition = "bAdaptiveDelay", ClampMin = "1.0"))
+		float MaxDelayIntervals = 2.0f; //The delay limit is at least this many observed snapshot intervals, so ships thinned out by distance or interest still interpolate
+
+	UPROPERTY(EditAnywhere, meta = (EditCondition = "bAdaptiveDelay", ClampMin = "0.0"))
+		float LossCompensation = 2.0f; //Extra send intervals of delay at 100% packet loss, lets the interpolation bridge lost snapshots
+
+	UPROPERTY(EditAnywhere, meta = (EditCondition = "bAdaptiveDelay", ClampMin = "0.01", ClampMax = "0.5"))
+		float MaxTimeScale = 0.1f; //How far the playout may speed up or slow down while the delay moves toward its target, 0.1 plays between 90% and 110% speed
+
+	UPROPERTY(EditAnywhere, meta = (EditCondition = "bAdaptiveDelay", ClampMin = "8"))
+		int32 SampleWindow = 64; //The number of recent transit times the percentile is taken over
+
+	FJitterBufferSettings() {};
+};
+
+//What the adaptive playout delay of a snapshot buffer measured and chose
+USTRUCT(BlueprintType)
+struct FJitterBufferStats
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly)
+		float TargetDelay = 0.0f; //in milliseconds, the delay the buffer is moving toward
+
+	UPROPERTY(BlueprintReadOnly)
+		float TransitPercentile = 0.0f; //in milliseconds, the target percentile of the measured transit times
+
+	UPROPERTY(BlueprintReadOnly)
+		float Jitter = 0.0f; //in milliseconds, the spread between the target percentile and the fastest transit
+
+	UPROPERTY(BlueprintReadOnly)
+		float LossRate = 0.0f; //The estimated fraction of snapshots that never arrive
+
+	UPROPERTY(BlueprintReadOnly)
+		float PlayoutRate = 1.0f; //The speed the buffered time currently advances at, below 1 while the delay grows
+
+	FJitterBufferStats() {};
+};
+
+//Settings for skipping snapshots receivers can predict, the sender runs the same dead reckoning as the receivers and only sends when it's wrong
+USTRUCT(BlueprintType)
+struct FDeadReckoningSettings
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere)
+		bool bEnableSendSuppression = true; //Disable to send a snapshot every send interval
+
+	UPROPERTY(EditAnywhere, meta = (EditCondition = "bEnableSendSuppression"))
+		float PositionThreshold = 10.0f; //cm, a snapshot is sent once the predicted location is further than this from the actual one
+
+	UPROPERTY(EditAnywhere, meta = (EditCondition = "bEnableSendSuppression"))
+		float RotationThreshold = 1.0f; //Degrees, a snapshot is sent once the predicted rotation is further than this from the actual one
+
+	UPROPERTY(EditAnywhere, meta = (EditCondition = "bEnableSendSuppression", ClampMin = "0.05"))
+		float HeartbeatInterval = 1.0f; //Seconds, a snapshot is always sent after this long, bounding how far receivers extrapolate
+
+	FDeadReckoningSettings() {};
+};
+
+//Settings for the server's plausibility checks of client snapshots, the limits are loose enough for honest clients on a rough sea
+USTRUCT(BlueprintType)
+struct FMovementValidationSettings
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere)
+		bool bEnableValidation = true; //Disable to trust every client snapshot
+
+	UPROPERTY(EditAnywhere, meta = (EditCondition = "bEnableValidation"))
+		float MaxSpeed = 3000.0f; //cm/s
+
+	UPROPERTY(EditAnywhere, meta = (EditCondition = "bEnableValidation"))
+		float MaxAcceleration = 2000.0f; //cm/s^2, wave slams and ship collisions have to stay below this
+
+	UPROPERTY(EditAnywhere, meta = (EditCondition = "bEnableValidation"))
+		float MaxAngularAcceleration = 360.0f; //deg/s^2
+
+	UPROPERTY(EditAnywhere, meta = (EditCondition = "bEnableValidation"))
+		float PositionTolerance = 100.0f; //cm the location may be off from integrating the velocities between two snapshots, on top of what MaxAcceleration allows
+
+	UPROPERTY(EditAnywhere, meta = (EditCondition = "bEnableValidation", ClampMin = "0.0", ClampMax = "180.0"))
+		float MaxHeelAngle = 70.0f; //Degrees the ship may roll
+
+	UPROPERTY(EditAnywhere, meta = (EditCondition = "bEnableValidation", ClampMin = "0.0", ClampMax = "90.0"))
+		float MaxTrimAngle = 45.0f; //Degrees the ship may pitch
+
+	UPROPERTY(EditAnywhere, meta = (EditCondition = "bEnableValidation"))
+		float DraftTolerance = 300.0f; //cm the hull may be clear of the water or under it, the surface between the points sampled under the hull isn't known
+
+	UPROPERTY(EditAnywhere, meta = (EditCondition = "bEnableValidation", ClampMin = "0.0"))
+		float CorrectionInterval = 0.5f; //Seconds between corrections sent to a client, so one that's still catching up isn't flooded
+
+	FMovementValidationSettings() {};
+};
+
+//Settings for the server's lag compensated collision resolution between ships
+USTRUCT(BlueprintType)
+struct FCollisionRewindSettings
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere)
+		bool bEnableLagCompensation = true; //Disable to leave collisions involving client owned ships to the server's physics alone
+
+	UPROPERTY(EditAnywhere, meta = (EditCondition = "bEnableLagCompensation", ClampMin = "0.1"))
+		float HistoryDuration = 1.0f; //Seconds of poses kept, the furthest a collision can be rewound
+
+	UPROPERTY(EditAnywhere, meta = (EditCondition = "bEnableLagCompensation", ClampMin = "1.0"))
+		float RecordRate = 30.0f; //Poses recorded per second for server owned ships, client owned ones record every accepted snapshot
+
+	UPROPERTY(EditAnywhere, meta = (EditCondition = "bEnableLagCompensation", ClampMin = "0.0", ClampMax = "1.0"))
+		float Restitution = 0.2f; //How much of the closing speed the ships bounce back with
+
+	UPROPERTY(EditAnywhere, meta = (EditCondition = "bEnableLagCompensation", ClampMin = "0.0"))
+		float CollisionCooldown = 0.25f; //Seconds before a ship's collisions are resolved again, contacts report a hit every frame
+
+	FCollisionRewindSettings() {};
+};
+
+//Settings for steering replicated bodies toward their interpolated state instead of teleporting them every frame
+USTRUCT(BlueprintType)
+struct FProxyCorrectionSettings
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere)
+		bool bEnableVelocityCorrection = true; //Disable to teleport replicated bodies onto their interpolated state every frame
+
+	UPROPERTY(EditAnywhere, meta = (EditCondition = "bEnableVelocityCorrection", ClampMin = "0.0"))
+		float PositionGain = 10.0f; //1/s, the velocity added per cm of location error
+
+	UPROPERTY(EditAnywhere, meta = (EditCondition = "bEnableVelocityCorrection", ClampMin = "0.0"))
+		float RotationGain = 10.0f; //1/s, the angular velocity added per degree of rotation error
+
+	UPROPERTY(EditAnywhere, meta = (EditCondition = "bEnableVelocityCorrection", ClampMin = "0.0"))
+		float DampingGain = 20.0f; //1/s, how fast the body's velocities converge on the commanded ones, higher values damp contact responses harder
+
+	UPROPERTY(EditAnywhere, meta = (EditCondition = "bEnableVelocityCorrection"))
+		float SnapDistance = 500.0f; //cm, bodies further than this from their target are teleported
+
+	UPROPERTY(EditAnywhere, meta = (EditCondition = "bEnableVelocityCorrection"))
+		float SnapAngle = 30.0f; //Degrees, bodies rotated further than this from their target are teleported
+
+	FProxyCorrectionSettings() {};
+};
+
 //Container containing the settings for replicating this actor
 USTRUCT(BlueprintType)
 struct FPhysicsReplicationSettings
@@ -46,13 +240,50 @@ struct FPhysicsReplicationSettings
 		uint32 SendRate = 20; //Number of snapshots to send per second
 
 	UPROPERTY(EditAnywhere)
-		float BufferSize = 500.0f; //in milliseconds
+		float BufferSize = 100.0f; //in milliseconds, the interpolation delay - a few send intervals is enough with hermite interpolation and a synchronized clock. The starting delay when it's adaptive
+
+	UPROPERTY(EditAnywhere)
+		FJitterBufferSettings JitterBuffer; //How the interpolation delay adapts to each sender's connection
+
+	UPROPERTY(EditAnywhere)
+		FMovementSnapshotQuantization Quantization; //How snapshots are compressed before they're sent
+
+	UPROPERTY(EditAnywhere)
+		bool bEnableDeltaCompression = true; //Send snapshots as deltas against a baseline the receiver has, otherwise every snapshot is a keyframe
+
+	UPROPERTY(EditAnywhere, meta = (EditCondition = "bEnableDeltaCompression", ClampMin = "1"))
+		int32 KeyframeInterval = 10; //Snapshots between keyframes, receivers that lost their baseline recover on the next keyframe
+
+	UPROPERTY(EditAnywhere)
+		FDeadReckoningSettings DeadReckoning; //Skips snapshots the receivers would have predicted anyway
+
+	UPROPERTY(EditAnywhere, meta = (ClampMin = "0", ClampMax = "7"))
+		int32 RedundantSnapshots = 2; //Previously sent snapshots repeated in every packet as small deltas, so a single lost packet never leaves a gap
+
+	UPROPERTY(EditAnywhere)
+		FProxyCorrectionSettings Correction; //How replicated bodies are moved onto their interpolated state
+
+	UPROPERTY(EditAnywhere)
+		FMovementValidationSettings Validation; //How the server checks the snapshots of client owned ships
+
+	UPROPERTY(EditAnywhere)
+		FCollisionRewindSettings CollisionRewind; //How the server rewinds ships to resolve their collisions
 
 		FPhysicsReplicationSettings() {};
 };
 
-//TODO: COMPRESS USING QUANTIZED VECTORS
-//A single snapshot consisting of velocities, position, orientation, a timestamp and an event flag.
+/*
+* A single snapshot consisting of velocities, position, orientation, a timestamp and an event flag.
+* Snapshots are quantized when sent, see NetSerialize():
+*	Header - the position precision, the rotation's dropped component and the event flag, 2 bits each
+*	Location - packed to the precision set by Quantization
+*	Rotation - smallest three, the others quantized to RotationComponentBits and packed like the vectors
+*	LinearVelocity - packed to 1cm/s, clamped to Quantization.MaxLinearSpeed
+*	AngularVelocity - packed to 0.1deg/s, clamped to Quantization.MaxAngularSpeed
+*	TimeStamp - whole milliseconds, rebuilt into the float in seconds so it's no more precise than TimeStamp itself - a millisecond for the first two hours of a session.
+*		Sent whole here, FMovementSnapshotPacket's keyframes only send its low bits and deltas the milliseconds since their baseline.
+* See FQuantizedMovementSnapshot for the quantized form.
+*/
 USTRUCT(BlueprintType)
 struct FMovementSnapshot
 {
@@ -76,9 +307,43 @@ struct FMovementSnapshot
 	UPROPERTY()
 		int8 EventFlag = 0;
 
+	UPROPERTY(Transient)
+		FMovementSnapshotQuantization Quantization; //Set by the sender, only the position precision is received
+
 	FMovementSnapshot() {};
 	FMovementSnapshot(FVector LinVel, FVector AngVel, FVector Loc, FQuat Rot, float Time) :
-		LinearVelocity(LinVel), AngularVelocity(AngularVelocity), Location(Loc), Rotation(Rot), TimeStamp(Time) {}
+		LinearVelocity(LinVel), AngularVelocity(AngVel), Location(Loc), Rotation(Rot), TimeStamp(Time) {}
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+
+	/**
+	*	Interpolate between two snapshots using their velocities -
+	*	a cubic hermite curve for the location, and a cubic bezier on the unit quaternion sphere (squad-style) for the rotation
+	*	@param	A - The snapshot at or before the interpolated time
+	*	@param	B - The snapshot after the interpolated time
+	*	@param	Alpha - The fraction of the time between the snapshots, see FMovementSnapShotBuffer::GetInterpolationAlpha()
+	*	@return	FMovementSnapshot - the interpolated snapshot, with the curve's velocities
+	*/
+	static FMovementSnapshot Interpolate(const FMovementSnapshot& A, const FMovementSnapshot& B, float Alpha);
+
+	/**
+	*	Dead reckon a snapshot forward with its velocities held constant, senders and receivers must predict the same way
+	*	@param	From - The snapshot to predict from
+	*	@param	Time - The time to predict to
+	*	@return	FMovementSnapshot - the predicted snapshot
+	*/
+	static FMovementSnapshot Extrapolate(const FMovementSnapshot& From, float Time);
+
+	/* The cubic hermite location and its derivative used by Interpolate(), Interval is in seconds */
+	static void InterpolateLocation(const FVector& FromLocation, const FVector& FromVelocity, const FVector& ToLocation, const FVector& ToVelocity, float Interval, float Alpha, FVector& OutLocation, FVector& OutVelocity);
+
+	/* The cubic bezier rotation used by Interpolate(), angular velocities are in degrees per second and Interval in seconds */
+	static FQuat InterpolateRotation(const FQuat& FromRotation, const FVector& FromAngularVelocity, const FQuat& ToRotation, const FVector& ToAngularVelocity, float Interval, float Alpha);
+
+	/* Rotate by an angular velocity in degrees per second held for DeltaTime seconds */
+	static FQuat IntegrateRotation(const FQuat& Rotation, const FVector& AngularVelocity, float DeltaTime);
+
+	static const int32 RotationComponentBits = 12; //Bits per quantized quaternion component
 
 	//bool operator <(const FMovementSnapshot& Other) const
 	//{
@@ -86,70 +351,425 @@ struct FMovementSnapshot
 	//}
 };
 
-//A buffer containing a series of snapshots of an actor. This is used to interpolate movement, position, rotation and velocity between buffer indexes.
+template<>
+struct TStructOpsTypeTraits<FMovementSnapshot> : public TStructOpsTypeTraitsBase2<FMovementSnapshot>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
+
+/*
+* A snapshot quantized to integers, exactly what goes on the wire.
+* Sender and receiver both keep the quantized form of sent snapshots, so a baseline is bit identical on both ends
+* and deltas between two snapshots are plain integer differences.
+*/
+struct FQuantizedMovementSnapshot
+{
+	FIntVector Location = FIntVector::ZeroValue; //In units of Precision
+	FIntVector Rotation = FIntVector::ZeroValue; //The smallest three quaternion components
+	FIntVector LinearVelocity = FIntVector::ZeroValue; //Centimeters per second
+	FIntVector AngularVelocity = FIntVector::ZeroValue; //Tenths of a degree per second
+	uint32 TimeStampMs = 0;
+	uint8 RotationLargestIndex = 0; //The quaternion component dropped from Rotation
+	uint8 EventFlag = 0;
+	ESnapshotPositionPrecision Precision = ESnapshotPositionPrecision::Centimeter;
+
+	FQuantizedMovementSnapshot() {};
+
+	/* Quantize a snapshot, clamping its velocities to its quantization limits */
+	static FQuantizedMovementSnapshot Quantize(const FMovementSnapshot& Snapshot);
+
+	/* Rebuild the snapshot the receiver will see */
+	FMovementSnapshot Dequantize() const;
+
+	static const int32 WrappedTimeStampBits = 16; //A wrapped stamp repeats every 65.5 seconds, receivers restore it from a clock within half of that
+
+	/**
+	*	Serialize this snapshot
+	*	@param	Ar - The archive to read or write
+	*	@param	bDelta - True if this holds the difference to a baseline, see GetDelta()
+	*	@param	bWrapTimeStamp - True to send only the low WrappedTimeStampBits of an absolute stamp, the receiver restores it with UnwrapTimeStamp()
+	*/
+	void Serialize(FArchive& Ar, bool bDelta, bool bWrapTimeStamp = false);
+
+	/**
+	*	Restore a wrapped timestamp to the stamp sharing its low bits closest to the receiver's clock
+	*	@param	ReferenceTime - The receiver's replication time in seconds, on the sender's clock
+	*/
+	void UnwrapTimeStamp(float ReferenceTime);
+
+	/* The difference from a baseline to this snapshot, rotations are only differenced when they share their dropped component */
+	FQuantizedMovementSnapshot GetDelta(const FQuantizedMovementSnapshot& Baseline) const;
+
+	/* Rebuild a snapshot from a baseline and a delta made by GetDelta() */
+	static FQuantizedMovementSnapshot ApplyDelta(const FQuantizedMovementSnapshot& Baseline, const FQuantizedMovementSnapshot& Delta);
+};
+
+//The last quantized snapshots sent or received, indexed by sequence number
+struct FSnapshotBaselineHistory
+{
+	static const int32 Capacity = 32; //Baselines older than this many snapshots can't be used
+
+	FSnapshotBaselineHistory() { Reset(); }
+
+	void Add(uint16 Sequence, const FQuantizedMovementSnapshot& Snapshot)
+	{
+		const int32 Index = Sequence % Capacity;
+		Snapshots[Index] = Snapshot;
+		Sequences[Index] = Sequence;
+		bValid[Index] = true;
+	}
+
+	const FQuantizedMovementSnapshot* Find(uint16 Sequence) const
+	{
+		const int32 Index = Sequence % Capacity;
+		return bValid[Index] && Sequences[Index] == Sequence ? &Snapshots[Index] : nullptr;
+	}
+
+	void Reset()
+	{
+		FMemory::Memzero(bValid, sizeof(bValid));
+	}
+
+	/* Sequence numbers wrap, A is newer than B if it's less than half the sequence space ahead */
+	static bool IsNewerSequence(uint16 A, uint16 B) { return int16(A - B) > 0; }
+
+private:
+	FQuantizedMovementSnapshot Snapshots[Capacity];
+	uint16 Sequences[Capacity];
+	bool bValid[Capacity];
+};
+
+//A snapshot as sent by the movement RPCs, either a keyframe or a delta against an earlier snapshot
+USTRUCT()
+struct FMovementSnapshotPacket
+{
+	GENERATED_BODY()
+
+	static const int32 MaxRedundantStates = 7; //The count is sent in 3 bits
+
+	uint16 Sequence = 0;
+	uint16 BaselineSequence = 0; //The snapshot the delta was made against, unused for keyframes
+	bool bKeyframe = true;
+	FQuantizedMovementSnapshot State; //The absolute snapshot for keyframes, otherwise the delta to the baseline
+	uint16 ViewDelayMs = 0; //How far behind the sending client plays out the other ships, so the server rewinds them to what it saw - zero costs a single bit
+
+	/*
+	* The snapshots sent with the previous sequences, newest first, as deltas from them to this packet's decoded snapshot.
+	* Their TimeStampMs holds how many milliseconds older than this packet's snapshot they are, so it packs small.
+	*/
+	TArray<FQuantizedMovementSnapshot, TInlineAllocator<MaxRedundantStates>> RedundantStates;
+
+	FMovementSnapshotPacket() {};
+
+	/**
+	*	Rebuild the snapshot, a delta can only be decoded if its baseline was received
+	*	@param	History - The snapshots received so far, the decoded snapshot is added to it
+	*	@param	ReceiveTime - The receiver's replication time, a keyframe's wrapped timestamp is restored against it
+	*	@param	OutSnapshot - The decoded quantized snapshot
+	*	@return	bool - false if the delta's baseline is missing, the packet should be dropped
+	*/
+	bool Decode(FSnapshotBaselineHistory& History, float ReceiveTime, FQuantizedMovementSnapshot& OutSnapshot) const;
+
+	/**
+	*	Rebuild the redundant snapshots carried by the packet, the ones missing from the history are added to it
+	*	@param	Snapshot - This packet's decoded snapshot, see Decode()
+	*	@param	History - The snapshots received so far
+	*	@param	OutSnapshots - The redundant snapshots, OutSnapshots[i] was sent with sequence Sequence - 1 - i
+	*/
+	void DecodeRedundant(const FQuantizedMovementSnapshot& Snapshot, FSnapshotBaselineHistory& History, TArray<FQuantizedMovementSnapshot, TInlineAllocator<MaxRedundantStates>>& OutSnapshots) const;
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FMovementSnapshotPacket> : public TStructOpsTypeTraitsBase2<FMovementSnapshotPacket>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
+
+/*
+* Encodes the snapshots of one sender into packets.
+* Acknowledged mode - deltas are made against the newest snapshot the receiver acknowledged, used for the owning client to the server.
+* Keyframe mode - deltas are made against the last keyframe, used for multicasts as there's no single receiver to acknowledge them.
+* Either mode falls back to a keyframe when it has no usable baseline.
+*/
+struct FSnapshotDeltaEncoder
+{
+	FSnapshotDeltaEncoder() {};
+
+	/**
+	*	Encode the next snapshot
+	*	@param	Snapshot - The quantized snapshot to send
+	*	@param	Settings - The replication settings of the sender
+	*	@param	bAcknowledgedBaselines - True to use acknowledged baselines, false to delta against the last keyframe
+	*	@return	FMovementSnapshotPacket - the packet to send
+	*/
+	FMovementSnapshotPacket Encode(const FQuantizedMovementSnapshot& Snapshot, const FPhysicsReplicationSettings& Settings, bool bAcknowledgedBaselines);
+
+	/* The receiver got a snapshot, it may be used as a baseline from now on */
+	void Acknowledge(uint16 Sequence);
+
+	void Reset() { *this = FSnapshotDeltaEncoder(); }
+
+private:
+	FSnapshotBaselineHistory SentSnapshots;
+	uint16 NextSequence = 0;
+	uint16 BaselineSequence = 0;
+	bool bHasBaseline = false;
+	int32 SnapshotsSinceKeyframe = 0;
+};
+
+/*
+* Measures the transit times and losses of the snapshots arriving at a buffer.
+* The transit time is the arrival time minus the snapshot's timestamp, so it includes the latency and any clock offset along with the jitter.
+* Losses are counted from gaps in the sequence numbers, senders suppressing snapshots don't spend a sequence number on them.
+*/
+struct FSnapshotJitterEstimator
+{
+	FSnapshotJitterEstimator() {};
+
+	/**
+	*	Record the arrival of a snapshot
+	*	@param	TimeStamp - The snapshot's timestamp in seconds
+	*	@param	ArrivalTime - The time it arrived, in the clock the buffer is played out with
+	*	@param	Sequence - The sequence number of the packet it arrived in
+	*	@param	Settings - The jitter buffer settings
+	*/
+	void AddArrival(float TimeStamp, float ArrivalTime, uint16 Sequence, const FJitterBufferSettings& Settings);
+
+	/**
+	*	Find the delay needed for the target percentile of snapshots to arrive in time
+	*	@param	Interval - The send interval in seconds, the observed interval between arrivals is used when it's longer
+	*	@param	Settings - The jitter buffer settings
+	*	@param	OutStats - Filled with the measurements the delay was chosen from
+	*	@return	float - the target delay in milliseconds, clamped to the settings' limits
+	*/
+	float GetTargetDelay(float Interval, const FJitterBufferSettings& Settings, FJitterBufferStats& OutStats) const;
+
+	bool HasSamples() const { return Transits.Num() > 0; }
+
+	/* Seconds between the timestamps of consecutive snapshots as they arrive, zero until two have */
+	float GetArrivalInterval() const { return ArrivalInterval; }
+
+	void Reset() { *this = FSnapshotJitterEstimator(); }
+
+private:
+	TArray<float> Transits; //Ring of the most recent transit times in seconds
+	int32 NextTransit = 0;
+	uint16 NewestSequence = 0;
+	bool bHasSequence = false;
+	float LossRate = 0.0f; //Exponential average of lost snapshots per expected snapshot
+	float NewestTimeStamp = 0.0f; //The timestamp of the newest snapshot that arrived in order
+	float ArrivalInterval = 0.0f; //Exponential average of the timestamp gaps between snapshots arriving in order, per expected snapshot
+};
+
+//Why the server rejected a client snapshot
+enum class EMovementValidationFailure : uint8
+{
+	None,
+	Speed,
+	Acceleration,
+	Displacement,
+	Attitude,
+	Draft,
+	Stale, //Not newer than the last accepted snapshot, a reordered packet or a replayed one
+};
+
+/*
+* Cheap plausibility checks for client snapshots, a few vector operations each so every snapshot can be checked.
+* Kinematics are checked against the last accepted snapshot, and a reduced order model of the hull checks the ship floats -
+* its heel and trim are bounded, and its hull's bounds have to straddle the water surface within a tolerance.
+* Packets get a stricter check before they're decoded, one only a modified client fails.
+*/
+struct FMovementValidator
+{
+	/**
+	*	Check a received packet holds what an unmodified client could have sent, run by the RPC's validation so failing disconnects
+	*	@param	Packet - The packet to check, before it's decoded
+	*	@param	Quantization - The sender's quantization settings, the limits it clamps to
+	*	@return	bool - false if the packet is malformed
+	*/
+	static bool IsWellFormed(const FMovementSnapshotPacket& Packet, const FMovementSnapshotQuantization& Quantization);
+
+	/**
+	*	Check a snapshot's velocities and location against the last accepted one
+	*	@param	Previous - The last accepted snapshot
+	*	@param	Snapshot - The snapshot to check
+	*	@param	Settings - The validation limits
+	*	@return	EMovementValidationFailure - None if the change between them is plausible
+	*/
+	static EMovementValidationFailure CheckKinematics(const FMovementSnapshot& Previous, const FMovementSnapshot& Snapshot, const FMovementValidationSettings& Settings);
+
+	/**
+	*	Clamp a client's timestamp to the times it could have sent a snapshot at, before the snapshot is checked
+	*	@param	TimeStampMs - The snapshot's timestamp
+	*	@param	ServerTime - The server's replication time in seconds
+	*	@param	MaxClockError - Seconds the stamp may be off from ServerTime either way, the round trip and the jitter window
+	*	@return	uint32 - the clamped timestamp in milliseconds
+	*/
+	static uint32 ClampTimeStamp(uint32 TimeStampMs, float ServerTime, float MaxClockError);
+
+	/**
+	*	Check a snapshot's attitude and draft are possible for a floating hull
+	*	@param	Snapshot - The snapshot to check
+	*	@param	HullBounds - The hull's bounds in its local space, scaled
+	*	@param	WaterHeights - The lowest and highest water height under the hull, empty if there's no ocean and the draft can't be checked
+	*	@param	Settings - The validation limits
+	*	@return	EMovementValidationFailure - None if the ship could float like this
+	*/
+	static EMovementValidationFailure CheckHydrostatics(const FMovementSnapshot& Snapshot, const FBox& HullBounds, const FFloatInterval& WaterHeights, const FMovementValidationSettings& Settings);
+};
+
+/*
+* A buffer containing a series of snapshots of an actor. This is used to interpolate movement, position, rotation and velocity between buffer indexes.
+* Snapshots are kept in a fixed capacity ring ordered by timestamp, index 0 is always the oldest snapshot.
+* The ring is allocated once, inserting and evicting snapshots never allocates.
+*/
 USTRUCT(BlueprintType)
 struct FMovementSnapShotBuffer
 {
 	GENERATED_BODY()
 
 	UPROPERTY(BlueprintReadOnly)
-		TArray<FMovementSnapshot> Buffer;
-
-	UPROPERTY(BlueprintReadOnly)
-		float BufferDelay = 500.0f; //Delay in milliseconds 
+		float BufferDelay = 100.0f; //Delay in milliseconds 
 
 	UPROPERTY(EditDefaultsOnly)
 		float BufferInterval = 50.0f; //The interval between snapshots in milliseconds 
 
+	UPROPERTY(EditDefaultsOnly)
+		int32 Capacity = 32; //The most snapshots the buffer holds, the oldest are evicted first
+
+	UPROPERTY(EditDefaultsOnly)
+		float MaxExtrapolationTime = 0.0f; //Seconds past the newest snapshot the buffer dead reckons to, covers snapshots the sender suppressed
+
+	UPROPERTY(EditDefaultsOnly)
+		FJitterBufferSettings JitterSettings; //How BufferDelay adapts to the arriving snapshots
+
+	UPROPERTY(BlueprintReadOnly)
+		FJitterBufferStats JitterStats; //The measurements behind the current BufferDelay
+
 	FMovementSnapShotBuffer() {};
 
-	//TODO: CLEANUP
+	/* Evict every snapshot older than the one at or before the buffered time, it's still needed to interpolate from */
 	void Update(float Time)
 	{	
+		UpdateBufferDelay(Time);
+
 		const float BufferedTime = GetBufferedTime(Time);
-		const float Min = FMath::RoundToZero(BufferedTime / GetBufferInterval()) * GetBufferInterval(); //Always keep the previous timestamp!
+		while (Count > 1 && (*this)[1].TimeStamp <= BufferedTime)
+		{
+			Head = (Head + 1) % Buffer.Num();
+			Count--;
+		}
+	}
+	
+	/* Insert a snapshot in timestamp order, packets arriving out of order are placed where they belong. Returns false if it was dropped */
+	bool AddToBuffer(const FMovementSnapshot& SnapShot)
+	{
+		if (Buffer.Num() != FMath::Max(Capacity, 2))
+		{
+			Buffer.SetNum(FMath::Max(Capacity, 2));
+			Head = 0;
+			Count = 0;
+		}
+
+		const int32 InsertIndex = UpperBound(SnapShot.TimeStamp);
+
+		//Duplicates add nothing, and a full buffer has no use for a snapshot older than all of it
+		if ((InsertIndex > 0 && (*this)[InsertIndex - 1].TimeStamp == SnapShot.TimeStamp) || (Count == Buffer.Num() && InsertIndex == 0))
+			return false;
 
-		TArray<int32>IndicesToKeep;
-		TArray<FMovementSnapshot> NewBuffer;
-		for (int i = 0; i < Buffer.Num(); i++)
+		int32 RingInsertIndex = InsertIndex;
+		if (Count == Buffer.Num())
 		{
-			if (Buffer[i].TimeStamp >= Min)
-				IndicesToKeep.Add(i);
+			Head = (Head + 1) % Buffer.Num();
+			Count--;
+			RingInsertIndex--;
 		}
-		for (int i = 0; i < IndicesToKeep.Num(); i++)
+
+		//Shift the newer snapshots up by one, in order arrivals skip this entirely
+		for (int32 Index = Count; Index > RingInsertIndex; Index--)
 		{
-			NewBuffer.Add(Buffer[IndicesToKeep[i]]);
+			Buffer[GetRingIndex(Index)] = Buffer[GetRingIndex(Index - 1)];
 		}
 
-		Buffer = NewBuffer;		
-		Buffer.Sort(TimeStampPredicate);	
-		//Buffer.Sort();
+		Buffer[GetRingIndex(RingInsertIndex)] = SnapShot;
+		Count++;
+		return true;
 	}
-	
-	void AddToBuffer(const FMovementSnapshot& SnapShot)
+
+	/**
+	*	Insert a snapshot received from the network, measuring its transit time for the adaptive delay
+	*	@param	SnapShot - The received snapshot
+	*	@param	ArrivalTime - The current time, in the same clock passed to Update()
+	*	@param	Sequence - The sequence number of the packet it arrived in, used to count losses
+	*/
+	void ReceiveSnapshot(const FMovementSnapshot& SnapShot, float ArrivalTime, uint16 Sequence)
 	{
-		Buffer.Add(SnapShot);
+		//Duplicates say nothing about the connection
+		if (AddToBuffer(SnapShot) && JitterSettings.bAdaptiveDelay)
+			JitterEstimator.AddArrival(SnapShot.TimeStamp, ArrivalTime, Sequence, JitterSettings);
 	}
 
+	/**
+	*	Move BufferDelay toward the adaptive target, never changing faster than the settings' time scale allows so the playout doesn't jump
+	*	@param	Time - The current time
+	*/
+	void UpdateBufferDelay(float Time);
+
 	void RemoveFromBuffer(int32 Index)
 	{
-		if (Buffer.IsValidIndex(Index))
-			Buffer.RemoveAt(Index);
+		if (!IsValidIndex(Index))
+			return;
+
+		for (int32 ShiftIndex = Index; ShiftIndex < Count - 1; ShiftIndex++)
+		{
+			Buffer[GetRingIndex(ShiftIndex)] = Buffer[GetRingIndex(ShiftIndex + 1)];
+		}
+		Count--;
+	}
+
+	/* Empty the buffer, keeping its memory */
+	void Reset()
+	{
+		Head = 0;
+		Count = 0;
+		JitterEstimator.Reset();
+		LastDelayUpdateTime = -1.0f;
+	}
+
+	/**
+	*	Find the two snapshots surrounding the buffered time
+	*	@param	Time - The current time, the buffer delay is subtracted from it
+	*	@param	OutCurrentIndex - The newest snapshot at or before the buffered time
+	*	@param	OutTargetIndex - The oldest snapshot after the buffered time
+	*	@return	bool - false if the buffered time isn't surrounded by snapshots
+	*/
+	bool GetBracketingIndices(float Time, int32& OutCurrentIndex, int32& OutTargetIndex) const
+	{
+		if (!HasElapsedMinTime(Time))
+			return false;
+
+		OutTargetIndex = UpperBound(GetBufferedTime(Time));
+		OutCurrentIndex = OutTargetIndex - 1;
+		return OutCurrentIndex >= 0 && OutTargetIndex < Count;
 	}
 
 	bool GetTargetSnapshotIndex(float Time, int32& Index) const
 	{
 		if (HasElapsedMinTime(Time))
 		{
-			const float BufferedTime = GetBufferedTime(Time);
-			for (int32 i = 0; i < Buffer.Num(); i++)
+			const int32 TargetIndex = UpperBound(GetBufferedTime(Time));
+			if (TargetIndex < Count)
 			{
-				const FMovementSnapshot& Snapshot = Buffer[i];
-				if (Snapshot.TimeStamp > BufferedTime)
-				{
-					Index = i;
-					return true;
-				}
+				Index = TargetIndex;
+				return true;
 			}
 		}
 
@@ -160,20 +780,80 @@ struct FMovementSnapShotBuffer
 	{
 		if (HasElapsedMinTime(Time))
 		{
-			const float BufferedTime = GetBufferedTime(Time);
-			for (int i = 0; i < Buffer.Num(); i++)
+			const int32 CurrentIndex = LowerBound(GetBufferedTime(Time)) - 1;
+			if (CurrentIndex >= 0)
 			{
-				const FMovementSnapshot& Snapshot = Buffer[i];
-				if (Snapshot.TimeStamp < BufferedTime)
-				{
-					Index = i;
-					return true;
-				}
+				Index = CurrentIndex;
+				return true;
 			}
 		}
 
 		return false;
 	}
+
+	/**
+	*	The fraction of the time between two snapshots the buffered time has passed, shared by every interpolation of the buffer
+	*	@param	A - The snapshot at or before the buffered time
+	*	@param	B - The snapshot after the buffered time
+	*	@param	Time - The current time, the buffer delay is subtracted from it
+	*	@return	float - the alpha in [0, 1]
+	*/
+	float GetInterpolationAlpha(const FMovementSnapshot& A, const FMovementSnapshot& B, float Time) const
+	{
+		const float Interval = B.TimeStamp - A.TimeStamp;
+		return Interval > KINDA_SMALL_NUMBER ? FMath::Clamp((GetBufferedTime(Time) - A.TimeStamp) / Interval, 0.0f, 1.0f) : 1.0f;
+	}
+
+	/**
+	*	Sample the buffer at the buffered time, dead reckoning from the newest snapshot for up to MaxExtrapolationTime past it
+	*	@param	Time - The current time, the buffer delay is subtracted from it
+	*	@param	OutSnapshot - The interpolated snapshot
+	*	@return	bool - false if the buffered time isn't surrounded by snapshots or within reach of the newest
+	*/
+	bool Sample(float Time, FMovementSnapshot& OutSnapshot) const
+	{
+		int32 FromIndex, ToIndex;
+		float Alpha;
+		if (!GetSampleIndices(Time, FromIndex, ToIndex, Alpha))
+			return false;
+
+		OutSnapshot = ToIndex == INDEX_NONE ? FMovementSnapshot::Extrapolate((*this)[FromIndex], GetBufferedTime(Time)) : FMovementSnapshot::Interpolate((*this)[FromIndex], (*this)[ToIndex], Alpha);
+		return true;
+	}
+
+	/**
+	*	Find what Sample() would blend without blending it
+	*	@param	Time - The current time, the buffer delay is subtracted from it
+	*	@param	OutFromIndex - The snapshot at or before the buffered time
+	*	@param	OutToIndex - The snapshot after the buffered time, INDEX_NONE when dead reckoning past the newest snapshot
+	*	@param	OutAlpha - The interpolation alpha, or the seconds to dead reckon when OutToIndex is INDEX_NONE
+	*	@return	bool - false if there's nothing to sample
+	*/
+	bool GetSampleIndices(float Time, int32& OutFromIndex, int32& OutToIndex, float& OutAlpha) const
+	{
+		if (GetBracketingIndices(Time, OutFromIndex, OutToIndex))
+		{
+			OutAlpha = GetInterpolationAlpha((*this)[OutFromIndex], (*this)[OutToIndex], Time);
+			return true;
+		}
+
+		//Past the newest snapshot the sender either suppressed the next one because it's predictable, or it's late
+		const float BufferedTime = GetBufferedTime(Time);
+		if (Count == 0 || !HasElapsedMinTime(Time) || BufferedTime < (*this)[Count - 1].TimeStamp || BufferedTime - (*this)[Count - 1].TimeStamp > MaxExtrapolationTime)
+			return false;
+
+		OutFromIndex = Count - 1;
+		OutToIndex = INDEX_NONE;
+		OutAlpha = BufferedTime - (*this)[Count - 1].TimeStamp;
+		return true;
+	}
+
+	/* Timestamp ordered access, 0 is the oldest snapshot */
+	const FMovementSnapshot& operator[](int32 Index) const { return Buffer[GetRingIndex(Index)]; }
+	FMovementSnapshot& operator[](int32 Index) { return Buffer[GetRingIndex(Index)]; }
+
+	int32 Num() const { return Count; }
+	bool IsValidIndex(int32 Index) const { return Index >= 0 && Index < Count; }
 	
 	float GetBufferedTime(float Time) const { return Time - (BufferDelay / 1000.0f); } 
 	float GetBufferInterval() const { return BufferInterval / 1000.0f; }
@@ -183,6 +863,48 @@ struct FMovementSnapShotBuffer
 	{
 		return (A.TimeStamp < B.TimeStamp);
 	}
+
+private:
+	int32 GetRingIndex(int32 Index) const { return (Head + Index) % Buffer.Num(); }
+
+	/* The first index with a timestamp greater than Time */
+	int32 UpperBound(float Time) const
+	{
+		int32 Low = 0, High = Count;
+		while (Low < High)
+		{
+			const int32 Middle = (Low + High) / 2;
+			if ((*this)[Middle].TimeStamp <= Time)
+				Low = Middle + 1;
+			else
+				High = Middle;
+		}
+		return Low;
+	}
+
+	/* The first index with a timestamp greater than or equal to Time */
+	int32 LowerBound(float Time) const
+	{
+		int32 Low = 0, High = Count;
+		while (Low < High)
+		{
+			const int32 Middle = (Low + High) / 2;
+			if ((*this)[Middle].TimeStamp < Time)
+				Low = Middle + 1;
+			else
+				High = Middle;
+		}
+		return Low;
+	}
+
+	UPROPERTY()
+		TArray<FMovementSnapshot> Buffer; //Ring storage, unordered past Head - use operator[] for timestamp ordered access
+
+	int32 Head = 0; //Ring index of the oldest snapshot
+	int32 Count = 0; //Number of valid snapshots
+
+	FSnapshotJitterEstimator JitterEstimator;
+	float LastDelayUpdateTime = -1.0f;
 /*
 * Current Body Info -
 * Previous Snapshot - 
@@ -190,6 +912,38 @@ struct FMovementSnapShotBuffer
 */
 };
 
+/*
+* The server's record of where a ship was, used to rewind it to the time a client saw it.
+* Poses are kept in a snapshot buffer played out without a delay, so it shares the buffer's bounded ring and binary searched lookups.
+*/
+struct FShipPoseHistory
+{
+	FShipPoseHistory() {};
+
+	/**
+	*	Empty the history and size it for a duration of poses
+	*	@param	Duration - Seconds of poses to keep
+	*	@param	RecordRate - Poses recorded per second
+	*/
+	void Reset(float Duration, float RecordRate);
+
+	/* Record a pose, the oldest is evicted once the history is full */
+	void Record(const FMovementSnapshot& Pose) { Poses.AddToBuffer(Pose); }
+
+	/**
+	*	Find the pose at a point in time, interpolated between the recorded poses around it
+	*	@param	Time - The time to rewind to
+	*	@param	OutPose - The pose at that time, dead reckoned from the newest one past it
+	*	@return	bool - false if the time is older than the history or there's nothing recorded
+	*/
+	bool Sample(float Time, FMovementSnapshot& OutPose) const { return Poses.Sample(Time, OutPose); }
+
+	int32 Num() const { return Poses.Num(); }
+
+private:
+	FMovementSnapShotBuffer Poses;
+};
+
 //Local Authoritative data buffer for a pawn
 USTRUCT(BlueprintType)
 struct  FPhysicsMovementReplication_ClientAuth
@@ -199,26 +953,47 @@ struct  FPhysicsMovementReplication_ClientAuth
 	UPROPERTY(NotReplicated)
 		float TimeSinceLastPacketSent = 0.0f;
 
+	UPROPERTY(NotReplicated)
+		float TimeSinceLastSnapshotSent = 0.0f; //Time since a snapshot was actually sent rather than suppressed
+
+	FMovementSnapshot LastSentSnapshot; //The last snapshot sent as the receivers decode it, what they dead reckon from
+	bool bHasSentSnapshot = false;
+
 	UPROPERTY(NotReplicated)
 		FMovementSnapShotBuffer SnapshotBuffer;
+
+	FSnapshotDeltaEncoder Encoder; //Encodes the snapshots sent to the server against the ones it acknowledged
 		
 	FPhysicsMovementReplication_ClientAuth() {};
 
+	/**
+	*	Returns true if the receivers' dead reckoning from the last sent snapshot is too far from the new one, or a heartbeat is due
+	*	@param	SnapShot - The snapshot that would be sent, as the receivers would decode it
+	*	@param	DeadReckoning - The send suppression settings
+	*/
+	bool ShouldSendSnapshot(const FMovementSnapshot& SnapShot, const FDeadReckoningSettings& DeadReckoning) const
+	{
+		if (!DeadReckoning.bEnableSendSuppression || !bHasSentSnapshot || TimeSinceLastSnapshotSent >= DeadReckoning.HeartbeatInterval)
+			return true;
+
+		const FMovementSnapshot Predicted = FMovementSnapshot::Extrapolate(LastSentSnapshot, SnapShot.TimeStamp);
+		return FVector::DistSquared(Predicted.Location, SnapShot.Location) > FMath::Square(DeadReckoning.PositionThreshold)
+			|| FMath::RadiansToDegrees(Predicted.Rotation.AngularDistance(SnapShot.Rotation)) > DeadReckoning.RotationThreshold;
+	}
+
 };
 
-//TODO: Factor in TimeOffset
 //Local Non-Authoritative data buffer for a pawn
 USTRUCT(BlueprintType)
 struct FPhysicsMovementReplication_Client
 {
 	GENERATED_BODY()
 
-	UPROPERTY(NotReplicated)
-		float TimeOffset = 0.0f;
-
 	UPROPERTY(NotReplicated)
 		FMovementSnapShotBuffer SnapshotBuffer;
 
+	FSnapshotBaselineHistory ReceivedSnapshots; //Baselines for decoding the server's multicasts
+
 	FPhysicsMovementReplication_Client() {};
 };
 
@@ -234,6 +1009,23 @@ struct FPhysicsMovementReplication_Server
 	UPROPERTY(NotReplicated)
 		FMovementSnapShotBuffer SnapshotBuffer;
 
+	FSnapshotBaselineHistory ReceivedSnapshots; //Baselines for decoding the owning client's snapshots
+
+	FSnapshotDeltaEncoder MultiCastEncoder; //Encodes the snapshots multicast to the simulated proxies
+
+	FMovementSnapshot LastValidSnapshot; //The newest snapshot that passed validation, what rejected ones are checked against and corrected to
+	bool bHasValidSnapshot = false;
+
+	float TimeSinceLastCorrection = 0.0f;
+
+	FShipPoseHistory PoseHistory; //Where the ship was, recorded from the client's snapshots or the server's own simulation
+
+	float ClientViewDelay = 0.0f; //Seconds the owning client plays the other ships behind its own, as it last reported
+
+	float TimeSinceLastPoseRecorded = 0.0f;
+
+	float LastCollisionTime = -1.0f; //When the ship's last collision was resolved, in the pose history's time
+
 	FPhysicsMovementReplication_Server() {};
 };
 
@@ -246,6 +1038,25 @@ struct FPhysicsMovementReplication
 	UPROPERTY(EditAnywhere)
 		FPhysicsReplicationSettings Settings;
 
+	/* Apply the settings' buffer size and send rate to every snapshot buffer */
+	void ApplySettingsToBuffers()
+	{
+		FMovementSnapShotBuffer* Buffers[] = { &LocalMovementReplication.SnapshotBuffer, &ServerMovementReplication.SnapshotBuffer, &AuthMovementReplication.SnapshotBuffer };
+		for (FMovementSnapShotBuffer* Buffer : Buffers)
+		{
+			Buffer->BufferDelay = Settings.BufferSize;
+			Buffer->BufferInterval = 1000.0f / FMath::Max<uint32>(Settings.SendRate, 1);
+			Buffer->JitterSettings = Settings.JitterBuffer;
+
+			//Receivers may have to bridge a whole heartbeat, plus a send interval as the heartbeat is checked on sends
+			Buffer->MaxExtrapolationTime = Settings.DeadReckoning.bEnableSendSuppression ? Settings.DeadReckoning.HeartbeatInterval + 1.0f / FMath::Max<uint32>(Settings.SendRate, 1) : 0.0f;
+		}
+
+		//Client owned ships record every snapshot they send instead of the record rate
+		const float PoseRate = FMath::Max(Settings.CollisionRewind.RecordRate, float(Settings.SendRate));
+		ServerMovementReplication.PoseHistory.Reset(Settings.CollisionRewind.HistoryDuration, PoseRate);
+	}
+
 	UPROPERTY(BlueprintReadOnly)
 		FPhysicsMovementReplication_Client LocalMovementReplication; //The local snapshot buffer for Simulated (Non-Authoritative) clients
 
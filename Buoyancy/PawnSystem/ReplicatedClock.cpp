@@ -0,0 +1,116 @@
+/*=================================================
+* FileName: ReplicatedClock.cpp
+*
+* Created by: Sails of War contributors
+* Project name: Sails of War
+* Unreal Engine version: 4.22
+* Created on: 2026/10/18
+*
+* Last Edited on: 2026/10/18
+* Last Edited by: Sails of War contributors
+*
+* -------------------------------------------------
+* Created for: Sails Of War - http://sailsofwargame.com/
+* -------------------------------------------------
+* For parts referencing UE4 code, the following copyright applies:
+* Copyright 1998-2020 Epic Games, Inc. All Rights Reserved.
+*
+* Feel free to use this software in any commercial/free game.
+* Selling this as a plugin/item, in whole or part, is not allowed.
+* =================================================*/
+//Libary Includes:
+#include "ReplicatedClock.h"
+
+void FReplicatedClock::AddSample(float LocalSendTime, float ServerTime, float LocalReceiveTime, const FClockSyncSettings& Settings)
+{
+	const float RoundTrip = LocalReceiveTime - LocalSendTime;
+	if (RoundTrip < 0.0f)
+		return;
+
+	const float LocalMidTime = LocalSendTime + RoundTrip * 0.5f;
+	const FClockSample Sample = FClockSample(LocalMidTime, ServerTime - LocalMidTime, RoundTrip);
+
+	const int32 WindowSize = FMath::Max(Settings.SampleWindow, 4);
+	if (Samples.Num() > WindowSize)
+	{
+		Samples.Reset();
+		NextSample = 0;
+	}
+
+	//Fill the window, then overwrite the oldest sample
+	if (Samples.Num() < WindowSize)
+		Samples.Add(Sample);
+	else
+	{
+		Samples[NextSample] = Sample;
+		NextSample = (NextSample + 1) % WindowSize;
+	}
+
+	UpdateEstimate();
+}
+
+void FReplicatedClock::UpdateEstimate()
+{
+	//The fastest ping had the least queuing, so its offset is the most trustworthy
+	const FClockSample* Fastest = &Samples[0];
+	for (const FClockSample& Sample : Samples)
+	{
+		if (Sample.RoundTripTime < Fastest->RoundTripTime)
+			Fastest = &Sample;
+	}
+
+	RoundTripTime = Fastest->RoundTripTime;
+
+	//Fit the skew through the pings within a few milliseconds of the fastest, slower ones are skewed by their queuing
+	const float MaxRoundTrip = RoundTripTime * 1.5f + 0.005f;
+	float SumTime = 0.0f, SumOffset = 0.0f, SumTimeTime = 0.0f, SumTimeOffset = 0.0f;
+	int32 NumUsed = 0;
+	for (const FClockSample& Sample : Samples)
+	{
+		if (Sample.RoundTripTime > MaxRoundTrip)
+			continue;
+
+		//Relative to the fastest ping, large absolute times would cost the sums their precision
+		const float Time = Sample.LocalTime - Fastest->LocalTime;
+		const float SampleOffset = Sample.Offset - Fastest->Offset;
+		SumTime += Time;
+		SumOffset += SampleOffset;
+		SumTimeTime += Time * Time;
+		SumTimeOffset += Time * SampleOffset;
+		NumUsed++;
+	}
+
+	const float Denominator = NumUsed * SumTimeTime - SumTime * SumTime;
+	Skew = NumUsed >= 3 && Denominator > KINDA_SMALL_NUMBER ? (NumUsed * SumTimeOffset - SumTime * SumOffset) / Denominator : 0.0f;
+
+	//Crystal oscillators drift by parts per million, anything larger is noise
+	Skew = FMath::Clamp(Skew, -0.001f, 0.001f);
+	Offset = Fastest->Offset;
+	ReferenceTime = Fastest->LocalTime;
+}
+
+float FReplicatedClock::GetTime(float LocalTime, const FClockSyncSettings& Settings)
+{
+	const float Estimate = GetEstimatedTime(LocalTime);
+	if (!bHasTime)
+	{
+		bHasTime = true;
+		LastLocalTime = LocalTime;
+		LastTime = Estimate;
+		return LastTime;
+	}
+
+	const float Elapsed = FMath::Max(LocalTime - LastLocalTime, 0.0f);
+	LastLocalTime = LocalTime;
+
+	//Run up to MaxSlewRate faster or slower than the local clock until the estimate is reached, which keeps the time monotonic.
+	//Far off, slewing would take SnapThreshold / MaxSlewRate seconds - a clock that ran ahead jumps back too, rather than staying ahead that long
+	const float Free = LastTime + Elapsed;
+	const float Error = Estimate - Free;
+	if (FMath::Abs(Error) > Settings.SnapThreshold)
+		LastTime = Estimate;
+	else
+		LastTime = Free + FMath::Clamp(Error, -Elapsed * Settings.MaxSlewRate, Elapsed * Settings.MaxSlewRate);
+
+	return LastTime;
+}
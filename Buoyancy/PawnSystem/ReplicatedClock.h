@@ -0,0 +1,128 @@
+/*=================================================
+* FileName: ReplicatedClock.h
+*
+* Created by: Sails of War contributors
+* Project name: Sails of War
+* Unreal Engine version: 4.22
+* Created on: 2026/10/18
+*
+* Last Edited on: 2026/10/18
+* Last Edited by: Sails of War contributors
+*
+* -------------------------------------------------
+* Created for: Sails Of War - http://sailsofwargame.com/
+* -------------------------------------------------
+* For parts referencing UE4 code, the following copyright applies:
+* Copyright 1998-2020 Epic Games, Inc. All Rights Reserved.
+*
+* Feel free to use this software in any commercial/free game.
+* Selling this as a plugin/item, in whole or part, is not allowed.
+* =================================================*/
+#pragma once
+
+//Engine Includes:
+#include "CoreMinimal.h"
+
+#include "ReplicatedClock.generated.h"
+
+//Settings for synchronizing a client's clock with the server's
+USTRUCT(BlueprintType)
+struct FClockSyncSettings
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere)
+		bool bEnableClockSync = true; //Disable to stamp snapshots with the game state's replicated server time
+
+	UPROPERTY(EditAnywhere, meta = (EditCondition = "bEnableClockSync", ClampMin = "0.05"))
+		float PingInterval = 1.0f; //Seconds between pings once the clock is synchronized
+
+	UPROPERTY(EditAnywhere, meta = (EditCondition = "bEnableClockSync", ClampMin = "0.05"))
+		float FastPingInterval = 0.1f; //Seconds between pings until the sample window is full
+
+	UPROPERTY(EditAnywhere, meta = (EditCondition = "bEnableClockSync", ClampMin = "4", ClampMax = "64"))
+		int32 SampleWindow = 16; //The most recent pings the offset and skew are estimated from
+
+	UPROPERTY(EditAnywhere, meta = (EditCondition = "bEnableClockSync", ClampMin = "0.0", ClampMax = "0.5"))
+		float MaxSlewRate = 0.05f; //The most the synchronized clock may run faster or slower than the local one while it converges, 0.05 is 5%
+
+	UPROPERTY(EditAnywhere, meta = (EditCondition = "bEnableClockSync"))
+		float SnapThreshold = 0.5f; //Seconds the clock may be off its estimate either way before it jumps to it instead of slewing
+
+	FClockSyncSettings() {};
+};
+
+//A single ping's measurement
+struct FClockSample
+{
+	float LocalTime = 0.0f; //The local time halfway through the ping
+	float Offset = 0.0f; //The server time minus the local time
+	float RoundTripTime = 0.0f;
+
+	FClockSample() {};
+	FClockSample(float InLocalTime, float InOffset, float InRoundTripTime) :
+		LocalTime(InLocalTime), Offset(InOffset), RoundTripTime(InRoundTripTime) {}
+};
+
+/*
+* An NTP-style estimate of the server's clock on a client.
+* Each ping measures the round trip time and the offset between the clocks, assuming the trip was symmetric.
+* Queuing delays only ever add to a trip, so the offset is anchored to the fastest ping in the window, and the skew between the clocks
+* is fit by least squares through the pings that were nearly as fast.
+* The time handed out slews toward the estimate at a bounded rate, so small corrections never run it backwards - it only jumps when it's further off than SnapThreshold.
+*/
+struct FReplicatedClock
+{
+	FReplicatedClock() {};
+
+	/**
+	*	Add a ping's measurement
+	*	@param	LocalSendTime - The local time the ping was sent
+	*	@param	ServerTime - The server's time when it answered
+	*	@param	LocalReceiveTime - The local time the answer arrived
+	*	@param	Settings - The clock sync settings
+	*/
+	void AddSample(float LocalSendTime, float ServerTime, float LocalReceiveTime, const FClockSyncSettings& Settings);
+
+	/**
+	*	Get the synchronized time, the estimated server time slewed so it's smooth - it only jumps, either way, when it's further off than SnapThreshold
+	*	@param	LocalTime - The current local time
+	*	@param	Settings - The clock sync settings
+	*	@return	float - the synchronized time in seconds
+	*/
+	float GetTime(float LocalTime, const FClockSyncSettings& Settings);
+
+	/**
+	*	Get the estimated server time without smoothing
+	*	@param	LocalTime - The local time to estimate the server time at
+	*	@return	float - the estimated server time in seconds
+	*/
+	float GetEstimatedTime(float LocalTime) const { return LocalTime + Offset + Skew * (LocalTime - ReferenceTime); }
+
+	bool HasSamples() const { return Samples.Num() > 0; }
+
+	/* Returns true once the sample window is full */
+	bool IsConverged(const FClockSyncSettings& Settings) const { return Samples.Num() >= FMath::Max(Settings.SampleWindow, 4); }
+
+	float GetRoundTripTime() const { return RoundTripTime; }
+	float GetOffset() const { return Offset; }
+	float GetSkew() const { return Skew; } //Seconds the server's clock gains per local second
+
+private:
+	/**
+	*	Estimate the offset and skew from the samples
+	*/
+	void UpdateEstimate();
+
+	TArray<FClockSample> Samples; //Ring of the most recent samples
+	int32 NextSample = 0;
+
+	float Offset = 0.0f; //The offset at ReferenceTime
+	float Skew = 0.0f;
+	float ReferenceTime = 0.0f; //The local time the skew is measured from
+	float RoundTripTime = 0.0f; //The fastest round trip in the window
+
+	float LastLocalTime = 0.0f; //The local time GetTime() last ran at
+	float LastTime = 0.0f; //The time GetTime() last returned
+	bool bHasTime = false;
+};
@@ -0,0 +1,473 @@
+/*=================================================
+* FileName: ShipReplay.cpp
+*
+* Created by: Sails of War contributors
+* Project name: Sails of War
+* Unreal Engine version: 4.22
+* Created on: 2026/10/18
+*
+* Last Edited on: 2026/10/18
+* Last Edited by: Sails of War contributors
+*
+* -------------------------------------------------
+* Created for: Sails Of War - http://sailsofwargame.com/
+* -------------------------------------------------
+* For parts referencing UE4 code, the following copyright applies:
+* Copyright 1998-2020 Epic Games, Inc. All Rights Reserved.
+*
+* Feel free to use this software in any commercial/free game.
+* Selling this as a plugin/item, in whole or part, is not allowed.
+* =================================================*/
+//Libary Includes:
+#include "ShipReplay.h"
+
+//Engine Includes:
+#include "HAL/PlatformFilemanager.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+#include "Misc/Paths.h"
+#include "Serialization/BitReader.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Async/TaskGraphInterfaces.h"
+
+DECLARE_CYCLE_STAT(TEXT("RecordShipSnapshot"), STAT_RecordShipSnapshot, STATGROUP_PhysicsReplication);
+DECLARE_CYCLE_STAT(TEXT("ReadShipReplayChunk"), STAT_ReadShipReplayChunk, STATGROUP_PhysicsReplication);
+DECLARE_CYCLE_STAT(TEXT("WriteShipReplayChunk"), STAT_WriteShipReplayChunk, STATGROUP_PhysicsReplication);
+
+namespace ShipReplayFormat
+{
+	static const uint32 FileMagic = 0x52574F53; //SOWR
+	static const uint32 ChunkMagic = 0x4B4E4843; //CHNK
+	static const uint32 IndexMagic = 0x58444E49; //INDX
+	static const uint32 Version = 1;
+
+	static const int64 FileHeaderSize = 8; //Magic and version
+	static const int64 ChunkHeaderSize = 20; //Magic, start and end time, record count and size in bits
+	static const int64 FooterSize = 12; //The index offset and the index magic
+
+	/**
+	*	Serialize a record's body, the ship id is serialized by the caller
+	*	@param	Ar - The chunk's bit archive
+	*	@param	bKeyframe - True for a ship's first record in the chunk
+	*	@param	ShipName - The ship's name, only serialized with keyframes
+	*	@param	State - The snapshot for keyframes, otherwise the delta to the ship's previous record
+	*/
+	static void SerializeRecord(FArchive& Ar, bool& bKeyframe, FString& ShipName, FQuantizedMovementSnapshot& State)
+	{
+		uint8 KeyframeBit = bKeyframe ? 1 : 0;
+		Ar.SerializeBits(&KeyframeBit, 1);
+		bKeyframe = KeyframeBit != 0;
+
+		if (bKeyframe)
+			Ar << ShipName;
+
+		State.Serialize(Ar, !bKeyframe);
+	}
+}
+
+bool FShipReplayWriter::Open(const FString& Path, const FShipReplaySettings& InSettings)
+{
+	Close();
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	PlatformFile.CreateDirectoryTree(*FPaths::GetPath(Path));
+	File = PlatformFile.OpenWrite(*Path);
+	if (File == nullptr)
+		return false;
+
+	Settings = InSettings;
+	Ships.Reset();
+	Chunks.Reset();
+	NumChunkRecords = 0;
+	ChunkWriter = MakeUnique<FBitWriter>(0, true);
+
+	TArray<uint8> Header;
+	FMemoryWriter HeaderWriter(Header);
+	uint32 Magic = ShipReplayFormat::FileMagic, Version = ShipReplayFormat::Version;
+	HeaderWriter << Magic << Version;
+	BytesWritten = 0;
+	WriteAsync(MoveTemp(Header));
+	return true;
+}
+
+void FShipReplayWriter::Close()
+{
+	if (File == nullptr)
+		return;
+
+	FlushChunk();
+
+	//The index goes last so the recording stays append-only, the footer says where it starts
+	TArray<uint8> Index;
+	FMemoryWriter IndexWriter(Index);
+	uint32 Magic = ShipReplayFormat::IndexMagic;
+	int32 NumChunks = Chunks.Num();
+	IndexWriter << Magic << NumChunks;
+	for (FShipReplayChunkInfo& Chunk : Chunks)
+	{
+		IndexWriter << Chunk.StartTimeMs << Chunk.EndTimeMs << Chunk.Offset;
+	}
+
+	int64 IndexOffset = BytesWritten;
+	IndexWriter << IndexOffset << Magic;
+	WriteAsync(MoveTemp(Index));
+
+	//The file handle has to outlive every queued write
+	if (PendingWrite.IsValid())
+		FTaskGraphInterface::Get().WaitUntilTaskCompletes(PendingWrite);
+
+	PendingWrite = nullptr;
+	delete File;
+	File = nullptr;
+	ChunkWriter.Reset();
+}
+
+void FShipReplayWriter::Record(uint32 ShipId, const FString& ShipName, const FQuantizedMovementSnapshot& Snapshot)
+{
+	if (File == nullptr)
+		return;
+
+	SCOPE_CYCLE_COUNTER(STAT_RecordShipSnapshot);
+
+	//Late snapshots filled a gap for the playout, the recording already moved past them - deltas only run forward in time
+	FShipState& Ship = Ships.FindOrAdd(ShipId);
+	if (Ship.bHasSnapshot && Snapshot.TimeStampMs <= Ship.LastSnapshot.TimeStampMs)
+		return;
+
+	const bool bChunkFull = ChunkWriter->GetNumBytes() >= Settings.MaxChunkBytes;
+	const bool bChunkExpired = int64(Snapshot.TimeStampMs) - int64(OpenChunk.StartTimeMs) >= int64(Settings.ChunkDuration * 1000.0f);
+	if (NumChunkRecords > 0 && (bChunkFull || bChunkExpired))
+		FlushChunk();
+
+	if (NumChunkRecords == 0)
+	{
+		OpenChunk.StartTimeMs = Snapshot.TimeStampMs;
+		OpenChunk.EndTimeMs = Snapshot.TimeStampMs;
+	}
+
+	//Deltas need the same precision on both ends, see FQuantizedMovementSnapshot::ApplyDelta()
+	bool bKeyframe = !Ship.bInChunk || Ship.LastSnapshot.Precision != Snapshot.Precision;
+	FString Name = ShipName;
+	FQuantizedMovementSnapshot State = bKeyframe ? Snapshot : Snapshot.GetDelta(Ship.LastSnapshot);
+
+	ChunkWriter->SerializeIntPacked(ShipId);
+	ShipReplayFormat::SerializeRecord(*ChunkWriter, bKeyframe, Name, State);
+
+	Ship.LastSnapshot = Snapshot;
+	Ship.bHasSnapshot = true;
+	Ship.bInChunk = true;
+
+	OpenChunk.StartTimeMs = FMath::Min(OpenChunk.StartTimeMs, Snapshot.TimeStampMs);
+	OpenChunk.EndTimeMs = FMath::Max(OpenChunk.EndTimeMs, Snapshot.TimeStampMs);
+	NumChunkRecords++;
+}
+
+void FShipReplayWriter::FlushChunk()
+{
+	if (File == nullptr || NumChunkRecords == 0)
+		return;
+
+	//Ships are stamped by their own clocks, so only the ends are kept in order for seeking - see FShipReplayReader::FindChunk()
+	if (Chunks.Num() > 0)
+		OpenChunk.EndTimeMs = FMath::Max(OpenChunk.EndTimeMs, Chunks.Last().EndTimeMs);
+
+	OpenChunk.Offset = BytesWritten;
+	Chunks.Add(OpenChunk);
+
+	//The header and the records go out as one write, so a crash can only tear the last chunk
+	TArray<uint8> Chunk;
+	FMemoryWriter ChunkArchive(Chunk);
+	uint32 Magic = ShipReplayFormat::ChunkMagic;
+	uint32 NumBits = uint32(ChunkWriter->GetNumBits());
+	ChunkArchive << Magic << OpenChunk.StartTimeMs << OpenChunk.EndTimeMs << NumChunkRecords << NumBits;
+	Chunk.Append(ChunkWriter->GetData(), ChunkWriter->GetNumBytes());
+	WriteAsync(MoveTemp(Chunk));
+
+	//Every ship starts the next chunk with a keyframe
+	for (auto& Ship : Ships)
+	{
+		Ship.Value.bInChunk = false;
+	}
+
+	ChunkWriter = MakeUnique<FBitWriter>(0, true);
+	NumChunkRecords = 0;
+}
+
+void FShipReplayWriter::WriteAsync(TArray<uint8>&& Data)
+{
+	BytesWritten += Data.Num();
+
+	//Chained on the previous write so the chunks land in order, the game thread never waits on the disk
+	FGraphEventArray Prerequisites;
+	if (PendingWrite.IsValid())
+		Prerequisites.Add(PendingWrite);
+
+	IFileHandle* WriteFile = File;
+	TSharedRef<TArray<uint8>, ESPMode::ThreadSafe> Buffer = MakeShared<TArray<uint8>, ESPMode::ThreadSafe>(MoveTemp(Data));
+	PendingWrite = FFunctionGraphTask::CreateAndDispatchWhenReady([WriteFile, Buffer]()
+	{
+		SCOPE_CYCLE_COUNTER(STAT_WriteShipReplayChunk);
+		WriteFile->Write(Buffer->GetData(), Buffer->Num());
+		WriteFile->Flush();
+	}, TStatId(), &Prerequisites, ENamedThreads::AnyBackgroundThreadNormalTask);
+}
+
+bool FShipReplayReader::Open(const FString& Path)
+{
+	Close();
+
+	File = FPlatformFileManager::Get().GetPlatformFile().OpenRead(*Path);
+	if (File == nullptr)
+		return false;
+
+	FileSize = File->Size();
+	TArray<uint8> Header;
+	Header.SetNumUninitialized(ShipReplayFormat::FileHeaderSize);
+	if (FileSize < ShipReplayFormat::FileHeaderSize || !File->Read(Header.GetData(), Header.Num()))
+	{
+		Close();
+		return false;
+	}
+
+	FMemoryReader HeaderReader(Header);
+	uint32 Magic = 0, Version = 0;
+	HeaderReader << Magic << Version;
+	if (Magic != ShipReplayFormat::FileMagic || Version != ShipReplayFormat::Version)
+	{
+		Close();
+		return false;
+	}
+
+	if (!ReadIndex())
+		ScanChunks();
+
+	return true;
+}
+
+void FShipReplayReader::Close()
+{
+	delete File;
+	File = nullptr;
+	FileSize = 0;
+	Chunks.Reset();
+	ShipNames.Reset();
+}
+
+bool FShipReplayReader::ReadIndex()
+{
+	if (FileSize < ShipReplayFormat::FileHeaderSize + ShipReplayFormat::FooterSize)
+		return false;
+
+	TArray<uint8> Footer;
+	Footer.SetNumUninitialized(ShipReplayFormat::FooterSize);
+	if (!File->Seek(FileSize - ShipReplayFormat::FooterSize) || !File->Read(Footer.GetData(), Footer.Num()))
+		return false;
+
+	FMemoryReader FooterReader(Footer);
+	int64 IndexOffset = 0;
+	uint32 Magic = 0;
+	FooterReader << IndexOffset << Magic;
+	if (Magic != ShipReplayFormat::IndexMagic || IndexOffset < ShipReplayFormat::FileHeaderSize || IndexOffset > FileSize - ShipReplayFormat::FooterSize)
+		return false;
+
+	TArray<uint8> Index;
+	Index.SetNumUninitialized(FileSize - ShipReplayFormat::FooterSize - IndexOffset);
+	if (!File->Seek(IndexOffset) || !File->Read(Index.GetData(), Index.Num()))
+		return false;
+
+	FMemoryReader IndexReader(Index);
+	int32 NumChunks = 0;
+	IndexReader << Magic << NumChunks;
+	if (Magic != ShipReplayFormat::IndexMagic || NumChunks < 0 || NumChunks > Index.Num() / 16)
+		return false;
+
+	Chunks.SetNum(NumChunks);
+	for (FShipReplayChunkInfo& Chunk : Chunks)
+	{
+		IndexReader << Chunk.StartTimeMs << Chunk.EndTimeMs << Chunk.Offset;
+	}
+
+	return !IndexReader.IsError();
+}
+
+void FShipReplayReader::ScanChunks()
+{
+	//A recording that wasn't closed still has every chunk it flushed, a torn last chunk is ignored
+	Chunks.Reset();
+	int64 Offset = ShipReplayFormat::FileHeaderSize;
+	TArray<uint8> Header;
+	Header.SetNumUninitialized(ShipReplayFormat::ChunkHeaderSize);
+	while (Offset + ShipReplayFormat::ChunkHeaderSize <= FileSize && File->Seek(Offset) && File->Read(Header.GetData(), Header.Num()))
+	{
+		FMemoryReader HeaderReader(Header);
+		FShipReplayChunkInfo Chunk;
+		uint32 Magic = 0, NumRecords = 0, NumBits = 0;
+		HeaderReader << Magic << Chunk.StartTimeMs << Chunk.EndTimeMs << NumRecords << NumBits;
+
+		const int64 ChunkSize = ShipReplayFormat::ChunkHeaderSize + (NumBits + 7) / 8;
+		if (Magic != ShipReplayFormat::ChunkMagic || Offset + ChunkSize > FileSize)
+			break;
+
+		Chunk.Offset = Offset;
+		Chunks.Add(Chunk);
+		Offset += ChunkSize;
+	}
+}
+
+int32 FShipReplayReader::FindChunk(float Time) const
+{
+	const uint32 TimeMs = uint32(FMath::Max(double(Time) * 1000.0, 0.0));
+	int32 Low = 0, High = Chunks.Num();
+	while (Low < High)
+	{
+		const int32 Middle = (Low + High) / 2;
+		if (Chunks[Middle].EndTimeMs < TimeMs)
+			Low = Middle + 1;
+		else
+			High = Middle;
+	}
+
+	return FMath::Max(FMath::Min(Low, Chunks.Num() - 1), 0);
+}
+
+bool FShipReplayReader::ReadChunk(int32 ChunkIndex, TArray<FShipReplayRecord>& OutRecords)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ReadShipReplayChunk);
+
+	OutRecords.Reset();
+	if (File == nullptr || !Chunks.IsValidIndex(ChunkIndex))
+		return false;
+
+	TArray<uint8> Header;
+	Header.SetNumUninitialized(ShipReplayFormat::ChunkHeaderSize);
+	if (!File->Seek(Chunks[ChunkIndex].Offset) || !File->Read(Header.GetData(), Header.Num()))
+		return false;
+
+	FMemoryReader HeaderReader(Header);
+	FShipReplayChunkInfo Chunk;
+	uint32 Magic = 0, NumRecords = 0, NumBits = 0;
+	HeaderReader << Magic << Chunk.StartTimeMs << Chunk.EndTimeMs << NumRecords << NumBits;
+	if (Magic != ShipReplayFormat::ChunkMagic || Chunks[ChunkIndex].Offset + ShipReplayFormat::ChunkHeaderSize + (NumBits + 7) / 8 > FileSize)
+		return false;
+
+	TArray<uint8> Payload;
+	Payload.SetNumUninitialized((NumBits + 7) / 8);
+	if (!File->Read(Payload.GetData(), Payload.Num()))
+		return false;
+
+	//Every ship's first record in the chunk is a keyframe, so its baselines never come from another chunk
+	TMap<uint32, FQuantizedMovementSnapshot> Baselines;
+	FBitReader Reader(Payload.GetData(), NumBits);
+	OutRecords.Reserve(NumRecords);
+	for (uint32 RecordIndex = 0; RecordIndex < NumRecords && !Reader.IsError(); RecordIndex++)
+	{
+		uint32 ShipId = 0;
+		Reader.SerializeIntPacked(ShipId);
+
+		bool bKeyframe = false;
+		FString ShipName;
+		FQuantizedMovementSnapshot State;
+		ShipReplayFormat::SerializeRecord(Reader, bKeyframe, ShipName, State);
+
+		const FQuantizedMovementSnapshot* Baseline = Baselines.Find(ShipId);
+		if (!bKeyframe && Baseline == nullptr)
+			return false;
+
+		const FQuantizedMovementSnapshot Snapshot = bKeyframe ? State : FQuantizedMovementSnapshot::ApplyDelta(*Baseline, State);
+		if (bKeyframe)
+			ShipNames.Add(ShipId, ShipName);
+
+		Baselines.Add(ShipId, Snapshot);
+		OutRecords.Emplace(ShipId, Snapshot);
+	}
+
+	if (Reader.IsError())
+		return false;
+
+	//Ships are recorded as their snapshots arrive, which only orders them per ship
+	OutRecords.StableSort([](const FShipReplayRecord& A, const FShipReplayRecord& B)
+	{
+		return A.Snapshot.TimeStampMs < B.Snapshot.TimeStampMs;
+	});
+	return true;
+}
+
+bool FShipReplayPlayer::Open(const FString& Path)
+{
+	if (!Reader.Open(Path))
+		return false;
+
+	Seek(Reader.GetStartTime());
+	return true;
+}
+
+void FShipReplayPlayer::Seek(float Time)
+{
+	Buffers.Reset();
+	Records.Reset();
+	NextRecord = 0;
+	NextChunk = Reader.FindChunk(Time - SeekPreroll);
+	Update(Time);
+}
+
+bool FShipReplayPlayer::LoadNextChunk()
+{
+	while (NextChunk < Reader.GetNumChunks())
+	{
+		NextRecord = 0;
+		if (Reader.ReadChunk(NextChunk++, Records))
+			return true;
+	}
+
+	Records.Reset();
+	NextRecord = 0;
+	return false;
+}
+
+void FShipReplayPlayer::Update(float Time)
+{
+	const uint32 FeedUntilMs = uint32(FMath::Max(double(Time + Lookahead) * 1000.0, 0.0));
+	while (true)
+	{
+		if (NextRecord >= Records.Num() && !LoadNextChunk())
+			break;
+
+		const FShipReplayRecord& Record = Records[NextRecord];
+		if (Record.Snapshot.TimeStampMs > FeedUntilMs)
+			break;
+
+		//Played back at the recorded times, there's no network left to buffer against
+		FMovementSnapShotBuffer* Buffer = Buffers.Find(Record.ShipId);
+		if (Buffer == nullptr)
+		{
+			Buffer = &Buffers.Add(Record.ShipId);
+			Buffer->BufferDelay = 0.0f;
+			Buffer->JitterSettings.bAdaptiveDelay = false;
+			Buffer->MaxExtrapolationTime = FDeadReckoningSettings().HeartbeatInterval;
+		}
+
+		Buffer->AddToBuffer(Record.Snapshot.Dequantize());
+		NextRecord++;
+	}
+
+	for (auto& Buffer : Buffers)
+	{
+		Buffer.Value.Update(Time);
+	}
+}
+
+bool FShipReplayPlayer::Sample(uint32 ShipId, float Time, FMovementSnapshot& OutSnapshot) const
+{
+	const FMovementSnapShotBuffer* Buffer = Buffers.Find(ShipId);
+	return Buffer != nullptr && Buffer->Sample(Time, OutSnapshot);
+}
+
+bool FShipReplayPlayer::FindShip(const FString& ShipName, uint32& OutShipId) const
+{
+	const uint32* ShipId = Reader.GetShipNames().FindKey(ShipName);
+	if (ShipId == nullptr)
+		return false;
+
+	OutShipId = *ShipId;
+	return true;
+}
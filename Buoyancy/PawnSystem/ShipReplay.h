@@ -0,0 +1,254 @@
+/*=================================================
+* FileName: ShipReplay.h
+*
+* Created by: Sails of War contributors
+* Project name: Sails of War
+* Unreal Engine version: 4.22
+* Created on: 2026/10/18
+*
+* Last Edited on: 2026/10/18
+* Last Edited by: Sails of War contributors
+*
+* -------------------------------------------------
+* Created for: Sails Of War - http://sailsofwargame.com/
+* -------------------------------------------------
+* For parts referencing UE4 code, the following copyright applies:
+* Copyright 1998-2020 Epic Games, Inc. All Rights Reserved.
+*
+* Feel free to use this software in any commercial/free game.
+* Selling this as a plugin/item, in whole or part, is not allowed.
+* =================================================*/
+#pragma once
+
+//Libary Includes:
+#include "PhysicsMovementReplication.h"
+
+//Engine Includes:
+#include "CoreMinimal.h"
+#include "Serialization/BitWriter.h"
+#include "Async/TaskGraphInterfaces.h"
+
+#include "ShipReplay.generated.h"
+
+class IFileHandle;
+
+//Settings for recording every ship snapshot the server accepts
+USTRUCT(BlueprintType)
+struct FShipReplaySettings
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere)
+		bool bEnableRecording = false; //Record every accepted ship snapshot to Saved/Replays
+
+	UPROPERTY(EditAnywhere, meta = (EditCondition = "bEnableRecording", ClampMin = "0.5"))
+		float ChunkDuration = 5.0f; //Seconds per chunk, every chunk starts each ship with a keyframe so it's a seek point
+
+	UPROPERTY(EditAnywhere, meta = (EditCondition = "bEnableRecording", ClampMin = "1024"))
+		int32 MaxChunkBytes = 65536; //A chunk is written early once it's this large, bounds the memory of both the recorder and the player
+
+	UPROPERTY(EditAnywhere, meta = (EditCondition = "bEnableRecording"))
+		FString FilePrefix = TEXT("Ships"); //Recordings are named <FilePrefix>_<Date>.sowreplay
+
+	FShipReplaySettings() {};
+};
+
+//Where a chunk of a recording lives and the snapshot times it covers
+struct FShipReplayChunkInfo
+{
+	uint32 StartTimeMs = 0; //The oldest snapshot in the chunk, a lagging ship's clock can put it before the previous chunk's
+	uint32 EndTimeMs = 0; //The newest snapshot in the chunk or any chunk before it, so the ends never decrease and the index is searched by them
+	int64 Offset = 0; //Of the chunk's header in the file
+
+	FShipReplayChunkInfo() {};
+};
+
+//A single recorded snapshot
+struct FShipReplayRecord
+{
+	uint32 ShipId = 0;
+	FQuantizedMovementSnapshot Snapshot;
+
+	FShipReplayRecord() {};
+	FShipReplayRecord(uint32 InShipId, const FQuantizedMovementSnapshot& InSnapshot) : ShipId(InShipId), Snapshot(InSnapshot) {}
+};
+
+/*
+* Streams ship snapshots to disk, append-only.
+* The file is a header followed by chunks, each a small header and a bit packed run of records. A ship's first record in a chunk
+* is a keyframe carrying its name, the rest are deltas against its previous record, so any chunk can be decoded on its own.
+* Only the chunk being filled is held in memory. Every chunk is flushed as it's closed, so a crash loses at most the open one.
+* Closing the recording appends the chunk index and a footer pointing at it, readers rebuild the index from the chunk headers when it's missing.
+* Records come in from the movement RPCs, so the file is only written on a background thread - each write waits on the one before it.
+*/
+class SAILSOFWAR_API FShipReplayWriter
+{
+public:
+	FShipReplayWriter() {};
+	~FShipReplayWriter() { Close(); }
+
+	/**
+	*	Start a recording, closing the current one
+	*	@param	Path - The file to write, its directory is created
+	*	@param	InSettings - The recording settings
+	*	@return	bool - false if the file couldn't be opened
+	*/
+	bool Open(const FString& Path, const FShipReplaySettings& InSettings);
+
+	/* Write the open chunk and the index, and close the file once every write finished */
+	void Close();
+
+	bool IsOpen() const { return File != nullptr; }
+
+	/**
+	*	Record a snapshot, snapshots no newer than the ship's last recorded one are dropped
+	*	@param	ShipId - Identifies the ship for the whole recording
+	*	@param	ShipName - The ship's name, only written with its keyframes
+	*	@param	Snapshot - The quantized snapshot
+	*/
+	void Record(uint32 ShipId, const FString& ShipName, const FQuantizedMovementSnapshot& Snapshot);
+
+	int64 GetBytesWritten() const { return BytesWritten; }
+
+private:
+	/* Write the open chunk to the file and start the next one */
+	void FlushChunk();
+
+	/* Queue bytes to be appended to the file on a background thread, after every write queued before them */
+	void WriteAsync(TArray<uint8>&& Data);
+
+	struct FShipState
+	{
+		FQuantizedMovementSnapshot LastSnapshot;
+		bool bHasSnapshot = false;
+		bool bInChunk = false; //Whether the open chunk has the ship's keyframe
+	};
+
+	IFileHandle* File = nullptr;
+	FShipReplaySettings Settings;
+
+	TMap<uint32, FShipState> Ships;
+	TArray<FShipReplayChunkInfo> Chunks; //Every chunk written, the index appended on Close()
+
+	TUniquePtr<FBitWriter> ChunkWriter; //The open chunk's records
+	FShipReplayChunkInfo OpenChunk;
+	uint32 NumChunkRecords = 0;
+
+	int64 BytesWritten = 0; //Including the queued writes, the offset the next write lands at
+
+	FGraphEventRef PendingWrite; //The last queued write
+};
+
+//Reads a recording chunk by chunk, see FShipReplayWriter for the format
+class SAILSOFWAR_API FShipReplayReader
+{
+public:
+	FShipReplayReader() {};
+	~FShipReplayReader() { Close(); }
+
+	/**
+	*	Open a recording and load its chunk index
+	*	@param	Path - The recording
+	*	@return	bool - false if it isn't a readable recording
+	*/
+	bool Open(const FString& Path);
+
+	void Close();
+
+	/**
+	*	Find the chunk to start reading from to reach a time, every chunk before it only holds older snapshots
+	*	@param	Time - The time in seconds
+	*	@return	int32 - the first chunk ending at or after the time, the last chunk if the time is past the recording
+	*/
+	int32 FindChunk(float Time) const;
+
+	/**
+	*	Decode a chunk's records, sorted by time
+	*	@param	ChunkIndex - The chunk to read
+	*	@param	OutRecords - The chunk's records
+	*	@return	bool - false if the chunk couldn't be read
+	*/
+	bool ReadChunk(int32 ChunkIndex, TArray<FShipReplayRecord>& OutRecords);
+
+	int32 GetNumChunks() const { return Chunks.Num(); }
+	const FShipReplayChunkInfo& GetChunk(int32 ChunkIndex) const { return Chunks[ChunkIndex]; }
+
+	float GetStartTime() const { return Chunks.Num() > 0 ? Chunks[0].StartTimeMs / 1000.0f : 0.0f; }
+	float GetEndTime() const { return Chunks.Num() > 0 ? Chunks.Last().EndTimeMs / 1000.0f : 0.0f; }
+
+	/* The names of every ship in the chunks read so far */
+	const TMap<uint32, FString>& GetShipNames() const { return ShipNames; }
+
+private:
+	/* Load the index from the footer, returns false if the recording wasn't closed */
+	bool ReadIndex();
+
+	/* Rebuild the index by skipping from chunk header to chunk header */
+	void ScanChunks();
+
+	IFileHandle* File = nullptr;
+	int64 FileSize = 0;
+	TArray<FShipReplayChunkInfo> Chunks;
+	TMap<uint32, FString> ShipNames;
+};
+
+/*
+* Plays a recording back into a snapshot buffer per ship, for replays, killcams and analysis.
+* Records are streamed in a chunk at a time as the playback time passes them, so memory stays bounded by a chunk and the buffers.
+* Seeking jumps straight to the chunk before the time through the index.
+*/
+struct SAILSOFWAR_API FShipReplayPlayer
+{
+	float Lookahead = 0.5f; //Seconds of records fed to the buffers ahead of the playback time
+	float SeekPreroll = 0.5f; //Seconds before a seek's time reading starts, so every ship has a snapshot to interpolate from
+
+	FShipReplayPlayer() {};
+
+	/**
+	*	Open a recording and seek to its start
+	*	@param	Path - The recording
+	*	@return	bool - false if it isn't a readable recording
+	*/
+	bool Open(const FString& Path);
+
+	/**
+	*	Jump to a time, the buffers are refilled from the chunk before it
+	*	@param	Time - The time in seconds
+	*/
+	void Seek(float Time);
+
+	/**
+	*	Feed the records up to the time plus the lookahead to the buffers, and evict the ones behind it
+	*	@param	Time - The playback time in seconds, seek instead to go backwards
+	*/
+	void Update(float Time);
+
+	/**
+	*	Sample a ship's state
+	*	@param	ShipId - The ship
+	*	@param	Time - The playback time in seconds
+	*	@param	OutSnapshot - The ship's interpolated state
+	*	@return	bool - false if the ship has no snapshots around the time
+	*/
+	bool Sample(uint32 ShipId, float Time, FMovementSnapshot& OutSnapshot) const;
+
+	/**
+	*	Find a ship by the name it was recorded with
+	*	@param	ShipName - The name
+	*	@param	OutShipId - The ship's id
+	*	@return	bool - false if no ship read so far has the name
+	*/
+	bool FindShip(const FString& ShipName, uint32& OutShipId) const;
+
+	const FShipReplayReader& GetReader() const { return Reader; }
+
+private:
+	/* Load the next chunk's records, returns false at the end of the recording */
+	bool LoadNextChunk();
+
+	FShipReplayReader Reader;
+	TArray<FShipReplayRecord> Records; //The loaded chunk
+	int32 NextRecord = 0;
+	int32 NextChunk = 0;
+	TMap<uint32, FMovementSnapShotBuffer> Buffers;
+};
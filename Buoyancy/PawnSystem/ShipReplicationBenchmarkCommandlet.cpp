@@ -0,0 +1,452 @@
+/*=================================================
+* FileName: ShipReplicationBenchmarkCommandlet.cpp
+*
+* Created by: Sails of War contributors
+* Project name: Sails of War
+* Unreal Engine version: 4.22
+* Created on: 2026/10/18
+*
+* Last Edited on: 2026/10/18
+* Last Edited by: Sails of War contributors
+*
+* -------------------------------------------------
+* Created for: Sails Of War - http://sailsofwargame.com/
+* -------------------------------------------------
+* For parts referencing UE4 code, the following copyright applies:
+* Copyright 1998-2020 Epic Games, Inc. All Rights Reserved.
+*
+* Feel free to use this software in any commercial/free game.
+* Selling this as a plugin/item, in whole or part, is not allowed.
+* =================================================*/
+//Libary Includes:
+#include "ShipReplicationBenchmarkCommandlet.h"
+
+//Engine Includes:
+#include "Misc/Parse.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/BitReader.h"
+#include "Serialization/BitWriter.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogShipReplicationBenchmark, Log, All);
+
+void FReplicationBenchmarkSettings::Parse(const TCHAR* Params)
+{
+	FParse::Value(Params, TEXT("Duration="), Duration);
+	FParse::Value(Params, TEXT("Warmup="), WarmupTime);
+	FParse::Value(Params, TEXT("FrameRate="), FrameRate);
+	FParse::Value(Params, TEXT("Ships="), NumShips);
+	FParse::Value(Params, TEXT("Seed="), Seed);
+
+	FParse::Value(Params, TEXT("Latency="), Latency);
+	FParse::Value(Params, TEXT("Jitter="), Jitter);
+	FParse::Value(Params, TEXT("Loss="), LossRate);
+	FParse::Value(Params, TEXT("Reorder="), ReorderRate);
+	FParse::Value(Params, TEXT("ReorderDelay="), ReorderDelay);
+	FParse::Value(Params, TEXT("PacketOverhead="), PacketOverhead);
+
+	FParse::Value(Params, TEXT("Trajectory="), TrajectoryPath);
+	FParse::Value(Params, TEXT("Report="), ReportPath);
+	FParse::Value(Params, TEXT("MaxP95Error="), MaxPositionErrorP95);
+
+	FParse::Value(Params, TEXT("SendRate="), Replication.SendRate);
+	FParse::Value(Params, TEXT("BufferSize="), Replication.BufferSize);
+	FParse::Value(Params, TEXT("KeyframeInterval="), Replication.KeyframeInterval);
+	FParse::Value(Params, TEXT("RedundantSnapshots="), Replication.RedundantSnapshots);
+	if (FParse::Param(Params, TEXT("NoDeltaCompression")))
+		Replication.bEnableDeltaCompression = false;
+	if (FParse::Param(Params, TEXT("NoAdaptiveDelay")))
+		Replication.JitterBuffer.bAdaptiveDelay = false;
+	if (FParse::Param(Params, TEXT("NoSendSuppression")))
+		Replication.DeadReckoning.bEnableSendSuppression = false;
+
+	Duration = FMath::Max(Duration, WarmupTime + 1.0f);
+	FrameRate = FMath::Max(FrameRate, 1.0f);
+	NumShips = FMath::Max(NumShips, 1);
+	Replication.SendRate = FMath::Max<uint32>(Replication.SendRate, 1);
+	Replication.RedundantSnapshots = FMath::Clamp(Replication.RedundantSnapshots, 0, FMovementSnapshotPacket::MaxRedundantStates);
+}
+
+void FBenchmarkTrajectory::GenerateSynthetic(FRandomStream& Stream, float Duration, float SampleRate)
+{
+	const float Speed = Stream.FRandRange(300.0f, 1200.0f);
+	const float StartYaw = Stream.FRandRange(-180.0f, 180.0f);
+	const float TurnRate = Stream.FRandRange(-3.0f, 3.0f);
+	const float WeaveAmplitude = Stream.FRandRange(5.0f, 40.0f);
+	const float WeavePeriod = Stream.FRandRange(30.0f, 90.0f);
+	const float HeaveAmplitude = Stream.FRandRange(20.0f, 150.0f);
+	const float HeavePeriod = Stream.FRandRange(5.0f, 12.0f);
+	const float RollAmplitude = Stream.FRandRange(2.0f, 12.0f);
+	const float RollPeriod = Stream.FRandRange(6.0f, 14.0f);
+	const float PitchAmplitude = Stream.FRandRange(1.0f, 5.0f);
+	const float PitchPeriod = Stream.FRandRange(4.0f, 10.0f);
+	const float Phase = Stream.FRandRange(0.0f, 2.0f * PI);
+
+	const int32 NumSamples = FMath::CeilToInt(Duration * SampleRate) + 1;
+	const float DeltaTime = 1.0f / SampleRate;
+	Samples.SetNum(NumSamples);
+
+	//Integrate the course, then take the velocities from the samples so they agree with the path exactly
+	FVector2D Position = FVector2D(Stream.FRandRange(-100000.0f, 100000.0f), Stream.FRandRange(-100000.0f, 100000.0f));
+	for (int32 Index = 0; Index < NumSamples; Index++)
+	{
+		const float Time = Index * DeltaTime;
+		const float Yaw = StartYaw + TurnRate * Time + WeaveAmplitude * FMath::Sin(2.0f * PI * Time / WeavePeriod);
+		const float Pitch = PitchAmplitude * FMath::Sin(2.0f * PI * Time / PitchPeriod + Phase);
+		const float Roll = RollAmplitude * FMath::Sin(2.0f * PI * Time / RollPeriod + Phase * 0.5f);
+		const float Heave = HeaveAmplitude * FMath::Sin(2.0f * PI * Time / HeavePeriod + Phase * 2.0f);
+		const float Surge = Speed * (1.0f + 0.1f * FMath::Sin(2.0f * PI * Time / HeavePeriod));
+
+		if (Index > 0)
+			Position += FVector2D(FMath::Cos(FMath::DegreesToRadians(Yaw)), FMath::Sin(FMath::DegreesToRadians(Yaw))) * Surge * DeltaTime;
+
+		FMovementSnapshot& Sample = Samples[Index];
+		Sample.Location = FVector(Position, Heave);
+		Sample.Rotation = FRotator(Pitch, Yaw, Roll).Quaternion();
+		Sample.TimeStamp = Time;
+	}
+
+	for (int32 Index = 0; Index < NumSamples; Index++)
+	{
+		const FMovementSnapshot& Previous = Samples[FMath::Max(Index - 1, 0)];
+		const FMovementSnapshot& Next = Samples[FMath::Min(Index + 1, NumSamples - 1)];
+		const float Interval = Next.TimeStamp - Previous.TimeStamp;
+
+		FQuat Delta = Next.Rotation * Previous.Rotation.Inverse();
+		if (Delta.W < 0.0f)
+			Delta = Delta * -1.0f;
+
+		FVector Axis;
+		float Angle;
+		Delta.ToAxisAndAngle(Axis, Angle);
+
+		Samples[Index].LinearVelocity = (Next.Location - Previous.Location) / Interval;
+		Samples[Index].AngularVelocity = Axis * FMath::RadiansToDegrees(Angle) / Interval;
+	}
+}
+
+bool FBenchmarkTrajectory::LoadFromFile(const FString& Path)
+{
+	TArray<FString> Lines;
+	if (!FFileHelper::LoadFileToStringArray(Lines, *Path))
+		return false;
+
+	Samples.Reset();
+	for (const FString& Line : Lines)
+	{
+		TArray<FString> Columns;
+		Line.ParseIntoArray(Columns, TEXT(","), true);
+		if (Columns.Num() < 13 || !Columns[0].TrimStartAndEnd().IsNumeric())
+			continue;
+
+		float Values[13];
+		for (int32 Column = 0; Column < 13; Column++)
+		{
+			Values[Column] = FCString::Atof(*Columns[Column]);
+		}
+
+		//Samples must be in time order to be interpolated
+		if (Samples.Num() > 0 && Values[0] <= Samples.Last().TimeStamp)
+			continue;
+
+		const FVector Location = FVector(Values[1], Values[2], Values[3]);
+		const FQuat Rotation = FRotator(Values[4], Values[5], Values[6]).Quaternion();
+		const FVector LinearVelocity = FVector(Values[7], Values[8], Values[9]);
+		const FVector AngularVelocity = FVector(Values[10], Values[11], Values[12]);
+		Samples.Add(FMovementSnapshot(LinearVelocity, AngularVelocity, Location, Rotation, Values[0]));
+	}
+
+	//Start at zero, the benchmark's clock does
+	for (int32 Index = Samples.Num() - 1; Index >= 0; Index--)
+	{
+		Samples[Index].TimeStamp -= Samples[0].TimeStamp;
+	}
+
+	return Samples.Num() >= 2;
+}
+
+FMovementSnapshot FBenchmarkTrajectory::Evaluate(float Time) const
+{
+	check(Samples.Num() > 0);
+	if (Time <= Samples[0].TimeStamp)
+		return Samples[0];
+	if (Time >= Samples.Last().TimeStamp)
+		return Samples.Last();
+
+	int32 Low = 0, High = Samples.Num() - 1;
+	while (High - Low > 1)
+	{
+		const int32 Middle = (Low + High) / 2;
+		if (Samples[Middle].TimeStamp <= Time)
+			Low = Middle;
+		else
+			High = Middle;
+	}
+
+	const float Interval = Samples[High].TimeStamp - Samples[Low].TimeStamp;
+	return FMovementSnapshot::Interpolate(Samples[Low], Samples[High], (Time - Samples[Low].TimeStamp) / Interval);
+}
+
+void FSimulatedLink::Send(const TArray<uint8>& Data, int64 NumBits, float Time, const FReplicationBenchmarkSettings& Settings, FRandomStream& Stream)
+{
+	if (Stream.GetFraction() < Settings.LossRate)
+		return;
+
+	float Delay = Settings.Latency + Stream.FRandRange(-Settings.Jitter, Settings.Jitter);
+	if (Stream.GetFraction() < Settings.ReorderRate)
+		Delay += Settings.ReorderDelay;
+
+	FPacket Packet;
+	Packet.Data = Data;
+	Packet.NumBits = NumBits;
+	Packet.ArrivalTime = Time + FMath::Max(Delay, 0.0f) * 0.001f;
+
+	int32 InsertIndex = InFlight.Num();
+	while (InsertIndex > 0 && InFlight[InsertIndex - 1].ArrivalTime > Packet.ArrivalTime)
+	{
+		InsertIndex--;
+	}
+	InFlight.Insert(MoveTemp(Packet), InsertIndex);
+}
+
+void FSimulatedLink::Receive(float Time, TArray<FPacket>& OutPackets)
+{
+	OutPackets.Reset();
+
+	int32 NumArrived = 0;
+	while (NumArrived < InFlight.Num() && InFlight[NumArrived].ArrivalTime <= Time)
+	{
+		OutPackets.Add(MoveTemp(InFlight[NumArrived]));
+		NumArrived++;
+	}
+	InFlight.RemoveAt(0, NumArrived, false);
+}
+
+/**
+*	Get a percentile of sorted values
+*	@param	SortedValues - The values, sorted ascending
+*	@param	Percentile - The percentile in [0, 1]
+*	@return	float - the value at the percentile, 0 if there are none
+*/
+static float GetPercentile(const TArray<float>& SortedValues, float Percentile)
+{
+	if (SortedValues.Num() == 0)
+		return 0.0f;
+
+	const int32 Index = FMath::Clamp(FMath::CeilToInt(Percentile * SortedValues.Num()) - 1, 0, SortedValues.Num() - 1);
+	return SortedValues[Index];
+}
+
+UShipReplicationBenchmarkCommandlet::UShipReplicationBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+
+	HelpDescription = TEXT("Replicates synthetic or recorded ship trajectories through a simulated link and reports bandwidth, interpolation error and display latency");
+	HelpUsage = TEXT("-run=ShipReplicationBenchmark [-Ships=8] [-Duration=60] [-Latency=100] [-Jitter=20] [-Loss=0.02] [-Reorder=0.01] [-SendRate=20] [-Trajectory=File.csv] [-Report=File.json] [-MaxP95Error=cm]");
+}
+
+int32 UShipReplicationBenchmarkCommandlet::Main(const FString& Params)
+{
+	FReplicationBenchmarkSettings Settings;
+	Settings.Parse(*Params);
+
+	FBenchmarkTrajectory RecordedTrajectory;
+	const bool bRecorded = !Settings.TrajectoryPath.IsEmpty();
+	if (bRecorded)
+	{
+		if (!RecordedTrajectory.LoadFromFile(Settings.TrajectoryPath))
+		{
+			UE_LOG(LogShipReplicationBenchmark, Error, TEXT("Couldn't load a trajectory from %s"), *Settings.TrajectoryPath);
+			return 1;
+		}
+		Settings.Duration = FMath::Min(Settings.Duration, RecordedTrajectory.GetDuration());
+	}
+
+	//Every ship draws from its own stream, so the results for a seed don't depend on the order anything is drawn in
+	FReplicationBenchmarkResults Results;
+	for (int32 Ship = 0; Ship < Settings.NumShips; Ship++)
+	{
+		FRandomStream TrajectoryStream = FRandomStream(Settings.Seed * 7919 + Ship);
+		FRandomStream LinkStream = FRandomStream(Settings.Seed * 7919 + Ship + 104729);
+
+		if (bRecorded)
+			RunShip(RecordedTrajectory, Settings, LinkStream, Results);
+		else
+		{
+			FBenchmarkTrajectory Trajectory;
+			Trajectory.GenerateSynthetic(TrajectoryStream, Settings.Duration, FMath::Max(Settings.FrameRate * 2.0f, 120.0f));
+			RunShip(Trajectory, Settings, LinkStream, Results);
+		}
+	}
+
+	return ReportResults(Results, Settings) ? 0 : 1;
+}
+
+void UShipReplicationBenchmarkCommandlet::RunShip(const FBenchmarkTrajectory& Trajectory, const FReplicationBenchmarkSettings& Settings, FRandomStream& Stream, FReplicationBenchmarkResults& Results) const
+{
+	//The sender and receiver share a clock, as they do once the replication clock has converged
+	FPhysicsMovementReplication Replication;
+	Replication.Settings = Settings.Replication;
+	Replication.ApplySettingsToBuffers();
+
+	FPhysicsMovementReplication_ClientAuth& Sender = Replication.AuthMovementReplication;
+	FPhysicsMovementReplication_Server& Receiver = Replication.ServerMovementReplication;
+
+	FSimulatedLink SnapshotLink, AckLink;
+	TArray<FSimulatedLink::FPacket> Arrived;
+
+	const float FrameTime = 1.0f / Settings.FrameRate;
+	const float SendInterval = 1.0f / Settings.Replication.SendRate;
+	const int32 NumFrames = FMath::FloorToInt(Settings.Duration * Settings.FrameRate);
+	for (int32 Frame = 0; Frame <= NumFrames; Frame++)
+	{
+		const float Time = Frame * FrameTime;
+
+		//Sender, as ANetworkedBuoyantPawn::ClientUpdateMovement()
+		AckLink.Receive(Time, Arrived);
+		for (FSimulatedLink::FPacket& Ack : Arrived)
+		{
+			FBitReader Reader(Ack.Data.GetData(), Ack.NumBits);
+			uint16 Sequence = 0;
+			Reader << Sequence;
+			if (!Reader.IsError())
+				Sender.Encoder.Acknowledge(Sequence);
+		}
+
+		Sender.TimeSinceLastPacketSent += FrameTime;
+		Sender.TimeSinceLastSnapshotSent += FrameTime;
+		if (Sender.TimeSinceLastPacketSent >= SendInterval)
+		{
+			Sender.TimeSinceLastPacketSent -= SendInterval;
+
+			FMovementSnapshot NewSnapShot = Trajectory.Evaluate(Time);
+			NewSnapShot.TimeStamp = Time;
+			NewSnapShot.Quantization = Settings.Replication.Quantization;
+			const FQuantizedMovementSnapshot QuantizedSnapShot = FQuantizedMovementSnapshot::Quantize(NewSnapShot);
+			const FMovementSnapshot SentSnapShot = QuantizedSnapShot.Dequantize();
+			if (Sender.ShouldSendSnapshot(SentSnapShot, Settings.Replication.DeadReckoning))
+			{
+				Sender.LastSentSnapshot = SentSnapShot;
+				Sender.bHasSentSnapshot = true;
+				Sender.TimeSinceLastSnapshotSent = 0.0f;
+
+				FMovementSnapshotPacket Packet = Sender.Encoder.Encode(QuantizedSnapShot, Settings.Replication, true);
+				FBitWriter Writer(0, true);
+				bool bSuccess = true;
+				Packet.NetSerialize(Writer, nullptr, bSuccess);
+
+				Results.PayloadBits += Writer.GetNumBits();
+				Results.PacketsSent++;
+				Results.KeyframesSent += Packet.bKeyframe ? 1 : 0;
+				SnapshotLink.Send(*Writer.GetBuffer(), Writer.GetNumBits(), Time, Settings, Stream);
+			}
+			else
+				Results.SnapshotsSuppressed++;
+		}
+
+		//Receiver, as ANetworkedBuoyantPawn::ServerRecieveMovement()
+		SnapshotLink.Receive(Time, Arrived);
+		for (FSimulatedLink::FPacket& Arrival : Arrived)
+		{
+			FBitReader Reader(Arrival.Data.GetData(), Arrival.NumBits);
+			FMovementSnapshotPacket Packet;
+			bool bSuccess = true;
+			Packet.NetSerialize(Reader, nullptr, bSuccess);
+			if (!bSuccess || Reader.IsError())
+				continue;
+
+			Results.PacketsDelivered++;
+			FQuantizedMovementSnapshot QuantizedSnapShot;
+			if (!Packet.Decode(Receiver.ReceivedSnapshots, Time, QuantizedSnapShot))
+			{
+				Results.UndecodablePackets++;
+				continue;
+			}
+
+			FBitWriter AckWriter(0, true);
+			uint16 Sequence = Packet.Sequence;
+			AckWriter << Sequence;
+			Results.AckBits += AckWriter.GetNumBits();
+			AckLink.Send(*AckWriter.GetBuffer(), AckWriter.GetNumBits(), Time, Settings, Stream);
+
+			TArray<FQuantizedMovementSnapshot, TInlineAllocator<FMovementSnapshotPacket::MaxRedundantStates>> RedundantSnapShots;
+			Packet.DecodeRedundant(QuantizedSnapShot, Receiver.ReceivedSnapshots, RedundantSnapShots);
+			for (int32 Index = RedundantSnapShots.Num() - 1; Index >= 0; Index--)
+			{
+				Receiver.SnapshotBuffer.ReceiveSnapshot(RedundantSnapShots[Index].Dequantize(), Time, uint16(Packet.Sequence - 1 - Index));
+			}
+			Receiver.SnapshotBuffer.ReceiveSnapshot(QuantizedSnapShot.Dequantize(), Time, Packet.Sequence);
+		}
+
+		Receiver.SnapshotBuffer.Update(Time);
+		if (Time < Settings.WarmupTime)
+			continue;
+
+		//What would be displayed this frame against where the ship really was at the displayed time
+		Results.FramesMeasured++;
+		FMovementSnapshot Displayed;
+		if (!Receiver.SnapshotBuffer.Sample(Time, Displayed))
+		{
+			Results.FramesWithoutSample++;
+			continue;
+		}
+
+		const FMovementSnapshot Truth = Trajectory.Evaluate(Displayed.TimeStamp);
+		Results.PositionErrors.Add(FVector::Dist(Displayed.Location, Truth.Location));
+		Results.RotationErrors.Add(FMath::RadiansToDegrees(Displayed.Rotation.AngularDistance(Truth.Rotation)));
+		Results.DisplayLatencies.Add((Time - Displayed.TimeStamp) * 1000.0f);
+	}
+}
+
+bool UShipReplicationBenchmarkCommandlet::ReportResults(FReplicationBenchmarkResults& Results, const FReplicationBenchmarkSettings& Settings) const
+{
+	Results.PositionErrors.Sort();
+	Results.RotationErrors.Sort();
+	Results.DisplayLatencies.Sort();
+
+	const float ShipSeconds = Settings.Duration * Settings.NumShips;
+	const float PayloadBytesPerShip = Results.PayloadBits / 8.0f / ShipSeconds;
+	const float WireBytesPerShip = PayloadBytesPerShip + float(Results.PacketsSent) * Settings.PacketOverhead / ShipSeconds;
+	const float AckBytesPerShip = Results.AckBits / 8.0f / ShipSeconds;
+	const float DeliveryRate = Results.PacketsSent > 0 ? float(Results.PacketsDelivered) / Results.PacketsSent : 0.0f;
+	const float CoverageRate = Results.FramesMeasured > 0 ? 1.0f - float(Results.FramesWithoutSample) / Results.FramesMeasured : 0.0f;
+
+	FString Report;
+	Report += TEXT("{\n");
+	Report += FString::Printf(TEXT("\t\"Ships\": %d,\n\t\"Duration\": %.1f,\n\t\"Seed\": %d,\n"), Settings.NumShips, Settings.Duration, Settings.Seed);
+	Report += FString::Printf(TEXT("\t\"Latency\": %.1f,\n\t\"Jitter\": %.1f,\n\t\"Loss\": %.3f,\n\t\"Reorder\": %.3f,\n"), Settings.Latency, Settings.Jitter, Settings.LossRate, Settings.ReorderRate);
+	Report += FString::Printf(TEXT("\t\"SendRate\": %u,\n\t\"DeltaCompression\": %s,\n\t\"RedundantSnapshots\": %d,\n"), Settings.Replication.SendRate, Settings.Replication.bEnableDeltaCompression ? TEXT("true") : TEXT("false"), Settings.Replication.RedundantSnapshots);
+	Report += FString::Printf(TEXT("\t\"PayloadBytesPerSecondPerShip\": %.1f,\n\t\"WireBytesPerSecondPerShip\": %.1f,\n\t\"AckBytesPerSecondPerShip\": %.1f,\n"), PayloadBytesPerShip, WireBytesPerShip, AckBytesPerShip);
+	Report += FString::Printf(TEXT("\t\"PacketsSent\": %d,\n\t\"DeliveryRate\": %.4f,\n\t\"Keyframes\": %d,\n\t\"Suppressed\": %d,\n\t\"Undecodable\": %d,\n"), Results.PacketsSent, DeliveryRate, Results.KeyframesSent, Results.SnapshotsSuppressed, Results.UndecodablePackets);
+	Report += FString::Printf(TEXT("\t\"Coverage\": %.4f,\n"), CoverageRate);
+
+	const TPair<const TCHAR*, const TArray<float>*> Metrics[] =
+	{
+		TPair<const TCHAR*, const TArray<float>*>(TEXT("PositionError"), &Results.PositionErrors),
+		TPair<const TCHAR*, const TArray<float>*>(TEXT("RotationError"), &Results.RotationErrors),
+		TPair<const TCHAR*, const TArray<float>*>(TEXT("DisplayLatency"), &Results.DisplayLatencies),
+	};
+	for (int32 Metric = 0; Metric < ARRAY_COUNT(Metrics); Metric++)
+	{
+		const TArray<float>& Values = *Metrics[Metric].Value;
+		Report += FString::Printf(TEXT("\t\"%s\": { \"P50\": %.3f, \"P95\": %.3f, \"P99\": %.3f, \"Max\": %.3f }%s\n"), Metrics[Metric].Key,
+			GetPercentile(Values, 0.5f), GetPercentile(Values, 0.95f), GetPercentile(Values, 0.99f), Values.Num() > 0 ? Values.Last() : 0.0f, Metric + 1 < ARRAY_COUNT(Metrics) ? TEXT(",") : TEXT(""));
+	}
+	Report += TEXT("}\n");
+
+	UE_LOG(LogShipReplicationBenchmark, Display, TEXT("Ship replication benchmark:\n%s"), *Report);
+
+	if (!Settings.ReportPath.IsEmpty() && !FFileHelper::SaveStringToFile(Report, *Settings.ReportPath))
+		UE_LOG(LogShipReplicationBenchmark, Warning, TEXT("Couldn't write the report to %s"), *Settings.ReportPath);
+
+	const float PositionErrorP95 = GetPercentile(Results.PositionErrors, 0.95f);
+	if (Settings.MaxPositionErrorP95 > 0.0f && (PositionErrorP95 > Settings.MaxPositionErrorP95 || Results.PositionErrors.Num() == 0))
+	{
+		UE_LOG(LogShipReplicationBenchmark, Error, TEXT("95th percentile position error %.3fcm exceeds the limit of %.3fcm"), PositionErrorP95, Settings.MaxPositionErrorP95);
+		return false;
+	}
+
+	return true;
+}
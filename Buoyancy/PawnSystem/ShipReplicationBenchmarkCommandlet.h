@@ -0,0 +1,188 @@
+/*=================================================
+* FileName: ShipReplicationBenchmarkCommandlet.h
+*
+* Created by: Sails of War contributors
+* Project name: Sails of War
+* Unreal Engine version: 4.22
+* Created on: 2026/10/18
+*
+* Last Edited on: 2026/10/18
+* Last Edited by: Sails of War contributors
+*
+* -------------------------------------------------
+* Created for: Sails Of War - http://sailsofwargame.com/
+* -------------------------------------------------
+* For parts referencing UE4 code, the following copyright applies:
+* Copyright 1998-2020 Epic Games, Inc. All Rights Reserved.
+*
+* Feel free to use this software in any commercial/free game.
+* Selling this as a plugin/item, in whole or part, is not allowed.
+* =================================================*/
+#pragma once
+
+//Libary Includes:
+#include "PhysicsMovementReplication.h"
+
+//Engine Includes:
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "Math/RandomStream.h"
+
+#include "ShipReplicationBenchmarkCommandlet.generated.h"
+
+//The conditions of a benchmark run, parsed from the command line
+struct FReplicationBenchmarkSettings
+{
+	float Duration = 60.0f; //Simulated seconds per ship
+	float WarmupTime = 2.0f; //Seconds at the start that aren't measured, the buffers fill and the adaptive delay settles
+	float FrameRate = 60.0f; //How often the sender ticks and the receiver samples
+	int32 NumShips = 8;
+	int32 Seed = 1;
+
+	float Latency = 100.0f; //in milliseconds, one way
+	float Jitter = 20.0f; //in milliseconds, the most a packet's latency varies from Latency
+	float LossRate = 0.02f; //The fraction of packets dropped
+	float ReorderRate = 0.01f; //The fraction of packets held back so later ones overtake them
+	float ReorderDelay = 50.0f; //in milliseconds, how long reordered packets are held back
+	int32 PacketOverhead = 28; //Bytes of UDP and IPv4 headers per packet, the engine's own bunch headers aren't counted
+
+	FString TrajectoryPath; //A recorded trajectory to replay for every ship instead of the synthetic ones
+	FString ReportPath; //Where to write the results, nothing is written if empty
+	float MaxPositionErrorP95 = 0.0f; //cm, the run fails if the 95th percentile error is larger, 0 disables the check
+
+	FPhysicsReplicationSettings Replication;
+
+	FReplicationBenchmarkSettings() {};
+
+	/**
+	*	Parse the settings from a commandlet's parameters, anything not given keeps its default
+	*	@param	Params - The commandlet's parameters, e.g. -Latency=150 -Loss=0.05 -NoDeltaCompression
+	*/
+	void Parse(const TCHAR* Params);
+};
+
+/*
+* A ship's true movement, sampled at a fixed rate and interpolated between the samples.
+* Recorded trajectories are CSV files with a row per sample:
+*	Time, X, Y, Z, Pitch, Yaw, Roll, LinearVelocity X, Y, Z, AngularVelocity X, Y, Z
+* in seconds, centimeters, degrees, cm/s and deg/s. A header row is skipped.
+*/
+struct FBenchmarkTrajectory
+{
+	TArray<FMovementSnapshot> Samples;
+
+	FBenchmarkTrajectory() {};
+
+	/**
+	*	Generate a ship sailing a slowly changing course through a swell, each ship gets its own course and swell from the stream
+	*	@param	Stream - The random stream the ship's parameters are drawn from
+	*	@param	Duration - Seconds of movement to generate
+	*	@param	SampleRate - Samples per second
+	*/
+	void GenerateSynthetic(FRandomStream& Stream, float Duration, float SampleRate);
+
+	/**
+	*	Load a recorded trajectory
+	*	@param	Path - The CSV file
+	*	@return	bool - false if the file couldn't be read or has fewer than two samples
+	*/
+	bool LoadFromFile(const FString& Path);
+
+	/**
+	*	Get the true state at a time, clamped to the trajectory
+	*	@param	Time - Seconds from the start of the trajectory
+	*	@return	FMovementSnapshot - the state at Time
+	*/
+	FMovementSnapshot Evaluate(float Time) const;
+
+	float GetDuration() const { return Samples.Num() > 0 ? Samples.Last().TimeStamp : 0.0f; }
+};
+
+//A one way link that delays, jitters, drops and reorders the packets sent through it
+struct FSimulatedLink
+{
+	struct FPacket
+	{
+		TArray<uint8> Data;
+		int64 NumBits = 0;
+		float ArrivalTime = 0.0f;
+	};
+
+	FSimulatedLink() {};
+
+	/**
+	*	Send a packet, it arrives after the link's latency unless it's dropped
+	*	@param	Data - The serialized packet
+	*	@param	NumBits - The packet's size in bits
+	*	@param	Time - The time it's sent at
+	*	@param	Settings - The link's conditions
+	*	@param	Stream - The random stream the delays and losses are drawn from
+	*/
+	void Send(const TArray<uint8>& Data, int64 NumBits, float Time, const FReplicationBenchmarkSettings& Settings, FRandomStream& Stream);
+
+	/**
+	*	Take the packets that arrived by a time, in the order they arrived
+	*	@param	Time - The current time
+	*	@param	OutPackets - The packets that arrived
+	*/
+	void Receive(float Time, TArray<FPacket>& OutPackets);
+
+private:
+	TArray<FPacket> InFlight; //Sorted by arrival time
+};
+
+//What a benchmark run measured, over every ship
+struct FReplicationBenchmarkResults
+{
+	TArray<float> PositionErrors; //cm, per sampled frame
+	TArray<float> RotationErrors; //Degrees, per sampled frame
+	TArray<float> DisplayLatencies; //ms, how far behind the true state the displayed one is, per sampled frame
+
+	int64 PayloadBits = 0; //The snapshot packets as serialized
+	int64 AckBits = 0; //The acknowledgements sent back
+	int32 PacketsSent = 0;
+	int32 PacketsDelivered = 0;
+	int32 KeyframesSent = 0;
+	int32 SnapshotsSuppressed = 0;
+	int32 UndecodablePackets = 0; //Deltas whose baseline never arrived
+	int32 FramesMeasured = 0;
+	int32 FramesWithoutSample = 0; //The buffer had nothing to show
+
+	FReplicationBenchmarkResults() {};
+};
+
+/*
+* Headless benchmark of the snapshot replication, run with -run=ShipReplicationBenchmark.
+* Each ship's trajectory is sent the way ANetworkedBuoyantPawn sends an owning client's movement - quantized, suppressed by dead reckoning
+* and delta encoded against acknowledged baselines - through a simulated link, and decoded into a snapshot buffer the way the server does.
+* The buffer is sampled every frame and compared against the trajectory, which gives the bandwidth, the interpolation error and the display latency.
+* Deterministic for a seed, so runs can be compared and the error gated in CI with -MaxP95Error.
+*/
+UCLASS()
+class SAILSOFWAR_API UShipReplicationBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UShipReplicationBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+protected:
+	/**
+	*	Replicate a single ship's trajectory and add what was measured to the results
+	*	@param	Trajectory - The ship's true movement
+	*	@param	Settings - The benchmark settings
+	*	@param	Stream - The random stream the link draws from
+	*	@param	Results - The results to add to
+	*/
+	void RunShip(const FBenchmarkTrajectory& Trajectory, const FReplicationBenchmarkSettings& Settings, FRandomStream& Stream, FReplicationBenchmarkResults& Results) const;
+
+	/**
+	*	Log the results and write them to the report file if there is one
+	*	@param	Results - The results of every ship
+	*	@param	Settings - The benchmark settings
+	*	@return	bool - false if the error exceeded the settings' threshold
+	*/
+	bool ReportResults(FReplicationBenchmarkResults& Results, const FReplicationBenchmarkSettings& Settings) const;
+};
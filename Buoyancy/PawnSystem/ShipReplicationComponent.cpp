@@ -0,0 +1,318 @@
+/*=================================================
+* FileName: ShipReplicationComponent.cpp
+*
+* Created by: Sails of War contributors
+* Project name: Sails of War
+* Unreal Engine version: 4.22
+* Created on: 2026/10/18
+*
+* Last Edited on: 2026/10/18
+* Last Edited by: Sails of War contributors
+*
+* -------------------------------------------------
+* Created for: Sails Of War - http://sailsofwargame.com/
+* -------------------------------------------------
+* For parts referencing UE4 code, the following copyright applies:
+* Copyright 1998-2020 Epic Games, Inc. All Rights Reserved.
+*
+* Feel free to use this software in any commercial/free game.
+* Selling this as a plugin/item, in whole or part, is not allowed.
+* =================================================*/
+//Libary Includes:
+#include "ShipReplicationComponent.h"
+#include "ShipReplicationSubsystem.h"
+#include "NetworkedBuoyantPawn.h"
+
+//Engine Includes:
+#include "GameFramework/PlayerController.h"
+#include "UObject/CoreNet.h"
+
+DECLARE_CYCLE_STAT(TEXT("FlushShipStateBunch"), STAT_FlushShipStateBunch, STATGROUP_PhysicsReplication);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Ship State Bunches Sent"), STAT_ShipStateBunches, STATGROUP_PhysicsReplication);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Ship Snapshots Sent"), STAT_BunchedSnapshots, STATGROUP_PhysicsReplication);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Ship Snapshots Waiting"), STAT_WaitingSnapshots, STATGROUP_PhysicsReplication);
+
+bool FShipStateBunch::NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess)
+{
+	if (Map == nullptr)
+	{
+		bOutSuccess = false;
+		return true;
+	}
+
+	uint32 NumEntries = FMath::Min(Entries.Num(), MaxEntries);
+	Ar.SerializeInt(NumEntries, MaxEntries + 1);
+	if (Ar.IsLoading())
+		Entries.SetNum(NumEntries);
+
+	bOutSuccess = true;
+	for (uint32 EntryIndex = 0; EntryIndex < NumEntries; EntryIndex++)
+	{
+		FShipStateBunchEntry& Entry = Entries[EntryIndex];
+
+		//A ship the client hasn't resolved yet reads as null, its packet is still read so the rest of the bunch stays aligned
+		UObject* Ship = Entry.Ship;
+		Map->SerializeObject(Ar, ANetworkedBuoyantPawn::StaticClass(), Ship);
+		if (Ar.IsLoading())
+			Entry.Ship = Cast<ANetworkedBuoyantPawn>(Ship);
+
+		uint32 RateDivisor = FMath::Clamp<uint32>(Entry.RateDivisor, 1, FShipStateBunchEntry::MaxRateDivisor);
+		Ar.SerializeInt(RateDivisor, FShipStateBunchEntry::MaxRateDivisor + 1);
+		Entry.RateDivisor = uint8(FMath::Max<uint32>(RateDivisor, 1));
+
+		bool bPacketSuccess = true;
+		Entry.Packet.NetSerialize(Ar, Map, bPacketSuccess);
+		bOutSuccess &= bPacketSuccess;
+	}
+
+	return true;
+}
+
+UShipReplicationComponent::UShipReplicationComponent(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = true;
+	PrimaryComponentTick.TickGroup = TG_PostPhysics; //Flush after this frame's snapshots were received and queued
+	bReplicates = true;
+}
+
+void UShipReplicationComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	//Only the server sends bunches, the client's copy receives them and pings the server for the clock
+	UShipReplicationSubsystem* ReplicationSubsystem = UShipReplicationSubsystem::Get(this);
+	if (GetOwnerRole() == ROLE_Authority)
+	{
+		if (ReplicationSubsystem)
+			ReplicationSubsystem->RegisterReceiver(this);
+	}
+	else if (ReplicationSubsystem == nullptr || !ReplicationSubsystem->GetClockSyncSettings().bEnableClockSync)
+		SetComponentTickEnabled(false);
+	else
+		TimeSinceLastPing = ReplicationSubsystem->GetClockSyncSettings().PingInterval; //Ping right away
+}
+
+void UShipReplicationComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	UShipReplicationSubsystem* ReplicationSubsystem = UShipReplicationSubsystem::Get(this);
+	if (ReplicationSubsystem)
+		ReplicationSubsystem->UnregisterReceiver(this);
+
+	Channels.Empty();
+	Super::EndPlay(EndPlayReason);
+}
+
+void UShipReplicationComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	if (GetOwnerRole() == ROLE_Authority)
+		FlushBunch(DeltaTime);
+	else
+		UpdateClockSync(DeltaTime);
+}
+
+APlayerController* UShipReplicationComponent::GetPlayerController() const
+{
+	return Cast<APlayerController>(GetOwner());
+}
+
+void UShipReplicationComponent::QueueSnapshot(ANetworkedBuoyantPawn* Ship, const FQuantizedMovementSnapshot& Snapshot, const FVector& Location, float MotionScale, bool bInInterest)
+{
+	UShipReplicationSubsystem* ReplicationSubsystem = UShipReplicationSubsystem::Get(this);
+	const FShipInterestSettings* Interest = ReplicationSubsystem ? &ReplicationSubsystem->GetSettings().Interest : nullptr;
+	const bool bOutsideInterest = !bInInterest && Interest && Interest->bEnableInterestManagement;
+
+	//The client keeps the last state it got, it resumes from it once the ship is back in interest
+	if (bOutsideInterest && Interest->OutsideInterestRateDivisor <= 0)
+		return;
+
+	FShipReplicationChannel& Channel = Channels.FindOrAdd(Ship);
+
+	//Snapshots can reach the server out of order, one older than the last accepted would replace a newer state in the bunch
+	const int64 ElapsedMs = int64(Snapshot.TimeStampMs) - int64(Channel.LastAcceptedTimeStampMs);
+	if (Channel.bHasAcceptedSnapshot && ElapsedMs <= 0)
+		return;
+
+	const bool bRateScaling = ReplicationSubsystem && ReplicationSubsystem->GetSettings().RateScaling.bEnableRateScaling;
+	if (bRateScaling || bOutsideInterest)
+	{
+		const FPhysicsReplicationSettings& ShipSettings = Ship->GetReplicationSettings();
+		const int64 IntervalMs = 1000 / FMath::Max<uint32>(ShipSettings.SendRate, 1);
+		Channel.RateDivisor = bRateScaling ? GetRateDivisor(Location, MotionScale, ReplicationSubsystem->GetSettings().RateScaling) : 1;
+		if (bOutsideInterest)
+		{
+			//The receivers' jitter buffers have to hold the thinned interval, or they'd only ever dead reckon the ship
+			const int32 MaxOutsideDivisor = FMath::Max(int32(ShipSettings.JitterBuffer.MaxBufferDelay / IntervalMs), 1);
+			const int32 OutsideDivisor = FMath::Clamp(Interest->OutsideInterestRateDivisor, 1, FMath::Min(MaxOutsideDivisor, FShipStateBunchEntry::MaxRateDivisor));
+			Channel.RateDivisor = FMath::Max<uint8>(Channel.RateDivisor, OutsideDivisor);
+		}
+
+		//Skip snapshots until a whole divided interval passed, half a send interval of slack absorbs the timestamps' jitter
+		if (Channel.bHasAcceptedSnapshot && ElapsedMs + IntervalMs / 2 < Channel.RateDivisor * IntervalMs)
+			return;
+	}
+	else
+		Channel.RateDivisor = 1;
+
+	Channel.PendingSnapshot = Snapshot;
+	Channel.bHasPendingSnapshot = true;
+	Channel.LastAcceptedTimeStampMs = Snapshot.TimeStampMs;
+	Channel.bHasAcceptedSnapshot = true;
+}
+
+void UShipReplicationComponent::UpdateInterest(const FShipInterestGrid& Grid, const FShipInterestSettings& Settings)
+{
+	const APlayerController* PlayerController = GetPlayerController();
+	bHasInterestRegion = PlayerController != nullptr;
+	if (!bHasInterestRegion)
+		return;
+
+	FVector ViewLocation;
+	FRotator ViewRotation;
+	PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+
+	//Ships between the two radii keep whichever side they were on
+	const float EnterRadiusSquared = FMath::Square(Settings.InterestRadius);
+	Grid.Query(ViewLocation, Settings.GetExitRadius(), InterestQuery);
+
+	TSet<TWeakObjectPtr<ANetworkedBuoyantPawn>> PreviousInterestSet = MoveTemp(InterestSet);
+	InterestSet.Reset();
+	for (const TPair<ANetworkedBuoyantPawn*, float>& Nearby : InterestQuery)
+	{
+		if (Nearby.Value <= EnterRadiusSquared || PreviousInterestSet.Contains(Nearby.Key))
+			InterestSet.Add(Nearby.Key);
+	}
+}
+
+uint8 UShipReplicationComponent::GetRateDivisor(const FVector& Location, float MotionScale, const FShipRateScalingSettings& Settings) const
+{
+	const APlayerController* PlayerController = GetPlayerController();
+	if (PlayerController == nullptr)
+		return 1;
+
+	FVector ViewLocation;
+	FRotator ViewRotation;
+	PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+
+	const FVector ToShip = Location - ViewLocation;
+	const float Distance = ToShip.Size();
+	const float DistanceScale = 1.0f - FMath::Clamp((Distance - Settings.FullRateDistance) / FMath::Max(Settings.MinRateDistance - Settings.FullRateDistance, 1.0f), 0.0f, 1.0f);
+
+	//A ship the viewer is sitting on is always in view
+	const bool bInView = Distance < KINDA_SMALL_NUMBER || (ToShip / Distance | ViewRotation.Vector()) >= FMath::Cos(FMath::DegreesToRadians(Settings.ViewHalfAngle));
+	const float ViewScale = bInView ? 1.0f : Settings.OutOfViewRateScale;
+
+	const int32 MaxDivisor = FMath::Clamp(Settings.MaxRateDivisor, 1, FShipStateBunchEntry::MaxRateDivisor);
+	const float RateScale = FMath::Clamp(FMath::Max(DistanceScale, MotionScale) * ViewScale, 1.0f / MaxDivisor, 1.0f);
+	return uint8(FMath::Clamp(FMath::FloorToInt(1.0f / RateScale + KINDA_SMALL_NUMBER), 1, MaxDivisor));
+}
+
+void UShipReplicationComponent::FlushBunch(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_FlushShipStateBunch);
+
+	UShipReplicationSubsystem* ReplicationSubsystem = UShipReplicationSubsystem::Get(this);
+	if (ReplicationSubsystem == nullptr)
+		return;
+
+	const FShipReplicationSettings& Settings = ReplicationSubsystem->GetSettings();
+
+	//Waiting snapshots gain priority every tick, so ships that keep losing out are eventually sent
+	TArray<TPair<ANetworkedBuoyantPawn*, FShipReplicationChannel*>, TInlineAllocator<64>> Waiting;
+	for (auto It = Channels.CreateIterator(); It; ++It)
+	{
+		ANetworkedBuoyantPawn* Ship = It.Key().Get();
+		if (Ship == nullptr)
+		{
+			It.RemoveCurrent();
+			continue;
+		}
+
+		FShipReplicationChannel& Channel = It.Value();
+		if (!Channel.bHasPendingSnapshot)
+			continue;
+
+		Channel.Priority += DeltaTime * Ship->NetPriority;
+		Waiting.Emplace(Ship, &Channel);
+	}
+
+	const float FlushInterval = 1.0f / FMath::Max(Settings.FlushRate, 1.0f);
+	TimeSinceLastFlush += DeltaTime;
+	if (TimeSinceLastFlush < FlushInterval || Waiting.Num() == 0)
+		return;
+
+	TimeSinceLastFlush = FMath::Min(TimeSinceLastFlush - FlushInterval, FlushInterval);
+
+	Waiting.Sort([](const TPair<ANetworkedBuoyantPawn*, FShipReplicationChannel*>& A, const TPair<ANetworkedBuoyantPawn*, FShipReplicationChannel*>& B)
+	{
+		return A.Value->Priority > B.Value->Priority;
+	});
+
+	FShipStateBunch Bunch;
+	const int32 NumToSend = FMath::Min(Waiting.Num(), FMath::Clamp(Settings.MaxShipsPerBunch, 1, FShipStateBunch::MaxEntries));
+	Bunch.Entries.Reserve(NumToSend);
+	for (int32 Index = 0; Index < NumToSend; Index++)
+	{
+		ANetworkedBuoyantPawn* Ship = Waiting[Index].Key;
+		FShipReplicationChannel& Channel = *Waiting[Index].Value;
+
+		//There's no per ship acknowledgement, deltas are made against the last keyframe this connection was sent
+		Bunch.Entries.Emplace(Ship, Channel.Encoder.Encode(Channel.PendingSnapshot, Ship->GetReplicationSettings(), false), Channel.RateDivisor);
+		Channel.bHasPendingSnapshot = false;
+		Channel.Priority = 0.0f;
+	}
+
+	ClientReceiveShipStates(Bunch);
+
+	INC_DWORD_STAT(STAT_ShipStateBunches);
+	INC_DWORD_STAT_BY(STAT_BunchedSnapshots, NumToSend);
+	INC_DWORD_STAT_BY(STAT_WaitingSnapshots, Waiting.Num() - NumToSend);
+}
+
+void UShipReplicationComponent::ClientReceiveShipStates_Implementation(const FShipStateBunch& Bunch)
+{
+	for (const FShipStateBunchEntry& Entry : Bunch.Entries)
+	{
+		if (Entry.Ship != nullptr)
+			Entry.Ship->ReceiveReplicatedMovement(Entry.Packet, Entry.RateDivisor);
+	}
+}
+
+void UShipReplicationComponent::UpdateClockSync(float DeltaTime)
+{
+	UShipReplicationSubsystem* ReplicationSubsystem = UShipReplicationSubsystem::Get(this);
+	if (ReplicationSubsystem == nullptr)
+		return;
+
+	//Ping quickly until the estimate has a full window, then just often enough to follow the drift
+	const FClockSyncSettings& ClockSync = ReplicationSubsystem->GetClockSyncSettings();
+	const float PingInterval = ReplicationSubsystem->IsClockConverged() ? ClockSync.PingInterval : ClockSync.FastPingInterval;
+	TimeSinceLastPing += DeltaTime;
+	if (TimeSinceLastPing < PingInterval)
+		return;
+
+	TimeSinceLastPing = 0.0f;
+	ServerClockPing(ReplicationSubsystem->GetLocalClockTime());
+}
+
+bool UShipReplicationComponent::ServerClockPing_Validate(float ClientTime)
+{
+	return FMath::IsFinite(ClientTime);
+}
+
+void UShipReplicationComponent::ServerClockPing_Implementation(float ClientTime)
+{
+	UShipReplicationSubsystem* ReplicationSubsystem = UShipReplicationSubsystem::Get(this);
+	if (ReplicationSubsystem)
+		ClientClockPong(ClientTime, ReplicationSubsystem->GetReplicationTime());
+}
+
+void UShipReplicationComponent::ClientClockPong_Implementation(float ClientTime, float ServerTime)
+{
+	UShipReplicationSubsystem* ReplicationSubsystem = UShipReplicationSubsystem::Get(this);
+	if (ReplicationSubsystem)
+		ReplicationSubsystem->AddClockSample(ClientTime, ServerTime, ReplicationSubsystem->GetLocalClockTime());
+}
@@ -0,0 +1,192 @@
+/*=================================================
+* FileName: ShipReplicationComponent.h
+*
+* Created by: Sails of War contributors
+* Project name: Sails of War
+* Unreal Engine version: 4.22
+* Created on: 2026/10/18
+*
+* Last Edited on: 2026/10/18
+* Last Edited by: Sails of War contributors
+*
+* -------------------------------------------------
+* Created for: Sails Of War - http://sailsofwargame.com/
+* -------------------------------------------------
+* For parts referencing UE4 code, the following copyright applies:
+* Copyright 1998-2020 Epic Games, Inc. All Rights Reserved.
+*
+* Feel free to use this software in any commercial/free game.
+* Selling this as a plugin/item, in whole or part, is not allowed.
+* =================================================*/
+#pragma once
+
+//Libary Includes:
+#include "PhysicsMovementReplication.h"
+
+//Engine Includes:
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "Engine/NetSerialization.h"
+
+#include "ShipReplicationComponent.generated.h"
+
+class ANetworkedBuoyantPawn;
+
+//A single ship's snapshot inside a bunch
+struct FShipStateBunchEntry
+{
+	static const int32 MaxRateDivisor = 15; //The divisor is sent in 4 bits
+
+	ANetworkedBuoyantPawn* Ship = nullptr; //Serialized as a network GUID, only lives as long as the RPC
+	FMovementSnapshotPacket Packet;
+	uint8 RateDivisor = 1; //Only every RateDivisor-th snapshot of the ship is sent to this connection, the receiver widens its buffer interval to match
+
+	FShipStateBunchEntry() {};
+	FShipStateBunchEntry(ANetworkedBuoyantPawn* InShip, const FMovementSnapshotPacket& InPacket, uint8 InRateDivisor) :
+		Ship(InShip), Packet(InPacket), RateDivisor(InRateDivisor) {}
+};
+
+//Every ship snapshot sent to one connection during a flush, sent as a single RPC
+USTRUCT()
+struct FShipStateBunch
+{
+	GENERATED_BODY()
+
+	static const int32 MaxEntries = 255; //The entry count is sent in a byte
+
+	TArray<FShipStateBunchEntry> Entries;
+
+	FShipStateBunch() {};
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FShipStateBunch> : public TStructOpsTypeTraitsBase2<FShipStateBunch>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
+
+//The server's state for replicating one ship to one connection
+struct FShipReplicationChannel
+{
+	FSnapshotDeltaEncoder Encoder; //Deltas against the last keyframe sent to this connection
+	FQuantizedMovementSnapshot PendingSnapshot; //The newest snapshot not yet sent, older unsent ones are replaced
+	bool bHasPendingSnapshot = false;
+	float Priority = 0.0f; //Accumulates while a snapshot waits, the highest are sent first
+	uint8 RateDivisor = 1; //Every how many snapshots of the ship are forwarded to this connection
+	uint32 LastAcceptedTimeStampMs = 0; //The timestamp of the last snapshot accepted for sending
+	bool bHasAcceptedSnapshot = false;
+
+	FShipReplicationChannel() {};
+};
+
+/*
+* Lives on every remote PlayerController on the server, and its replicated copy on the owning client.
+* The server queues the snapshots of every ship the connection simulates, and flushes them as a single bunch at the subsystem's flush rate.
+* When more ships are waiting than a bunch may carry, the ones that waited longest, scaled by their NetPriority, go first.
+* The client's copy pings the server through it to synchronize the replication clock.
+* See UShipReplicationSubsystem.
+*/
+UCLASS(ClassGroup = (Custom))
+class SAILSOFWAR_API UShipReplicationComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UShipReplicationComponent(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
+
+	/**
+	*	Queue a ship's newest snapshot for this connection, replacing one still waiting.
+	*	Snapshots are thinned to a rate picked from the ship's distance to the viewer, whether it's in view and how it's moving.
+	*	@param	Ship - The ship the snapshot belongs to
+	*	@param	Snapshot - The quantized snapshot
+	*	@param	Location - The snapshot's location
+	*	@param	MotionScale - The rate scale the ship's speed, acceleration and turn rate ask for
+	*	@param	bInInterest - Whether the ship is in the connection's interest region, ships outside it are sent at the interest settings' reduced rate
+	*/
+	void QueueSnapshot(ANetworkedBuoyantPawn* Ship, const FQuantizedMovementSnapshot& Snapshot, const FVector& Location, float MotionScale, bool bInInterest);
+
+	/**
+	*	Find the ships in the viewer's interest region, ships enter it within InterestRadius and only leave it past the hysteresis distance
+	*	@param	Grid - Every forwarded ship by location
+	*	@param	Settings - The interest settings
+	*/
+	void UpdateInterest(const struct FShipInterestGrid& Grid, const struct FShipInterestSettings& Settings);
+
+	/**
+	*	Returns true if the ship is in the connection's interest region, or if the connection has no viewer to have one
+	*/
+	bool IsInInterest(ANetworkedBuoyantPawn* Ship) const { return !bHasInterestRegion || InterestSet.Contains(Ship); }
+
+	int32 GetNumShipsInInterest() const { return InterestSet.Num(); }
+
+	/**
+	*	Returns the PlayerController the component replicates ships to
+	*/
+	class APlayerController* GetPlayerController() const;
+
+protected:
+	/**
+	*	Pick every how many snapshots of a ship this connection should receive
+	*	@param	Location - The ship's location
+	*	@param	MotionScale - The rate scale the ship's motion asks for
+	*	@param	Settings - The rate scaling settings
+	*	@return	uint8 - the rate divisor, 1 for the full rate
+	*/
+	uint8 GetRateDivisor(const FVector& Location, float MotionScale, const struct FShipRateScalingSettings& Settings) const;
+
+	/**
+	*	Send the highest priority waiting snapshots as one bunch
+	*	@param	DeltaTime - The time since the last tick, waiting snapshots gain priority by it
+	*/
+	void FlushBunch(float DeltaTime);
+
+	/**
+	*	Hand every snapshot of a bunch to its ship
+	*	@param	Bunch - The ship snapshots sent by the server
+	*/
+	UFUNCTION(Client, Unreliable)
+	void ClientReceiveShipStates(const FShipStateBunch& Bunch);
+
+	/**
+	*	Ping the server at the clock sync's interval
+	*	@param	DeltaTime - The time since the last tick
+	*/
+	void UpdateClockSync(float DeltaTime);
+
+	/**
+	*	Answer a client's ping with the server's replication time
+	*	@param	ClientTime - The client's local clock time when it sent the ping, echoed back
+	*/
+	UFUNCTION(Server, Unreliable, WithValidation)
+	void ServerClockPing(float ClientTime);
+
+	/**
+	*	Add the server's answer to the client's clock estimate
+	*	@param	ClientTime - The client's local clock time when it sent the ping
+	*	@param	ServerTime - The server's replication time when it answered
+	*/
+	UFUNCTION(Client, Unreliable)
+	void ClientClockPong(float ClientTime, float ServerTime);
+
+	float TimeSinceLastPing = 0.0f;
+
+	TMap<TWeakObjectPtr<ANetworkedBuoyantPawn>, FShipReplicationChannel> Channels; //Every ship replicated to this connection
+
+	TSet<TWeakObjectPtr<ANetworkedBuoyantPawn>> InterestSet; //The ships in the viewer's interest region
+	bool bHasInterestRegion = false; //False until the first UpdateInterest() with a viewer, every ship counts as in interest until then
+
+	TArray<TPair<ANetworkedBuoyantPawn*, float>> InterestQuery; //Reused by UpdateInterest()
+
+	float TimeSinceLastFlush = 0.0f;
+
+/*UActorComponent Overrides*/
+public:
+	virtual void BeginPlay() override; //Overridden to register with the ship replication subsystem on the server
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override; //Overridden to unregister from the ship replication subsystem
+	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction) override; //Overridden to flush the waiting snapshots, or ping the server on the client
+};
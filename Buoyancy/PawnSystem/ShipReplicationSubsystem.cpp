@@ -0,0 +1,489 @@
+/*=================================================
+* FileName: ShipReplicationSubsystem.cpp
+*
+* Created by: Sails of War contributors
+* Project name: Sails of War
+* Unreal Engine version: 4.22
+* Created on: 2026/10/18
+*
+* Last Edited on: 2026/10/18
+* Last Edited by: Sails of War contributors
+*
+* -------------------------------------------------
+* Created for: Sails Of War - http://sailsofwargame.com/
+* -------------------------------------------------
+* For parts referencing UE4 code, the following copyright applies:
+* Copyright 1998-2020 Epic Games, Inc. All Rights Reserved.
+*
+* Feel free to use this software in any commercial/free game.
+* Selling this as a plugin/item, in whole or part, is not allowed.
+* =================================================*/
+//Libary Includes:
+#include "ShipReplicationSubsystem.h"
+#include "ShipReplicationComponent.h"
+#include "NetworkedBuoyantPawn.h"
+
+//IMPORT_TASK: Change to Engine variants
+//Project Includes:
+#include "SOWGameState.h"
+
+//Engine Includes:
+#include "Engine/World.h"
+#include "Engine/Engine.h"
+#include "GameFramework/PlayerController.h"
+#include "Async/ParallelFor.h"
+#include "Misc/Paths.h"
+#include "Misc/DateTime.h"
+
+DECLARE_CYCLE_STAT(TEXT("UpdateShipInterest"), STAT_UpdateShipInterest, STATGROUP_PhysicsReplication);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Ships In Interest"), STAT_ShipsInInterest, STATGROUP_PhysicsReplication);
+DECLARE_CYCLE_STAT(TEXT("InterpolateServerProxies"), STAT_InterpolateServerProxies, STATGROUP_PhysicsReplication);
+DECLARE_CYCLE_STAT(TEXT("ServerProxyGather"), STAT_ServerProxyGather, STATGROUP_PhysicsReplication);
+DECLARE_CYCLE_STAT(TEXT("ServerProxyInterpolate"), STAT_ServerProxyInterpolate, STATGROUP_PhysicsReplication);
+DECLARE_CYCLE_STAT(TEXT("ServerProxyApply"), STAT_ServerProxyApply, STATGROUP_PhysicsReplication);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Interpolated Server Proxies"), STAT_InterpolatedServerProxies, STATGROUP_PhysicsReplication);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Clock Round Trip (ms)"), STAT_ClockRoundTrip, STATGROUP_PhysicsReplication);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Clock Offset (ms)"), STAT_ClockOffset, STATGROUP_PhysicsReplication);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Clock Skew (ppm)"), STAT_ClockSkew, STATGROUP_PhysicsReplication);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Adaptive Buffers"), STAT_AdaptiveBuffers, STATGROUP_PhysicsReplication);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Mean Buffer Delay (ms)"), STAT_MeanBufferDelay, STATGROUP_PhysicsReplication);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Max Buffer Delay (ms)"), STAT_MaxBufferDelay, STATGROUP_PhysicsReplication);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Max Target Delay (ms)"), STAT_MaxTargetDelay, STATGROUP_PhysicsReplication);
+
+void FShipInterestGrid::Reset(float InCellSize)
+{
+	//Keep the cells' memory, the same ones are mostly refilled next frame
+	for (auto& Cell : Cells)
+	{
+		Cell.Value.Reset();
+	}
+	if (CellSize != InCellSize)
+		Cells.Reset();
+
+	CellSize = FMath::Max(InCellSize, 1.0f);
+	NumShips = 0;
+}
+
+void FShipInterestGrid::Add(ANetworkedBuoyantPawn* Ship, const FVector& Location)
+{
+	Cells.FindOrAdd(GetCell(Location)).Emplace(Ship, Location);
+	NumShips++;
+}
+
+void FShipInterestGrid::Query(const FVector& Center, float Radius, TArray<TPair<ANetworkedBuoyantPawn*, float>>& OutShips) const
+{
+	OutShips.Reset();
+
+	const FIntPoint MinCell = GetCell(Center - FVector(Radius, Radius, 0.0f));
+	const FIntPoint MaxCell = GetCell(Center + FVector(Radius, Radius, 0.0f));
+	const float RadiusSquared = FMath::Square(Radius);
+	for (int32 CellX = MinCell.X; CellX <= MaxCell.X; CellX++)
+	{
+		for (int32 CellY = MinCell.Y; CellY <= MaxCell.Y; CellY++)
+		{
+			const TArray<FEntry, TInlineAllocator<4>>* Cell = Cells.Find(FIntPoint(CellX, CellY));
+			if (Cell == nullptr)
+				continue;
+
+			for (const FEntry& Entry : *Cell)
+			{
+				const float DistanceSquared = FVector::DistSquared2D(Entry.Location, Center);
+				if (DistanceSquared <= RadiusSquared)
+					OutShips.Emplace(Entry.Ship, DistanceSquared);
+			}
+		}
+	}
+}
+
+void FServerProxyInterpolationBatch::Reset()
+{
+	Ships.Reset();
+	FromLocations.Reset();
+	FromLinearVelocities.Reset();
+	FromAngularVelocities.Reset();
+	FromRotations.Reset();
+	ToLocations.Reset();
+	ToLinearVelocities.Reset();
+	ToAngularVelocities.Reset();
+	ToRotations.Reset();
+	Intervals.Reset();
+	Alphas.Reset();
+	OutLocations.Reset();
+	OutRotations.Reset();
+	OutLinearVelocities.Reset();
+	OutAngularVelocities.Reset();
+}
+
+void FServerProxyInterpolationBatch::Add(ANetworkedBuoyantPawn* Ship, const FMovementSnapshot& From, const FMovementSnapshot* To, float Alpha)
+{
+	//Snapshots too close together to blend play out the newer one like FMovementSnapshot::Interpolate(), dead reckoned by nothing
+	if (To != nullptr && To->TimeStamp - From.TimeStamp <= KINDA_SMALL_NUMBER)
+	{
+		Add(Ship, *To, nullptr, 0.0f);
+		return;
+	}
+
+	const FMovementSnapshot& Target = To ? *To : From;
+	Ships.Add(Ship);
+	FromLocations.Add(From.Location);
+	FromLinearVelocities.Add(From.LinearVelocity);
+	FromAngularVelocities.Add(From.AngularVelocity);
+	FromRotations.Add(From.Rotation);
+	ToLocations.Add(Target.Location);
+	ToLinearVelocities.Add(Target.LinearVelocity);
+	ToAngularVelocities.Add(Target.AngularVelocity);
+	ToRotations.Add(Target.Rotation);
+	Intervals.Add(To ? To->TimeStamp - From.TimeStamp : 0.0f);
+	Alphas.Add(Alpha);
+}
+
+void FServerProxyInterpolationBatch::Interpolate(int32 Index)
+{
+	const float Interval = Intervals[Index];
+	const float Alpha = Alphas[Index];
+
+	//Dead reckoning, matches FMovementSnapshot::Extrapolate() - Add() only leaves a zero interval for it
+	if (Interval <= 0.0f)
+	{
+		OutLocations[Index] = FromLocations[Index] + FromLinearVelocities[Index] * Alpha;
+		OutRotations[Index] = FMovementSnapshot::IntegrateRotation(FromRotations[Index], FromAngularVelocities[Index], Alpha);
+		OutLinearVelocities[Index] = FromLinearVelocities[Index];
+		OutAngularVelocities[Index] = FromAngularVelocities[Index];
+		return;
+	}
+
+	//Matches FMovementSnapshot::Interpolate()
+	FMovementSnapshot::InterpolateLocation(FromLocations[Index], FromLinearVelocities[Index], ToLocations[Index], ToLinearVelocities[Index], Interval, Alpha, OutLocations[Index], OutLinearVelocities[Index]);
+	OutRotations[Index] = FMovementSnapshot::InterpolateRotation(FromRotations[Index], FromAngularVelocities[Index], ToRotations[Index], ToAngularVelocities[Index], Interval, Alpha);
+	OutAngularVelocities[Index] = FMath::Lerp(FromAngularVelocities[Index], ToAngularVelocities[Index], Alpha);
+}
+
+void UShipReplicationSubsystem::Deinitialize()
+{
+	Receivers.Empty();
+	ShipMotion.Empty();
+	InterestGrid.Reset(Settings.Interest.GetExitRadius());
+	ServerProxies.Empty();
+	InterpolationBatch.Reset();
+	ReplayWriter.Close();
+	ReplayShipIds.Empty();
+	Super::Deinitialize();
+}
+
+UShipReplicationSubsystem* UShipReplicationSubsystem::Get(const UObject* WorldContextObject)
+{
+	UWorld* World = GEngine ? GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::ReturnNull) : nullptr;
+	return World ? World->GetSubsystem<UShipReplicationSubsystem>() : nullptr;
+}
+
+void UShipReplicationSubsystem::RegisterReceiver(UShipReplicationComponent* Component)
+{
+	if (Component != nullptr)
+		Receivers.AddUnique(Component);
+}
+
+void UShipReplicationSubsystem::UnregisterReceiver(UShipReplicationComponent* Component)
+{
+	Receivers.Remove(Component);
+}
+
+void UShipReplicationSubsystem::UpdateReceivers()
+{
+	if (ReceiversUpdatedFrame == GFrameCounter)
+		return;
+
+	ReceiversUpdatedFrame = GFrameCounter;
+
+	for (auto It = ShipMotion.CreateIterator(); It; ++It)
+	{
+		if (!It.Key().IsValid())
+			It.RemoveCurrent();
+	}
+
+	for (FConstPlayerControllerIterator Iterator = GetWorld()->GetPlayerControllerIterator(); Iterator; ++Iterator)
+	{
+		APlayerController* PlayerController = Iterator->Get();
+
+		//A listen server's own controller sees the server's ships directly
+		if (PlayerController == nullptr || PlayerController->IsLocalController() || PlayerController->FindComponentByClass<UShipReplicationComponent>() != nullptr)
+			continue;
+
+		//Registers itself on BeginPlay, and replicates to the owning client so it can receive the bunches
+		UShipReplicationComponent* Component = NewObject<UShipReplicationComponent>(PlayerController, TEXT("ShipReplicationComponent"));
+		Component->RegisterComponent();
+	}
+}
+
+void UShipReplicationSubsystem::QueueSnapshot(ANetworkedBuoyantPawn* Ship, const FQuantizedMovementSnapshot& Snapshot)
+{
+	if (Ship == nullptr)
+		return;
+
+	UpdateReceivers();
+	UpdateInterest();
+
+	const FMovementSnapshot State = Snapshot.Dequantize();
+	const float MotionScale = UpdateShipMotion(Ship, State);
+
+	const AController* OwningController = Ship->GetController();
+	for (UShipReplicationComponent* Receiver : Receivers)
+	{
+		if (Receiver != nullptr && Receiver->GetPlayerController() != OwningController)
+			Receiver->QueueSnapshot(Ship, Snapshot, State.Location, MotionScale, Receiver->IsInInterest(Ship));
+	}
+}
+
+void UShipReplicationSubsystem::UpdateInterest()
+{
+	const FShipInterestSettings& Interest = Settings.Interest;
+	if (!Interest.bEnableInterestManagement || InterestUpdatedFrame == GFrameCounter)
+		return;
+
+	SCOPE_CYCLE_COUNTER(STAT_UpdateShipInterest);
+	InterestUpdatedFrame = GFrameCounter;
+
+	//UpdateReceivers() already dropped the destroyed ships
+	InterestGrid.Reset(Interest.GetExitRadius());
+	for (const auto& Motion : ShipMotion)
+	{
+		ANetworkedBuoyantPawn* Ship = Motion.Key.Get();
+		if (Ship != nullptr)
+			InterestGrid.Add(Ship, Ship->GetActorLocation());
+	}
+
+	for (UShipReplicationComponent* Receiver : Receivers)
+	{
+		if (Receiver != nullptr)
+		{
+			Receiver->UpdateInterest(InterestGrid, Interest);
+			INC_DWORD_STAT_BY(STAT_ShipsInInterest, Receiver->GetNumShipsInInterest());
+		}
+	}
+}
+
+void UShipReplicationSubsystem::RecordSnapshot(ANetworkedBuoyantPawn* Ship, const FQuantizedMovementSnapshot& Snapshot)
+{
+	if (!Replay.bEnableRecording || Ship == nullptr)
+		return;
+
+	if (!ReplayWriter.IsOpen())
+	{
+		ReplayPath = FPaths::ProjectSavedDir() / TEXT("Replays") / FString::Printf(TEXT("%s_%s.sowreplay"), *Replay.FilePrefix, *FDateTime::Now().ToString());
+		if (!ReplayWriter.Open(ReplayPath, Replay))
+		{
+			//Don't retry every snapshot
+			UE_LOG(LogTemp, Warning, TEXT("Couldn't open the ship replay %s, recording is disabled"), *ReplayPath);
+			Replay.bEnableRecording = false;
+			ReplayPath.Empty();
+			return;
+		}
+	}
+
+	uint32* ShipId = ReplayShipIds.Find(Ship);
+	if (ShipId == nullptr)
+		ShipId = &ReplayShipIds.Add(Ship, NextReplayShipId++);
+
+	ReplayWriter.Record(*ShipId, Ship->GetName(), Snapshot);
+}
+
+float UShipReplicationSubsystem::UpdateShipMotion(ANetworkedBuoyantPawn* Ship, const FMovementSnapshot& Snapshot)
+{
+	const FShipRateScalingSettings& RateScaling = Settings.RateScaling;
+	FShipMotionState& Motion = ShipMotion.FindOrAdd(Ship);
+
+	//Acceleration is only known from the change between snapshots, late ones are ignored
+	const float DeltaTime = Snapshot.TimeStamp - Motion.LastTimeStamp;
+	if (Motion.LastTimeStamp >= 0.0f && DeltaTime > KINDA_SMALL_NUMBER)
+	{
+		const float Acceleration = (Snapshot.LinearVelocity - Motion.LastVelocity).Size() / DeltaTime;
+		Motion.Acceleration = FMath::Lerp(Motion.Acceleration, Acceleration, RateScaling.AccelerationSmoothing);
+	}
+
+	if (DeltaTime > 0.0f || Motion.LastTimeStamp < 0.0f)
+	{
+		Motion.LastVelocity = Snapshot.LinearVelocity;
+		Motion.LastTimeStamp = Snapshot.TimeStamp;
+	}
+
+	const float SpeedScale = RateScaling.SpeedForFullRate > 0.0f ? Snapshot.LinearVelocity.Size() / RateScaling.SpeedForFullRate : 0.0f;
+	const float AccelerationScale = RateScaling.AccelerationForFullRate > 0.0f ? Motion.Acceleration / RateScaling.AccelerationForFullRate : 0.0f;
+	const float TurnScale = RateScaling.TurnRateForFullRate > 0.0f ? Snapshot.AngularVelocity.Size() / RateScaling.TurnRateForFullRate : 0.0f;
+	Motion.MotionScale = FMath::Clamp(FMath::Max3(SpeedScale, AccelerationScale, TurnScale), 0.0f, 1.0f);
+	return Motion.MotionScale;
+}
+
+bool UShipReplicationSubsystem::IsServerProxy(const ANetworkedBuoyantPawn* Ship)
+{
+	return Ship != nullptr && Ship->Role == ROLE_Authority && !Ship->IsLocallyControlled() && !Ship->IsServerOwned();
+}
+
+bool UShipReplicationSubsystem::RequestServerInterpolation(ANetworkedBuoyantPawn* Ship)
+{
+	if (!bBatchServerInterpolation || !IsServerProxy(Ship))
+		return false;
+
+	//A ship joining after this frame's pass interpolates itself once, and is part of the batch from the next frame on
+	uint64* RequestedFrame = ServerProxies.Find(Ship);
+	if (RequestedFrame == nullptr)
+	{
+		ServerProxies.Add(Ship, GFrameCounter);
+		if (InterpolatedFrame == GFrameCounter)
+			return false;
+	}
+	else
+		*RequestedFrame = GFrameCounter;
+
+	if (InterpolatedFrame != GFrameCounter)
+	{
+		InterpolatedFrame = GFrameCounter;
+		InterpolateServerProxies(GetReplicationTime());
+	}
+
+	return true;
+}
+
+void UShipReplicationSubsystem::InterpolateServerProxies(float Time)
+{
+	SCOPE_CYCLE_COUNTER(STAT_InterpolateServerProxies);
+
+	InterpolationBatch.Reset();
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_ServerProxyGather);
+		for (auto It = ServerProxies.CreateIterator(); It; ++It)
+		{
+			//Destroyed, possessed locally, released to the server's simulation or no longer requesting, e.g. its tick was disabled.
+			//The pass runs on the frame's first request, so ships that haven't requested yet this frame did last frame.
+			ANetworkedBuoyantPawn* Ship = It.Key().Get();
+			if (!IsServerProxy(Ship) || It.Value() + 1 < GFrameCounter)
+			{
+				It.RemoveCurrent();
+				continue;
+			}
+
+			const FMovementSnapShotBuffer& SnapShotBuffer = Ship->GetServerSnapshotBuffer();
+			int32 FromIndex, ToIndex;
+			float Alpha;
+			if (SnapShotBuffer.HasElapsedMinTime(Time) && SnapShotBuffer.GetSampleIndices(Time, FromIndex, ToIndex, Alpha))
+				InterpolationBatch.Add(Ship, SnapShotBuffer[FromIndex], ToIndex != INDEX_NONE ? &SnapShotBuffer[ToIndex] : nullptr, Alpha);
+		}
+	}
+
+	const int32 NumShips = InterpolationBatch.Num();
+	INC_DWORD_STAT_BY(STAT_InterpolatedServerProxies, NumShips);
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_ServerProxyInterpolate);
+		InterpolationBatch.OutLocations.SetNumUninitialized(NumShips);
+		InterpolationBatch.OutRotations.SetNumUninitialized(NumShips);
+		InterpolationBatch.OutLinearVelocities.SetNumUninitialized(NumShips);
+		InterpolationBatch.OutAngularVelocities.SetNumUninitialized(NumShips);
+
+		FServerProxyInterpolationBatch* Batch = &InterpolationBatch;
+		ParallelFor(NumShips, [Batch](int32 Index)
+		{
+			Batch->Interpolate(Index);
+		}, !bInterpolateInParallel || NumShips < MinParallelInterpolationBatch);
+	}
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_ServerProxyApply);
+		const float DeltaTime = GetWorld()->GetDeltaSeconds();
+		for (int32 Index = 0; Index < NumShips; Index++)
+		{
+			InterpolationBatch.Ships[Index]->ApplyMovementState(InterpolationBatch.OutLocations[Index], InterpolationBatch.OutRotations[Index],
+				InterpolationBatch.OutLinearVelocities[Index], InterpolationBatch.OutAngularVelocities[Index], DeltaTime);
+		}
+
+		//Every buffer is updated, including ones that had nothing to sample yet
+		for (const auto& Proxy : ServerProxies)
+		{
+			FMovementSnapShotBuffer& SnapShotBuffer = Proxy.Key->GetServerSnapshotBuffer();
+			SnapShotBuffer.Update(Time);
+			ReportBufferDelay(SnapShotBuffer);
+		}
+	}
+}
+
+float UShipReplicationSubsystem::GetLocalClockTime() const
+{
+	//Real time keeps running through pauses and time dilation, so the clocks only differ by their offset and drift
+	return GetWorld()->GetRealTimeSeconds();
+}
+
+float UShipReplicationSubsystem::GetReplicationTime()
+{
+	UWorld* World = GetWorld();
+	if (ClockSync.bEnableClockSync)
+	{
+		//The server's clock is the reference, its connections need their component to ping through before any ship replicates
+		if (World->GetNetMode() < NM_Client)
+		{
+			UpdateReceivers();
+			return GetLocalClockTime();
+		}
+
+		if (Clock.HasSamples())
+			return Clock.GetTime(GetLocalClockTime(), ClockSync);
+	}
+
+	//IMPORT_TASK: Change to AGameState instead
+	ASOWGameState* SOWGS = World->GetGameState<ASOWGameState>();
+	return SOWGS ? SOWGS->GetServerWorldTimeSeconds() : World->GetTimeSeconds();
+}
+
+bool UShipReplicationSubsystem::HasReplicationTime() const
+{
+	return !ClockSync.bEnableClockSync || GetWorld()->GetNetMode() < NM_Client || Clock.IsConverged(ClockSync);
+}
+
+void UShipReplicationSubsystem::ReportBufferDelay(const FMovementSnapShotBuffer& Buffer)
+{
+	check(IsInGameThread());
+	if (BufferStatsFrame != GFrameCounter)
+	{
+		//A frame without reports keeps the last view delay, the buffers didn't go anywhere
+		if (NumBuffers > 0)
+		{
+			ViewDelay = TotalBufferDelay / NumBuffers;
+			SET_FLOAT_STAT(STAT_MeanBufferDelay, ViewDelay);
+		}
+
+#if STATS
+		if (NumAdaptiveBuffers > 0)
+		{
+			SET_DWORD_STAT(STAT_AdaptiveBuffers, NumAdaptiveBuffers);
+			SET_FLOAT_STAT(STAT_MaxBufferDelay, MaxBufferDelay);
+			SET_FLOAT_STAT(STAT_MaxTargetDelay, MaxTargetDelay);
+		}
+#endif
+
+		BufferStatsFrame = GFrameCounter;
+		NumBuffers = 0;
+		TotalBufferDelay = 0.0f;
+		NumAdaptiveBuffers = 0;
+		MaxBufferDelay = 0.0f;
+		MaxTargetDelay = 0.0f;
+	}
+
+	NumBuffers++;
+	TotalBufferDelay += Buffer.BufferDelay;
+
+#if STATS
+	if (!Buffer.JitterSettings.bAdaptiveDelay)
+		return;
+
+	NumAdaptiveBuffers++;
+	MaxBufferDelay = FMath::Max(MaxBufferDelay, Buffer.BufferDelay);
+	MaxTargetDelay = FMath::Max(MaxTargetDelay, Buffer.JitterStats.TargetDelay);
+#endif
+}
+
+void UShipReplicationSubsystem::AddClockSample(float LocalSendTime, float ServerTime, float LocalReceiveTime)
+{
+	Clock.AddSample(LocalSendTime, ServerTime, LocalReceiveTime, ClockSync);
+
+	SET_FLOAT_STAT(STAT_ClockRoundTrip, Clock.GetRoundTripTime() * 1000.0f);
+	SET_FLOAT_STAT(STAT_ClockOffset, Clock.GetOffset() * 1000.0f);
+	SET_FLOAT_STAT(STAT_ClockSkew, Clock.GetSkew() * 1000000.0f);
+}
@@ -0,0 +1,447 @@
+/*=================================================
+* FileName: ShipReplicationSubsystem.h
+*
+* Created by: Sails of War contributors
+* Project name: Sails of War
+* Unreal Engine version: 4.22
+* Created on: 2026/10/18
+*
+* Last Edited on: 2026/10/18
+* Last Edited by: Sails of War contributors
+*
+* -------------------------------------------------
+* Created for: Sails Of War - http://sailsofwargame.com/
+* -------------------------------------------------
+* For parts referencing UE4 code, the following copyright applies:
+* Copyright 1998-2020 Epic Games, Inc. All Rights Reserved.
+*
+* Feel free to use this software in any commercial/free game.
+* Selling this as a plugin/item, in whole or part, is not allowed.
+* =================================================*/
+#pragma once
+
+//Libary Includes:
+#include "PhysicsMovementReplication.h"
+#include "ReplicatedClock.h"
+#include "ShipReplay.h"
+
+//Engine Includes:
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "ShipReplicationSubsystem.generated.h"
+
+class ANetworkedBuoyantPawn;
+class UShipReplicationComponent;
+
+//Settings for scaling the rate each connection receives a ship's snapshots at, the rate is the ship's SendRate divided by a whole number
+USTRUCT(BlueprintType)
+struct FShipRateScalingSettings
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere)
+		bool bEnableRateScaling = true; //Disable to send every snapshot to every connection
+
+	UPROPERTY(EditAnywhere, meta = (EditCondition = "bEnableRateScaling", ClampMin = "1", ClampMax = "15"))
+		int32 MaxRateDivisor = 8; //The lowest rate is the ship's SendRate divided by this
+
+	UPROPERTY(EditAnywhere, meta = (EditCondition = "bEnableRateScaling"))
+		float FullRateDistance = 10000.0f; //Ships closer than this to the viewer are sent at their full rate
+
+	UPROPERTY(EditAnywhere, meta = (EditCondition = "bEnableRateScaling"))
+		float MinRateDistance = 100000.0f; //Ships farther than this are sent at the lowest rate, unless they're maneuvering
+
+	UPROPERTY(EditAnywhere, meta = (EditCondition = "bEnableRateScaling", ClampMin = "0.0", ClampMax = "90.0"))
+		float ViewHalfAngle = 60.0f; //Degrees from the viewer's view direction a ship counts as in view
+
+	UPROPERTY(EditAnywhere, meta = (EditCondition = "bEnableRateScaling", ClampMin = "0.0", ClampMax = "1.0"))
+		float OutOfViewRateScale = 0.5f; //Rate scale applied to ships outside the view
+
+	UPROPERTY(EditAnywhere, meta = (EditCondition = "bEnableRateScaling"))
+		float SpeedForFullRate = 2000.0f; //cm/s, ships this fast keep their full rate at any distance
+
+	UPROPERTY(EditAnywhere, meta = (EditCondition = "bEnableRateScaling"))
+		float AccelerationForFullRate = 300.0f; //cm/s^2, ships accelerating this hard keep their full rate at any distance
+
+	UPROPERTY(EditAnywhere, meta = (EditCondition = "bEnableRateScaling"))
+		float TurnRateForFullRate = 10.0f; //deg/s, ships turning this fast keep their full rate at any distance
+
+	UPROPERTY(EditAnywhere, meta = (EditCondition = "bEnableRateScaling", ClampMin = "0.0", ClampMax = "1.0"))
+		float AccelerationSmoothing = 0.3f; //Weight of the newest acceleration sample, lower values remember maneuvers longer
+
+	FShipRateScalingSettings() {};
+};
+
+//Settings for the spatial interest of each connection, ships outside a viewer's interest region are forwarded at a strongly reduced rate or not at all
+USTRUCT(BlueprintType)
+struct FShipInterestSettings
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere)
+		bool bEnableInterestManagement = true; //Disable to forward every ship to every connection at its scaled rate
+
+	UPROPERTY(EditAnywhere, meta = (EditCondition = "bEnableInterestManagement", ClampMin = "1000.0"))
+		float InterestRadius = 150000.0f; //cm, ships closer than this to the viewer enter its interest
+
+	UPROPERTY(EditAnywhere, meta = (EditCondition = "bEnableInterestManagement", ClampMin = "0.0"))
+		float HysteresisDistance = 20000.0f; //cm, ships only leave the interest once they're this much further than InterestRadius, so ships on the edge don't pop in and out
+
+	UPROPERTY(EditAnywhere, meta = (EditCondition = "bEnableInterestManagement", ClampMin = "0", ClampMax = "15"))
+		int32 OutsideInterestRateDivisor = 8; //Ships outside the interest are sent at their SendRate divided by this, 0 stops forwarding them entirely - capped so the interval fits in the ship's MaxBufferDelay
+
+	FShipInterestSettings() {};
+
+	/* Ships further than this are outside the interest whatever their history, also the grid's cell size so a query covers at most 3x3 cells */
+	float GetExitRadius() const { return InterestRadius + HysteresisDistance; }
+};
+
+//Settings for batching ship snapshots per connection
+USTRUCT(BlueprintType)
+struct FShipReplicationSettings
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, meta = (ClampMin = "1"))
+		float FlushRate = 30.0f; //Bunches sent to each connection per second
+
+	UPROPERTY(EditAnywhere, meta = (ClampMin = "1", ClampMax = "255"))
+		int32 MaxShipsPerBunch = 32; //Snapshots a single bunch may carry, the rest wait for the next flush with a higher priority
+
+	UPROPERTY(EditAnywhere)
+		FShipRateScalingSettings RateScaling; //How each connection thins the snapshots of ships that matter less to it
+
+	UPROPERTY(EditAnywhere)
+		FShipInterestSettings Interest; //Which ships each connection gets at their full scaled rate
+
+	FShipReplicationSettings() {};
+};
+
+//The motion of a ship used to decide how often it's replicated, tracked from the snapshots it sends
+struct FShipMotionState
+{
+	FVector LastVelocity = FVector::ZeroVector;
+	float LastTimeStamp = -1.0f;
+	float Acceleration = 0.0f; //Smoothed linear acceleration in cm/s^2
+	float MotionScale = 0.0f; //The rate scale the ship's motion asks for, see FShipRateScalingSettings
+
+	FShipMotionState() {};
+};
+
+/*
+* A spatial hash of every forwarded ship's location on the horizontal plane, rebuilt once per frame.
+* Each connection queries the cells around its viewer, so finding the ships near it costs the number of nearby ships rather than every ship in the world.
+*/
+struct FShipInterestGrid
+{
+	struct FEntry
+	{
+		ANetworkedBuoyantPawn* Ship = nullptr;
+		FVector Location = FVector::ZeroVector;
+
+		FEntry() {};
+		FEntry(ANetworkedBuoyantPawn* InShip, const FVector& InLocation) : Ship(InShip), Location(InLocation) {}
+	};
+
+	FShipInterestGrid() {};
+
+	/**
+	*	Empty the grid
+	*	@param	InCellSize - The cell size in cm for the ships added next
+	*/
+	void Reset(float InCellSize);
+
+	/**
+	*	Add a ship to the cell its location falls in
+	*	@param	Ship - The ship
+	*	@param	Location - The ship's location
+	*/
+	void Add(ANetworkedBuoyantPawn* Ship, const FVector& Location);
+
+	/**
+	*	Find every ship within a horizontal radius
+	*	@param	Center - The center of the query
+	*	@param	Radius - The radius in cm
+	*	@param	OutShips - The ships found and their squared horizontal distance to the center
+	*/
+	void Query(const FVector& Center, float Radius, TArray<TPair<ANetworkedBuoyantPawn*, float>>& OutShips) const;
+
+	int32 Num() const { return NumShips; }
+
+private:
+	FIntPoint GetCell(const FVector& Location) const { return FIntPoint(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize)); }
+
+	TMap<FIntPoint, TArray<FEntry, TInlineAllocator<4>>> Cells;
+	float CellSize = 150000.0f;
+	int32 NumShips = 0;
+};
+
+/*
+* The server's interpolation inputs and results for every client owned ship this frame, stored as parallel arrays so the pass runs over contiguous memory.
+* The snapshots stay in each ship's own buffer, which receives and evicts them, so the two a ship blends between are gathered in again every frame.
+*/
+struct FServerProxyInterpolationBatch
+{
+	TArray<ANetworkedBuoyantPawn*> Ships;
+
+	//The snapshots each ship blends between, To is unused when dead reckoning
+	TArray<FVector> FromLocations;
+	TArray<FVector> FromLinearVelocities;
+	TArray<FVector> FromAngularVelocities; //Degrees per second
+	TArray<FQuat> FromRotations;
+	TArray<FVector> ToLocations;
+	TArray<FVector> ToLinearVelocities;
+	TArray<FVector> ToAngularVelocities; //Degrees per second
+	TArray<FQuat> ToRotations;
+	TArray<float> Intervals; //Seconds between From and To, zero when dead reckoning
+	TArray<float> Alphas; //The interpolation alpha, or the seconds to dead reckon
+
+	//The interpolated states applied to the bodies
+	TArray<FVector> OutLocations;
+	TArray<FQuat> OutRotations;
+	TArray<FVector> OutLinearVelocities;
+	TArray<FVector> OutAngularVelocities; //Degrees per second
+
+	FServerProxyInterpolationBatch() {};
+
+	int32 Num() const { return Ships.Num(); }
+
+	/**
+	*	Empty the batch, keeping its memory for the next frame
+	*/
+	void Reset();
+
+	/**
+	*	Add a ship blending between two snapshots
+	*	@param	Ship - The ship to move
+	*	@param	From - The snapshot at or before the buffered time
+	*	@param	To - The snapshot after the buffered time, nullptr to dead reckon from From
+	*	@param	Alpha - The interpolation alpha, or the seconds to dead reckon when To is nullptr
+	*/
+	void Add(ANetworkedBuoyantPawn* Ship, const FMovementSnapshot& From, const FMovementSnapshot* To, float Alpha);
+
+	/**
+	*	Interpolate a single entry into the output arrays, entries are independent so this may run in parallel
+	*	@param	Index - The entry to interpolate
+	*/
+	void Interpolate(int32 Index);
+};
+
+/*
+* Replicates the movement of every ship to every connection in batches, instead of a multicast RPC per ship.
+* Ships queue each snapshot the server accepts, every remote connection's UShipReplicationComponent then sends what's waiting for it as one bunch,
+* so the per RPC overhead is paid once per connection and flush rather than once per ship.
+* The components are added to remote PlayerControllers on the server as they're found, and replicate to their owning clients.
+* On the server it also plays out the snapshot buffers of every client owned ship in a single pass per frame, instead of each ship sampling its own buffer in its tick.
+* It owns the replication clock every snapshot is stamped and played out with - the server's real time, which clients estimate by pinging it through their component.
+*/
+UCLASS(Config = Game)
+class SAILSOFWAR_API UShipReplicationSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/**
+	*	Find the ship replication subsystem for a world context object
+	*	@param	WorldContextObject - Any object living in the world
+	*	@return	UShipReplicationSubsystem* - the subsystem, nullptr if the object has no world
+	*/
+	static UShipReplicationSubsystem* Get(const UObject* WorldContextObject);
+
+	/**
+	*	Register a connection's replication component so ship snapshots are queued for it
+	*	@param	Component - the component to register
+	*/
+	void RegisterReceiver(UShipReplicationComponent* Component);
+
+	/**
+	*	Stop queuing ship snapshots for a connection
+	*	@param	Component - the component to unregister
+	*/
+	void UnregisterReceiver(UShipReplicationComponent* Component);
+
+	/**
+	*	Queue a ship's snapshot for every connection simulating it, the owning connection already has it
+	*	@param	Ship - The ship the snapshot belongs to
+	*	@param	Snapshot - The quantized snapshot the server accepted
+	*/
+	void QueueSnapshot(ANetworkedBuoyantPawn* Ship, const FQuantizedMovementSnapshot& Snapshot);
+
+	/**
+	*	Record a snapshot the server accepted to the replay, if recording is enabled
+	*	@param	Ship - The ship the snapshot belongs to
+	*	@param	Snapshot - The quantized snapshot
+	*/
+	void RecordSnapshot(ANetworkedBuoyantPawn* Ship, const FQuantizedMovementSnapshot& Snapshot);
+
+	/**
+	*	Returns the path of the replay being recorded, empty if none is
+	*/
+	const FString& GetReplayPath() const { return ReplayPath; }
+
+	/**
+	*	Returns true if ship snapshots should be queued here rather than multicast by each ship
+	*/
+	bool IsBatchingEnabled() const { return bEnableBatching; }
+
+	/**
+	*	Returns the batching settings
+	*/
+	const FShipReplicationSettings& GetSettings() const { return Settings; }
+
+	/**
+	*	Request the server's interpolation of a client owned ship this frame, must be called every frame the ship should move.
+	*	A ship that misses a frame's request is dropped from the batch and has to request again.
+	*	The first request of a frame interpolates every ship that requested one before, later requests that frame are already done.
+	*	@param	Ship - The client owned ship to interpolate
+	*	@return	bool - false if the ship must interpolate itself this frame
+	*/
+	bool RequestServerInterpolation(ANetworkedBuoyantPawn* Ship);
+
+	/**
+	*	Get the time snapshots are stamped, received and played out with - the server's clock, synchronized on clients.
+	*	Falls back to the game state's replicated server time while clock sync is disabled.
+	*	@return	float - the replication time in seconds
+	*/
+	float GetReplicationTime();
+
+	/**
+	*	Returns false on a client whose synchronized clock hasn't converged yet, snapshots mustn't be stamped, timed or played out until it has.
+	*	The server's clock is real time, the game state's time the clock falls back to isn't on the same base.
+	*	@return	bool - true once the replication time is on the server's clock
+	*/
+	bool HasReplicationTime() const;
+
+	/**
+	*	Add an updated snapshot buffer's playout delay to this frame's buffer delays, from the game thread.
+	*	The first report of a frame sets the view delay and the stats from the buffers reported during the previous frame.
+	*	@param	Buffer - The snapshot buffer after its Update()
+	*/
+	void ReportBufferDelay(const FMovementSnapShotBuffer& Buffer);
+
+	/**
+	*	Returns the mean delay the buffers reported last frame play out with, on a client how far behind its own ship it sees the others
+	*	@return	float - the delay in milliseconds
+	*/
+	float GetViewDelay() const { return ViewDelay; }
+
+	/**
+	*	Returns the local clock pings are measured with, the world's real time
+	*/
+	float GetLocalClockTime() const;
+
+	/**
+	*	Add a ping's measurement to the client's clock estimate
+	*	@param	LocalSendTime - The local clock time the ping was sent
+	*	@param	ServerTime - The server's replication time when it answered
+	*	@param	LocalReceiveTime - The local clock time the answer arrived
+	*/
+	void AddClockSample(float LocalSendTime, float ServerTime, float LocalReceiveTime);
+
+	/**
+	*	Returns the clock sync settings
+	*/
+	const FClockSyncSettings& GetClockSyncSettings() const { return ClockSync; }
+
+	/**
+	*	Returns true once the client's clock estimate has a full window of pings
+	*/
+	bool IsClockConverged() const { return Clock.IsConverged(ClockSync); }
+
+protected:
+	/**
+	*	Add a replication component to every remote PlayerController missing one, runs at most once per frame
+	*/
+	void UpdateReceivers();
+
+	/**
+	*	Rebuild the interest grid from every forwarded ship and update each connection's interest, runs at most once per frame
+	*/
+	void UpdateInterest();
+
+	/**
+	*	Update a ship's tracked motion from its newest snapshot
+	*	@param	Ship - The ship the snapshot belongs to
+	*	@param	Snapshot - The newest snapshot
+	*	@return	float - the rate scale in [0, 1] the ship's speed, acceleration and turn rate ask for
+	*/
+	float UpdateShipMotion(ANetworkedBuoyantPawn* Ship, const FMovementSnapshot& Snapshot);
+
+	/**
+	*	Sample the snapshot buffer of every interpolated ship, blend them in parallel and move the bodies
+	*	@param	Time - The time the server's snapshot buffers are played out at
+	*/
+	void InterpolateServerProxies(float Time);
+
+	/**
+	*	Returns true if the server plays out this ship's snapshots, rather than simulating it or owning it locally
+	*/
+	static bool IsServerProxy(const ANetworkedBuoyantPawn* Ship);
+
+	UPROPERTY(Config)
+		bool bEnableBatching = true; //Disable to multicast every snapshot from its own ship
+
+	UPROPERTY(Config)
+		FShipReplicationSettings Settings;
+
+	UPROPERTY()
+		TArray<UShipReplicationComponent*> Receivers; //One per remote connection
+
+	uint64 ReceiversUpdatedFrame = 0; //The last frame UpdateReceivers() ran
+
+	TMap<TWeakObjectPtr<ANetworkedBuoyantPawn>, FShipMotionState> ShipMotion; //The tracked motion of every ship queuing snapshots
+
+	FShipInterestGrid InterestGrid; //Every ship in ShipMotion by location
+
+	uint64 InterestUpdatedFrame = 0; //The last frame UpdateInterest() ran
+
+	UPROPERTY(Config)
+		bool bBatchServerInterpolation = true; //Disable to let every client owned ship interpolate itself in its tick
+
+	UPROPERTY(Config)
+		bool bInterpolateInParallel = true; //Disable to interpolate the batch on a single thread, useful for debugging
+
+	UPROPERTY(Config)
+		int32 MinParallelInterpolationBatch = 16; //Smaller batches are interpolated on the game thread, the task overhead outweighs the work
+
+	TMap<TWeakObjectPtr<ANetworkedBuoyantPawn>, uint64> ServerProxies; //Every client owned ship requesting interpolation and the last frame it requested it
+
+	FServerProxyInterpolationBatch InterpolationBatch; //Reused every frame
+
+	uint64 InterpolatedFrame = 0; //The last frame InterpolateServerProxies() ran
+
+	UPROPERTY(Config)
+		FClockSyncSettings ClockSync;
+
+	FReplicatedClock Clock; //The client's estimate of the server's clock, unused on the server
+
+	uint64 BufferStatsFrame = 0; //The frame the buffer delays below were reported in
+
+	int32 NumBuffers = 0;
+
+	float TotalBufferDelay = 0.0f; //Milliseconds, for the mean - a sum grows with the number of ships and says nothing about any one of them
+
+	float ViewDelay = 0.0f; //Milliseconds, the mean of the previous frame's buffer delays
+
+	int32 NumAdaptiveBuffers = 0;
+
+	float MaxBufferDelay = 0.0f; //Milliseconds
+
+	float MaxTargetDelay = 0.0f; //Milliseconds
+
+	UPROPERTY(Config)
+		FShipReplaySettings Replay;
+
+	FShipReplayWriter ReplayWriter; //Opened with the first recorded snapshot
+
+	FString ReplayPath;
+
+	TMap<TWeakObjectPtr<ANetworkedBuoyantPawn>, uint32> ReplayShipIds; //Ships are identified by these in the recording
+
+	uint32 NextReplayShipId = 0;
+
+/*UWorldSubsystem Overrides*/
+public:
+	virtual void Deinitialize() override;
+};
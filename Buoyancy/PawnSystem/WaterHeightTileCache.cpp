@@ -0,0 +1,231 @@
+/*=================================================
+* FileName: WaterHeightTileCache.cpp
+*
+* Created by: Sails of War contributors
+* Project name: Sails of War
+* Unreal Engine version: 4.22
+* Created on: 2026/10/18
+*
+* Last Edited on: 2026/10/18
+* Last Edited by: Sails of War contributors
+*
+* -------------------------------------------------
+* Created for: Sails Of War - http://sailsofwargame.com/
+* -------------------------------------------------
+* For parts referencing UE4 code, the following copyright applies:
+* Copyright 1998-2020 Epic Games, Inc. All Rights Reserved.
+*
+* Feel free to use this software in any commercial/free game.
+* Selling this as a plugin/item, in whole or part, is not allowed.
+* =================================================*/
+//Libary Includes:
+#include "WaterHeightTileCache.h"
+#include "Libraries/Buoyancy/BuoyancyLibrary.h"
+
+//Project Includes:
+#include "SOWOceanActor.h"
+
+//Engine Includes:
+#include "Async/ParallelFor.h"
+
+DECLARE_CYCLE_STAT(TEXT("RequestGridTiles"), STAT_RequestGridTiles, STATGROUP_BuoyancyStatics);
+DECLARE_CYCLE_STAT(TEXT("SampleRequestedTiles"), STAT_SampleRequestedTiles, STATGROUP_BuoyancyStatics);
+DECLARE_CYCLE_STAT(TEXT("ReadGridHeights"), STAT_ReadGridHeights, STATGROUP_BuoyancyStatics);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Water Tiles Sampled"), STAT_WaterTilesSampled, STATGROUP_BuoyancyStatics);
+
+void FWaterHeightTileCache::BeginTimeStep(ASOWOceanActor* InOceanActor, float InOceanTime)
+{
+	FRWScopeLock Lock(TileLock, SLT_Write);
+	OceanActor = InOceanActor;
+	OceanTime = InOceanTime;
+	TimeStep++;
+	TileIndices.Reset();
+	NumActiveTiles = 0;
+	NumSampledTiles = 0;
+}
+
+void FWaterHeightTileCache::RequestGridTiles(const FWaterGrid& Grid)
+{
+	SCOPE_CYCLE_COUNTER(STAT_RequestGridTiles);
+	if (Grid.CellSize <= 0.0f)
+		return;
+
+	const int32 CellSizeKey = FMath::RoundToInt(Grid.CellSize);
+	const FIntPoint MinVertex = FIntPoint(FMath::RoundToInt(Grid.GridOrigin.X / Grid.CellSize), FMath::RoundToInt(Grid.GridOrigin.Y / Grid.CellSize));
+
+	FRWScopeLock Lock(TileLock, SLT_Write);
+	//Only the tiles under the grid's sampled vertices, rows sharing a tile find it already requested
+	for (int32 Row = 0; Row <= int32(Grid.GridSize.X); Row++)
+	{
+		const FIntPoint Columns = Grid.GetSampledVertexColumns(Row);
+		if (Columns.X > Columns.Y)
+			continue;
+
+		const int32 VertexX = MinVertex.X + Row;
+		const FIntPoint MinTile = GetTileForVertex(FIntPoint(VertexX, MinVertex.Y + Columns.X));
+		const FIntPoint MaxTile = GetTileForVertex(FIntPoint(VertexX, MinVertex.Y + Columns.Y));
+		for (int32 TileY = MinTile.Y; TileY <= MaxTile.Y; TileY++)
+		{
+			const FWaterTileKey Key = FWaterTileKey(FIntPoint(MinTile.X, TileY), CellSizeKey, TimeStep);
+			if (TileIndices.Contains(Key))
+				continue;
+
+			//Reuse the memory of tiles from earlier time steps
+			if (NumActiveTiles == Tiles.Num())
+				Tiles.AddDefaulted();
+
+			FWaterHeightTile& Tile = Tiles[NumActiveTiles];
+			Tile.Key = Key;
+			Tile.Heights.SetNumUninitialized(TileResolution * TileResolution, false);
+			Tile.bSampled = false;
+			TileIndices.Add(Key, NumActiveTiles);
+			NumActiveTiles++;
+		}
+	}
+}
+
+void FWaterHeightTileCache::SampleRequestedTiles(bool bParallel)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SampleRequestedTiles);
+	if (OceanActor == nullptr)
+		return;
+
+	const int32 FirstTile = NumSampledTiles;
+	const int32 NumTilesToSample = NumActiveTiles - NumSampledTiles;
+	INC_DWORD_STAT_BY(STAT_WaterTilesSampled, NumTilesToSample);
+
+	ParallelFor(NumTilesToSample, [this, FirstTile](int32 Index)
+	{
+		FWaterHeightTile& Tile = Tiles[FirstTile + Index];
+		const float CellSize = float(Tile.Key.CellSize);
+		const FIntPoint FirstVertex = Tile.Key.Tile * TileResolution;
+		for (int32 Row = 0; Row < TileResolution; Row++)
+		{
+			for (int32 Col = 0; Col < TileResolution; Col++)
+			{
+				const FVector Point = FVector((FirstVertex.X + Row) * CellSize, (FirstVertex.Y + Col) * CellSize, 0.0f);
+				Tile.Heights[Row * TileResolution + Col] = SampleOceanHeight(OceanActor, Point, CellSize, OceanTime);
+			}
+		}
+
+		//Published under the lock, a query that finds the tile sampled also sees its heights
+		FRWScopeLock Lock(TileLock, SLT_Write);
+		Tile.bSampled = true;
+	}, !bParallel);
+
+	NumSampledTiles = NumActiveTiles;
+}
+
+bool FWaterHeightTileCache::ReadGridHeights(FWaterGrid& Grid) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_ReadGridHeights);
+	if (Grid.CellSize <= 0.0f)
+		return false;
+
+	const int32 CellSizeKey = FMath::RoundToInt(Grid.CellSize);
+	const FIntPoint MinVertex = FIntPoint(FMath::RoundToInt(Grid.GridOrigin.X / Grid.CellSize), FMath::RoundToInt(Grid.GridOrigin.Y / Grid.CellSize));
+
+	FRWScopeLock Lock(TileLock, SLT_ReadOnly);
+	const FWaterHeightTile* Tile = nullptr;
+	for (int32 Row = 0; Row < Grid.Vertices.Num(); Row++)
+	{
+		const FIntPoint Columns = Grid.GetSampledVertexColumns(Row);
+		for (int32 Col = Columns.X; Col <= Columns.Y; Col++)
+		{
+			const FIntPoint VertexCoordinate = MinVertex + FIntPoint(Row, Col);
+			const FIntPoint TileCoordinate = GetTileForVertex(VertexCoordinate);
+
+			//Neighbouring vertices share a tile, only search the map when we cross into a new one
+			if (Tile == nullptr || Tile->Key.Tile != TileCoordinate)
+			{
+				const int32* TileIndex = TileIndices.Find(FWaterTileKey(TileCoordinate, CellSizeKey, TimeStep));
+				if (TileIndex == nullptr || !Tiles[*TileIndex].bSampled)
+					return false;
+
+				Tile = &Tiles[*TileIndex];
+			}
+
+			const FIntPoint Local = VertexCoordinate - (TileCoordinate * TileResolution);
+			Grid.Vertices[Row][Col].Vertex.Z = Tile->Heights[Local.X * TileResolution + Local.Y];
+		}
+	}
+
+	return true;
+}
+
+float FWaterHeightTileCache::GetWaterHeightAtLocation(const FVector& Location, float CellSize) const
+{
+	if (CellSize <= 0.0f)
+		return 0.0f;
+
+	const int32 CellSizeKey = FMath::RoundToInt(CellSize);
+	const FIntPoint Cell = FIntPoint(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize));
+	const float LocalX = Location.X - (Cell.X * CellSize);
+	const float LocalY = Location.Y - (Cell.Y * CellSize);
+
+	//Cell vertices ordered like FWaterCell - Bottom Left, +Y, +X, Upper Right
+	const FIntPoint CellVertices[4] = { Cell, Cell + FIntPoint(0, 1), Cell + FIntPoint(1, 0), Cell + FIntPoint(1, 1) };
+	float Heights[4];
+	bool bCached[4];
+
+	//The cache may be on its next time step on the physics thread, so the ocean and the heights are read together
+	ASOWOceanActor* QueryOceanActor = nullptr;
+	float QueryOceanTime = 0.0f;
+	{
+		FRWScopeLock Lock(TileLock, SLT_ReadOnly);
+		QueryOceanActor = OceanActor;
+		QueryOceanTime = OceanTime;
+		for (int32 VertIndex = 0; VertIndex < 4; VertIndex++)
+			bCached[VertIndex] = FindVertexHeight(CellVertices[VertIndex], CellSizeKey, Heights[VertIndex]);
+	}
+
+	//Sampled outside the lock so the query doesn't stall the sub-step
+	for (int32 VertIndex = 0; VertIndex < 4; VertIndex++)
+	{
+		if (!bCached[VertIndex])
+		{
+			const FVector Point = FVector(CellVertices[VertIndex].X * CellSize, CellVertices[VertIndex].Y * CellSize, 0.0f);
+			Heights[VertIndex] = QueryOceanActor != nullptr ? SampleOceanHeight(QueryOceanActor, Point, CellSize, QueryOceanTime) : 0.0f;
+		}
+	}
+
+	//Interpolate on the same triangle FWaterCell::GetTriangleIndexForPoint() would pick
+	if (LocalY > LocalX)
+		return Heights[0] + ((Heights[3] - Heights[1]) * LocalX + (Heights[1] - Heights[0]) * LocalY) / CellSize;
+
+	return Heights[0] + ((Heights[2] - Heights[0]) * LocalX + (Heights[3] - Heights[2]) * LocalY) / CellSize;
+}
+
+float FWaterHeightTileCache::SampleOceanHeight(ASOWOceanActor* OceanActor, const FVector& Point, float CellSize, float Time)
+{
+	//UPDATE_TASK: Profile cost of using 2 non-linear equations instead of 4 extra queries.
+	const FVector A = FVector(CellSize * 0.5f, -CellSize * 0.5f, 0.0f);
+	const FVector B = FVector(-CellSize * 0.5f, -CellSize * 0.5f, 0.0f);
+	const FVector C = FVector(CellSize * 0.5f, CellSize * 0.5f, 0.0f);
+	const FVector D = FVector(-CellSize * 0.5f, CellSize * 0.5f, 0.0f);
+	const FVector OutputA = OceanActor->GetOceanVector(Point + A, Time);
+	const FVector OutputB = OceanActor->GetOceanVector(Point + B, Time);
+	const FVector OutputC = OceanActor->GetOceanVector(Point + C, Time);
+	const FVector OutputD = OceanActor->GetOceanVector(Point + D, Time);
+	const FVector Output = (OutputA + OutputB + OutputC + OutputD) / 4.0f;
+	return OceanActor->GetOceanHeight(Point - Output, Time);
+}
+
+FIntPoint FWaterHeightTileCache::GetTileForVertex(const FIntPoint& VertexCoordinate)
+{
+	//Floor division, vertices left of or below the world origin belong to negative tiles
+	auto FloorDivide = [](int32 Value) { return Value >= 0 ? Value / TileResolution : ((Value + 1) / TileResolution) - 1; };
+	return FIntPoint(FloorDivide(VertexCoordinate.X), FloorDivide(VertexCoordinate.Y));
+}
+
+bool FWaterHeightTileCache::FindVertexHeight(const FIntPoint& VertexCoordinate, int32 CellSize, float& OutHeight) const
+{
+	const FIntPoint TileCoordinate = GetTileForVertex(VertexCoordinate);
+	const int32* TileIndex = TileIndices.Find(FWaterTileKey(TileCoordinate, CellSize, TimeStep));
+	if (TileIndex == nullptr || !Tiles[*TileIndex].bSampled)
+		return false;
+
+	const FIntPoint Local = VertexCoordinate - (TileCoordinate * TileResolution);
+	OutHeight = Tiles[*TileIndex].Heights[Local.X * TileResolution + Local.Y];
+	return true;
+}
@@ -0,0 +1,151 @@
+/*=================================================
+* FileName: WaterHeightTileCache.h
+*
+* Created by: Sails of War contributors
+* Project name: Sails of War
+* Unreal Engine version: 4.22
+* Created on: 2026/10/18
+*
+* Last Edited on: 2026/10/18
+* Last Edited by: Sails of War contributors
+*
+* -------------------------------------------------
+* Created for: Sails Of War - http://sailsofwargame.com/
+* -------------------------------------------------
+* For parts referencing UE4 code, the following copyright applies:
+* Copyright 1998-2020 Epic Games, Inc. All Rights Reserved.
+*
+* Feel free to use this software in any commercial/free game.
+* Selling this as a plugin/item, in whole or part, is not allowed.
+* =================================================*/
+#pragma once
+
+//Engine Includes:
+#include "CoreMinimal.h"
+#include "Misc/ScopeRWLock.h"
+
+class ASOWOceanActor;
+struct FWaterGrid;
+
+//Identifies a world aligned tile of water heights sampled during a single simulation time step
+struct FWaterTileKey
+{
+	FIntPoint Tile = FIntPoint::ZeroValue; //The tile's coordinate, in tiles
+	int32 CellSize = 0; //The spacing between the tile's vertices in whole centimeters
+	uint32 TimeStep = 0; //The simulation time step the tile was sampled for
+
+	FWaterTileKey() {};
+	FWaterTileKey(FIntPoint InTile, int32 InCellSize, uint32 InTimeStep) :
+		Tile(InTile), CellSize(InCellSize), TimeStep(InTimeStep) {}
+
+	bool operator==(const FWaterTileKey& Other) const
+	{
+		return Tile == Other.Tile && CellSize == Other.CellSize && TimeStep == Other.TimeStep;
+	}
+
+	friend uint32 GetTypeHash(const FWaterTileKey& Key)
+	{
+		return HashCombine(HashCombine(GetTypeHash(Key.Tile), ::GetTypeHash(Key.CellSize)), ::GetTypeHash(Key.TimeStep));
+	}
+};
+
+//A square block of world snapped water heights
+struct FWaterHeightTile
+{
+	FWaterTileKey Key;
+	TArray<float> Heights; //TileResolution * TileResolution heights - [Row * TileResolution + Column]
+	bool bSampled = false; //True once the heights have been sampled for the key's time step, only set under the cache's lock after the heights are written
+
+	FWaterHeightTile() {};
+};
+
+/*
+* A cache of world aligned water height tiles shared by every buoyant body and gameplay height query.
+* Water grids snap their vertices to a world space grid of CellSize, so ships sailing close to each other
+* sample the same vertices. Each vertex belongs to exactly one tile - a tile is sampled once per time step
+* no matter how many grids overlap it.
+*
+* Usage during a sub-step:
+*	1. BeginTimeStep() - drops the previous step's tiles, keeping their memory
+*	2. RequestGridTiles() - serially, for every grid taking part in the step
+*	3. SampleRequestedTiles() - samples every requested tile, optionally in parallel
+*	4. ReadGridHeights() - from any thread, copies the heights into a grid
+*
+* Gameplay queries from the game thread may overlap a sub-step on the physics thread. Tiles are published by setting their
+* bSampled flag under the lock once their heights are written, and queries only read the heights of published tiles.
+*/
+class SAILSOFWAR_API FWaterHeightTileCache
+{
+public:
+	static const int32 TileResolution = 8; //The number of vertices along a tile's edge
+
+	FWaterHeightTileCache() {};
+
+	/**
+	*	Start a new simulation time step, tiles of the previous step are no longer valid
+	*	@param	InOceanActor - The ocean to sample
+	*	@param	InOceanTime - The ocean time to sample the tiles at
+	*/
+	void BeginTimeStep(ASOWOceanActor* InOceanActor, float InOceanTime);
+
+	/**
+	*	Request every tile covering a grid's sampled vertices for the current time step, see FWaterGrid::SetFootprintMask()
+	*	@param	Grid - the grid to request tiles for
+	*/
+	void RequestGridTiles(const FWaterGrid& Grid);
+
+	/**
+	*	Sample the ocean for every requested tile that hasn't been sampled yet
+	*	@param	bParallel - sample the tiles across the task graph's worker threads
+	*/
+	void SampleRequestedTiles(bool bParallel);
+
+	/**
+	*	Copy the cached heights into the grid's sampled vertices
+	*	@param	Grid - the grid to update
+	*	@return	bool - false if any of the grid's tiles hasn't been sampled this time step, the grid is left partially updated
+	*/
+	bool ReadGridHeights(FWaterGrid& Grid) const;
+
+	/**
+	*	Get the water height at a location, read from the cache when its tile has been sampled this time step
+	*	@param	Location - the world space location to find the height at
+	*	@param	CellSize - the spacing of the sampled vertices, matches FWaterGrid's triangulation
+	*	@return	float - the water height in world space
+	*/
+	float GetWaterHeightAtLocation(const FVector& Location, float CellSize) const;
+
+	/**
+	*	Sample the ocean height at a point, offsetting the query by the average horizontal displacement of the surrounding points.
+	*	This is the sample used by every water grid vertex.
+	*	@param	OceanActor - the ocean to query
+	*	@param	Point - the world space point to sample
+	*	@param	CellSize - the spacing between the surrounding displacement queries
+	*	@param	Time - the ocean time to sample at
+	*	@return	float - the water height at the point
+	*/
+	static float SampleOceanHeight(ASOWOceanActor* OceanActor, const FVector& Point, float CellSize, float Time);
+
+	uint32 GetTimeStep() const { FRWScopeLock Lock(TileLock, SLT_ReadOnly); return TimeStep; }
+	float GetOceanTime() const { FRWScopeLock Lock(TileLock, SLT_ReadOnly); return OceanTime; }
+	ASOWOceanActor* GetOceanActor() const { FRWScopeLock Lock(TileLock, SLT_ReadOnly); return OceanActor; }
+	int32 GetNumActiveTiles() const { return NumActiveTiles; }
+
+private:
+	/* Find the tile and the index within the tile for a world snapped vertex coordinate */
+	static FIntPoint GetTileForVertex(const FIntPoint& VertexCoordinate);
+
+	/* Returns the cached height of a world snapped vertex, false if its tile isn't sampled this step - the caller holds TileLock */
+	bool FindVertexHeight(const FIntPoint& VertexCoordinate, int32 CellSize, float& OutHeight) const;
+
+	TMap<FWaterTileKey, int32> TileIndices; //Key to an index of Tiles
+	TArray<FWaterHeightTile> Tiles; //Tile storage, only the first NumActiveTiles are valid - the rest keep their memory for reuse
+	int32 NumActiveTiles = 0;
+	int32 NumSampledTiles = 0; //Tiles [0, NumSampledTiles) have been sampled
+
+	ASOWOceanActor* OceanActor = nullptr;
+	float OceanTime = 0.0f;
+	uint32 TimeStep = 0;
+
+	mutable FRWLock TileLock; //Guards TileIndices, the tiles' bSampled flags and the ocean against gameplay queries made during a sub-step
+};
@@ -0,0 +1,220 @@
+/*=================================================
+* FileName: MovementSnapshotQuantizationTests.cpp
+*
+* Created by: Sails of War contributors
+* Project name: Sails of War
+* Unreal Engine version: 4.22
+* Created on: 2026/10/18
+*
+* Last Edited on: 2026/10/18
+* Last Edited by: Sails of War contributors
+*
+* -------------------------------------------------
+* Created for: Sails Of War - http://sailsofwargame.com/
+* -------------------------------------------------
+* For parts referencing UE4 code, the following copyright applies:
+* Copyright 1998-2020 Epic Games, Inc. All Rights Reserved.
+*
+* Feel free to use this software in any commercial/free game.
+* Selling this as a plugin/item, in whole or part, is not allowed.
+* =================================================*/
+
+//Project Includes:
+#include "Libraries/Buoyancy/PawnSystem/PhysicsMovementReplication.h"
+
+//Engine Includes:
+#include "Misc/AutomationTest.h"
+#include "Serialization/BitReader.h"
+#include "Serialization/BitWriter.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace MovementSnapshotQuantizationTests
+{
+	static const int32 NumSnapshots = 64;
+	static const float MaxRotationError = 0.1f; //Degrees, the smallest three components are 12 bits each
+	static const float MaxTimeError = 0.001f; //Seconds, whole milliseconds plus the float's rounding at the test's times
+
+	//Replicated as plain properties: three FVectors, an FQuat and the timestamp as floats, and the int8 event flag
+	static const int64 FullPrecisionBits = (3 * 3 + 4 + 1) * 32 + 8;
+
+	static float GetPositionStep(ESnapshotPositionPrecision Precision)
+	{
+		switch (Precision)
+		{
+		case ESnapshotPositionPrecision::TenthMillimeter:
+			return 0.01f;
+		case ESnapshotPositionPrecision::Millimeter:
+			return 0.1f;
+		default:
+			return 1.0f;
+		}
+	}
+
+	static FMovementSnapshot MakeSnapshot(FRandomStream& Random, float TimeStamp, ESnapshotPositionPrecision Precision)
+	{
+		//Within the quantization's velocity limits, clamping is not what's tested here
+		FMovementSnapshot Snapshot = FMovementSnapshot(
+			Random.GetUnitVector() * Random.FRandRange(0.0f, 2000.0f),
+			Random.GetUnitVector() * Random.FRandRange(0.0f, 90.0f),
+			FVector(Random.FRandRange(-20000.0f, 20000.0f), Random.FRandRange(-20000.0f, 20000.0f), Random.FRandRange(-500.0f, 500.0f)),
+			FRotator(Random.FRandRange(-30.0f, 30.0f), Random.FRandRange(-180.0f, 180.0f), Random.FRandRange(-45.0f, 45.0f)).Quaternion(),
+			TimeStamp);
+		Snapshot.Quantization.PositionPrecision = Precision;
+		return Snapshot;
+	}
+
+	static FQuantizedMovementSnapshot SerializeRoundTrip(const FQuantizedMovementSnapshot& Snapshot, bool bDelta)
+	{
+		FBitWriter Writer(0, true);
+		FQuantizedMovementSnapshot Written = Snapshot;
+		Written.Serialize(Writer, bDelta);
+
+		FBitReader Reader(Writer.GetData(), Writer.GetNumBits());
+		FQuantizedMovementSnapshot Read;
+		Read.Serialize(Reader, bDelta);
+		return Read;
+	}
+
+	static int64 GetPacketBits(const FMovementSnapshotPacket& Packet)
+	{
+		FBitWriter Writer(0, true);
+		FMovementSnapshotPacket Written = Packet;
+		bool bSuccess = true;
+		Written.NetSerialize(Writer, nullptr, bSuccess);
+		return Writer.GetNumBits();
+	}
+
+	static void TestSnapshotError(FAutomationTestBase& Test, const TCHAR* What, const FMovementSnapshot& Original, const FMovementSnapshot& Received)
+	{
+		//Rounding to the step is off by half a step, plus the float's own precision at the test's distances
+		const float MaxPositionError = GetPositionStep(Original.Quantization.PositionPrecision) * 0.5f + 0.002f;
+		const float PositionError = (Received.Location - Original.Location).GetAbsMax();
+		const float RotationError = FMath::RadiansToDegrees(Received.Rotation.AngularDistance(Original.Rotation));
+		const float LinearVelocityError = (Received.LinearVelocity - Original.LinearVelocity).GetAbsMax();
+		const float AngularVelocityError = (Received.AngularVelocity - Original.AngularVelocity).GetAbsMax();
+
+		Test.TestTrue(FString::Printf(TEXT("%s: position error %f within %f"), What, PositionError, MaxPositionError), PositionError <= MaxPositionError);
+		Test.TestTrue(FString::Printf(TEXT("%s: rotation error %f degrees within %f"), What, RotationError, MaxRotationError), RotationError <= MaxRotationError);
+		Test.TestTrue(FString::Printf(TEXT("%s: linear velocity error %f"), What, LinearVelocityError), LinearVelocityError <= 0.5f + KINDA_SMALL_NUMBER);
+		Test.TestTrue(FString::Printf(TEXT("%s: angular velocity error %f"), What, AngularVelocityError), AngularVelocityError <= 0.05f + KINDA_SMALL_NUMBER);
+		Test.TestTrue(FString::Printf(TEXT("%s: time error %f"), What, FMath::Abs(Received.TimeStamp - Original.TimeStamp)), FMath::Abs(Received.TimeStamp - Original.TimeStamp) <= MaxTimeError);
+		Test.TestEqual(FString::Printf(TEXT("%s: precision"), What), (uint8)Received.Quantization.PositionPrecision, (uint8)Original.Quantization.PositionPrecision);
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMovementSnapshotQuantizationTest, "SailsOfWar.Buoyancy.MovementSnapshot.QuantizationRoundTrip", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FMovementSnapshotQuantizationTest::RunTest(const FString& Parameters)
+{
+	using namespace MovementSnapshotQuantizationTests;
+
+	const ESnapshotPositionPrecision Precisions[] = { ESnapshotPositionPrecision::Centimeter, ESnapshotPositionPrecision::Millimeter, ESnapshotPositionPrecision::TenthMillimeter };
+	for (const ESnapshotPositionPrecision Precision : Precisions)
+	{
+		FRandomStream Random(1234 + (int32)Precision);
+
+		//An hour into the session, where a float in seconds still resolves a millisecond
+		float TimeStamp = 3600.0f;
+		FMovementSnapshot BaselineSnapshot = MakeSnapshot(Random, TimeStamp, Precision);
+		FQuantizedMovementSnapshot Baseline = FQuantizedMovementSnapshot::Quantize(BaselineSnapshot);
+		TestSnapshotError(*this, TEXT("Keyframe"), BaselineSnapshot, SerializeRoundTrip(Baseline, false).Dequantize());
+
+		for (int32 Index = 0; Index < NumSnapshots; Index++)
+		{
+			TimeStamp += Random.FRandRange(0.01f, 0.2f);
+			const FMovementSnapshot Snapshot = MakeSnapshot(Random, TimeStamp, Precision);
+			const FQuantizedMovementSnapshot Quantized = FQuantizedMovementSnapshot::Quantize(Snapshot);
+
+			//Quantize -> delta -> wire -> apply -> dequantize, rotations with a different dropped component than the baseline are sent whole
+			const FQuantizedMovementSnapshot Delta = SerializeRoundTrip(Quantized.GetDelta(Baseline), true);
+			const FQuantizedMovementSnapshot Rebuilt = FQuantizedMovementSnapshot::ApplyDelta(Baseline, Delta);
+			TestTrue(TEXT("The delta rebuilds the quantized snapshot exactly"), Rebuilt.Location == Quantized.Location && Rebuilt.Rotation == Quantized.Rotation
+				&& Rebuilt.RotationLargestIndex == Quantized.RotationLargestIndex && Rebuilt.TimeStampMs == Quantized.TimeStampMs);
+			TestSnapshotError(*this, TEXT("Delta"), Snapshot, Rebuilt.Dequantize());
+
+			Baseline = Quantized;
+		}
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMovementSnapshotWireSizeTest, "SailsOfWar.Buoyancy.MovementSnapshot.WireSize", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FMovementSnapshotWireSizeTest::RunTest(const FString& Parameters)
+{
+	using namespace MovementSnapshotQuantizationTests;
+
+	FRandomStream Random(4321);
+	float TimeStamp = 3600.0f;
+	FSnapshotDeltaEncoder Encoder;
+	FPhysicsReplicationSettings Settings;
+	int64 SnapshotBits = 0, KeyframeBits = 0, DeltaBits = 0;
+	int32 NumKeyframes = 0, NumDeltas = 0;
+	for (int32 Index = 0; Index < NumSnapshots; Index++)
+	{
+		TimeStamp += 1.0f / Settings.SendRate;
+		FMovementSnapshot Snapshot = MakeSnapshot(Random, TimeStamp, ESnapshotPositionPrecision::Centimeter);
+
+		FBitWriter Writer(0, true);
+		bool bSuccess = true;
+		Snapshot.NetSerialize(Writer, nullptr, bSuccess);
+		SnapshotBits += Writer.GetNumBits();
+
+		//Every sent snapshot acknowledged, as on a lossless connection
+		const FMovementSnapshotPacket Packet = Encoder.Encode(FQuantizedMovementSnapshot::Quantize(Snapshot), Settings, true);
+		Encoder.Acknowledge(Packet.Sequence);
+		(Packet.bKeyframe ? KeyframeBits : DeltaBits) += GetPacketBits(Packet);
+		(Packet.bKeyframe ? NumKeyframes : NumDeltas)++;
+	}
+
+	const float MeanSnapshotBits = float(SnapshotBits) / NumSnapshots;
+	AddInfo(FString::Printf(TEXT("Full precision %lld bits, quantized snapshot %.1f bits, keyframe packet %.1f bits, delta packet %.1f bits"),
+		FullPrecisionBits, MeanSnapshotBits, NumKeyframes > 0 ? float(KeyframeBits) / NumKeyframes : 0.0f, NumDeltas > 0 ? float(DeltaBits) / NumDeltas : 0.0f));
+	TestTrue(TEXT("A quantized snapshot is under half of the full precision properties"), MeanSnapshotBits < FullPrecisionBits * 0.5f);
+	TestTrue(TEXT("Packets were sent as both keyframes and deltas"), NumKeyframes > 0 && NumDeltas > 0);
+
+	//The wrapped stamp is the only difference between a keyframe packet's state and a whole snapshot
+	FMovementSnapshotPacket Keyframe;
+	Keyframe.State = FQuantizedMovementSnapshot::Quantize(MakeSnapshot(Random, TimeStamp, ESnapshotPositionPrecision::Centimeter));
+	FBitWriter WholeWriter(0, true), WrappedWriter(0, true);
+	Keyframe.State.Serialize(WholeWriter, false);
+	Keyframe.State.Serialize(WrappedWriter, false, true);
+	TestEqual(TEXT("A wrapped keyframe stamp saves the stamp's high bits"), WholeWriter.GetNumBits() - WrappedWriter.GetNumBits(), int64(32 - FQuantizedMovementSnapshot::WrappedTimeStampBits));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMovementSnapshotWrappedTimeStampTest, "SailsOfWar.Buoyancy.MovementSnapshot.WrappedTimeStamps", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FMovementSnapshotWrappedTimeStampTest::RunTest(const FString& Parameters)
+{
+	using namespace MovementSnapshotQuantizationTests;
+
+	//Stamps either side of a wrap, received with the receiver's clock ahead of and behind the sender's
+	const float Period = float(1 << FQuantizedMovementSnapshot::WrappedTimeStampBits) / 1000.0f;
+	const float SentTimes[] = { 3600.0f, Period * 100.0f - 0.05f, Period * 100.0f + 0.05f, 0.2f };
+	const float ClockErrors[] = { -20.0f, -0.1f, 0.0f, 0.3f, 20.0f };
+	FRandomStream Random(99);
+	for (const float SentTime : SentTimes)
+	{
+		const FQuantizedMovementSnapshot Sent = FQuantizedMovementSnapshot::Quantize(MakeSnapshot(Random, SentTime, ESnapshotPositionPrecision::Centimeter));
+		FBitWriter Writer(0, true);
+		FQuantizedMovementSnapshot Written = Sent;
+		Written.Serialize(Writer, false, true);
+
+		for (const float ClockError : ClockErrors)
+		{
+			FBitReader Reader(Writer.GetData(), Writer.GetNumBits());
+			FQuantizedMovementSnapshot Read;
+			Read.Serialize(Reader, false, true);
+			Read.UnwrapTimeStamp(FMath::Max(SentTime + ClockError, 0.0f));
+			TestEqual(FString::Printf(TEXT("Stamp %.3f received %.1fs off is restored"), SentTime, ClockError), Read.TimeStampMs, Sent.TimeStampMs);
+		}
+	}
+
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,181 @@
+/*=================================================
+* FileName: MovementValidatorTests.cpp
+*
+* Created by: Sails of War contributors
+* Project name: Sails of War
+* Unreal Engine version: 4.22
+* Created on: 2026/10/18
+*
+* Last Edited on: 2026/10/18
+* Last Edited by: Sails of War contributors
+*
+* -------------------------------------------------
+* Created for: Sails Of War - http://sailsofwargame.com/
+* -------------------------------------------------
+* For parts referencing UE4 code, the following copyright applies:
+* Copyright 1998-2020 Epic Games, Inc. All Rights Reserved.
+*
+* Feel free to use this software in any commercial/free game.
+* Selling this as a plugin/item, in whole or part, is not allowed.
+* =================================================*/
+
+//Project Includes:
+#include "Libraries/Buoyancy/PawnSystem/PhysicsMovementReplication.h"
+
+//Engine Includes:
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace MovementValidatorTests
+{
+	//A ship sailing along X at 5 m/s, as the last accepted snapshot
+	static FMovementSnapshot MakePrevious()
+	{
+		return FMovementSnapshot(FVector(500.0f, 0.0f, 0.0f), FVector::ZeroVector, FVector::ZeroVector, FQuat::Identity, 10.0f);
+	}
+
+	//Where that ship is after DeltaTime if it kept its course, moved by Offset
+	static FMovementSnapshot MakeNext(float DeltaTime, const FVector& Offset = FVector::ZeroVector)
+	{
+		const FMovementSnapshot Previous = MakePrevious();
+		return FMovementSnapshot(Previous.LinearVelocity, FVector::ZeroVector, Previous.Location + Previous.LinearVelocity * DeltaTime + Offset, FQuat::Identity, Previous.TimeStamp + DeltaTime);
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMovementValidatorKinematicsTest, "SailsOfWar.Buoyancy.MovementValidator.Kinematics", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FMovementValidatorKinematicsTest::RunTest(const FString& Parameters)
+{
+	using namespace MovementValidatorTests;
+
+	const FMovementValidationSettings Settings;
+	const FMovementSnapshot Previous = MakePrevious();
+
+	TestTrue(TEXT("A ship keeping its course is plausible"), FMovementValidator::CheckKinematics(Previous, MakeNext(0.1f), Settings) == EMovementValidationFailure::None);
+
+	FMovementSnapshot Fast = MakeNext(0.1f);
+	Fast.LinearVelocity = FVector(Settings.MaxSpeed * 2.0f, 0.0f, 0.0f);
+	TestTrue(TEXT("Faster than MaxSpeed fails on speed"), FMovementValidator::CheckKinematics(Previous, Fast, Settings) == EMovementValidationFailure::Speed);
+
+	FMovementSnapshot Accelerated = MakeNext(0.1f);
+	Accelerated.LinearVelocity += FVector(0.0f, Settings.MaxAcceleration * 0.5f, 0.0f);
+	TestTrue(TEXT("A velocity change past MaxAcceleration fails on acceleration"), FMovementValidator::CheckKinematics(Previous, Accelerated, Settings) == EMovementValidationFailure::Acceleration);
+
+	const FMovementSnapshot Teleported = MakeNext(0.1f, FVector(0.0f, 10000.0f, 0.0f));
+	TestTrue(TEXT("A jump in location fails on displacement"), FMovementValidator::CheckKinematics(Previous, Teleported, Settings) == EMovementValidationFailure::Displacement);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMovementValidatorTimeStampTest, "SailsOfWar.Buoyancy.MovementValidator.TimeStamps", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FMovementValidatorTimeStampTest::RunTest(const FString& Parameters)
+{
+	using namespace MovementValidatorTests;
+
+	const FMovementValidationSettings Settings;
+	const FMovementSnapshot Previous = MakePrevious();
+
+	//Stamped at or before the last accepted snapshot, even where the ship really was then
+	TestTrue(TEXT("A duplicate stamp is stale"), FMovementValidator::CheckKinematics(Previous, MakeNext(0.0f), Settings) == EMovementValidationFailure::Stale);
+	TestTrue(TEXT("A past stamp is stale"), FMovementValidator::CheckKinematics(Previous, MakeNext(-1.0f), Settings) == EMovementValidationFailure::Stale);
+	TestTrue(TEXT("A past stamp far from the ship is stale"), FMovementValidator::CheckKinematics(Previous, MakeNext(-5.0f, FVector(0.0f, 10000.0f, 0.0f)), Settings) == EMovementValidationFailure::Stale);
+
+	FMovementSnapshot FastReplay = MakeNext(0.0f);
+	FastReplay.LinearVelocity = FVector(Settings.MaxSpeed * 2.0f, 0.0f, 0.0f);
+	TestTrue(TEXT("A replayed stamp is stale before it's too fast"), FMovementValidator::CheckKinematics(Previous, FastReplay, Settings) == EMovementValidationFailure::Stale);
+
+	//The clamp keeps stamps within the window around the server's clock
+	TestEqual(TEXT("A stamp inside the window is kept"), FMovementValidator::ClampTimeStamp(10200, 10.0f, 0.5f), uint32(10200));
+	TestEqual(TEXT("A future stamp is clamped to the window"), FMovementValidator::ClampTimeStamp(1000000, 10.0f, 0.5f), uint32(10500));
+	TestEqual(TEXT("A past stamp is clamped to the window"), FMovementValidator::ClampTimeStamp(1000, 10.0f, 0.5f), uint32(9500));
+	TestEqual(TEXT("The window doesn't reach before the session began"), FMovementValidator::ClampTimeStamp(0, 0.2f, 0.5f), uint32(0));
+
+	//A far future stamp would have grown the displacement tolerance enough to cover the jump, clamped it doesn't
+	const float ServerTime = Previous.TimeStamp + 0.1f;
+	FMovementSnapshot Future = MakeNext(1000.0f - Previous.TimeStamp);
+	Future.Location = Previous.Location + FVector(0.0f, 100000.0f, 0.0f);
+	TestTrue(TEXT("Unclamped, a far future stamp hides a teleport"), FMovementValidator::CheckKinematics(Previous, Future, Settings) == EMovementValidationFailure::None);
+
+	Future.TimeStamp = FMovementValidator::ClampTimeStamp(uint32(Future.TimeStamp * 1000.0f), ServerTime, 0.5f) / 1000.0f;
+	TestTrue(TEXT("Clamped, the teleport fails on displacement"), FMovementValidator::CheckKinematics(Previous, Future, Settings) == EMovementValidationFailure::Displacement);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMovementValidatorHydrostaticsTest, "SailsOfWar.Buoyancy.MovementValidator.Hydrostatics", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FMovementValidatorHydrostaticsTest::RunTest(const FString& Parameters)
+{
+	const FMovementValidationSettings Settings;
+	const FBox HullBounds(FVector(-1000.0f, -300.0f, -200.0f), FVector(1000.0f, 300.0f, 500.0f));
+	const FFloatInterval WaterHeight(0.0f, 0.0f);
+
+	FMovementSnapshot Floating(FVector::ZeroVector, FVector::ZeroVector, FVector::ZeroVector, FQuat::Identity, 10.0f);
+	TestTrue(TEXT("A level hull at the waterline floats"), FMovementValidator::CheckHydrostatics(Floating, HullBounds, WaterHeight, Settings) == EMovementValidationFailure::None);
+
+	FMovementSnapshot Heeled = Floating;
+	Heeled.Rotation = FRotator(0.0f, 0.0f, Settings.MaxHeelAngle + 10.0f).Quaternion();
+	TestTrue(TEXT("Heeling past MaxHeelAngle fails on attitude"), FMovementValidator::CheckHydrostatics(Heeled, HullBounds, WaterHeight, Settings) == EMovementValidationFailure::Attitude);
+
+	FMovementSnapshot Trimmed = Floating;
+	Trimmed.Rotation = FRotator(Settings.MaxTrimAngle + 10.0f, 0.0f, 0.0f).Quaternion();
+	TestTrue(TEXT("Trimming past MaxTrimAngle fails on attitude"), FMovementValidator::CheckHydrostatics(Trimmed, HullBounds, WaterHeight, Settings) == EMovementValidationFailure::Attitude);
+
+	FMovementSnapshot Flying = Floating;
+	Flying.Location.Z = -HullBounds.Min.Z + Settings.DraftTolerance + 100.0f;
+	TestTrue(TEXT("A keel clear of the water fails on draft"), FMovementValidator::CheckHydrostatics(Flying, HullBounds, WaterHeight, Settings) == EMovementValidationFailure::Draft);
+
+	FMovementSnapshot Sunk = Floating;
+	Sunk.Location.Z = -HullBounds.Max.Z - Settings.DraftTolerance - 100.0f;
+	TestTrue(TEXT("A deck under the water fails on draft"), FMovementValidator::CheckHydrostatics(Sunk, HullBounds, WaterHeight, Settings) == EMovementValidationFailure::Draft);
+
+	TestTrue(TEXT("Without hull bounds only the attitude is checked"), FMovementValidator::CheckHydrostatics(Flying, FBox(ForceInit), WaterHeight, Settings) == EMovementValidationFailure::None);
+	TestTrue(TEXT("Without an ocean only the attitude is checked"), FMovementValidator::CheckHydrostatics(Flying, HullBounds, FFloatInterval(), Settings) == EMovementValidationFailure::None);
+
+	//On a raised ocean the hull floats far above 0, and a wave cresting under part of a lifted hull still reaches its keel
+	FMovementSnapshot Raised = Floating;
+	Raised.Location.Z = 5000.0f;
+	TestTrue(TEXT("A hull floating on a raised ocean floats"), FMovementValidator::CheckHydrostatics(Raised, HullBounds, FFloatInterval(5000.0f, 5000.0f), Settings) == EMovementValidationFailure::None);
+	TestTrue(TEXT("A crest under the lifted keel keeps it in the water"), FMovementValidator::CheckHydrostatics(Flying, HullBounds, FFloatInterval(0.0f, Flying.Location.Z), Settings) == EMovementValidationFailure::None);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMovementValidatorPacketTest, "SailsOfWar.Buoyancy.MovementValidator.Packets", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FMovementValidatorPacketTest::RunTest(const FString& Parameters)
+{
+	const FMovementSnapshotQuantization Quantization;
+
+	FMovementSnapshot Snapshot(FVector(500.0f, 0.0f, 0.0f), FVector(0.0f, 0.0f, 10.0f), FVector::ZeroVector, FQuat::Identity, 10.0f);
+	Snapshot.Quantization = Quantization;
+
+	FMovementSnapshotPacket Packet;
+	Packet.Sequence = 10;
+	Packet.State = FQuantizedMovementSnapshot::Quantize(Snapshot);
+	FQuantizedMovementSnapshot Redundant;
+	Redundant.TimeStampMs = 50;
+	Packet.RedundantStates.Add(Redundant);
+	Redundant.TimeStampMs = 100;
+	Packet.RedundantStates.Add(Redundant);
+	TestTrue(TEXT("A keyframe an unmodified client sent is well formed"), FMovementValidator::IsWellFormed(Packet, Quantization));
+
+	FMovementSnapshotPacket Reordered = Packet;
+	Swap(Reordered.RedundantStates[0], Reordered.RedundantStates[1]);
+	TestFalse(TEXT("Redundant states newer than the ones before them are malformed"), FMovementValidator::IsWellFormed(Reordered, Quantization));
+
+	FMovementSnapshotPacket Unclamped = Packet;
+	Unclamped.State.LinearVelocity.X = FMath::RoundToInt(Quantization.MaxLinearSpeed * 2.0f);
+	TestFalse(TEXT("A keyframe velocity past the sender's clamp is malformed"), FMovementValidator::IsWellFormed(Unclamped, Quantization));
+
+	FMovementSnapshotPacket SelfDelta = Packet;
+	SelfDelta.bKeyframe = false;
+	SelfDelta.BaselineSequence = SelfDelta.Sequence;
+	TestFalse(TEXT("A delta against its own sequence is malformed"), FMovementValidator::IsWellFormed(SelfDelta, Quantization));
+
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
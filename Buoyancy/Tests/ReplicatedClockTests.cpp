@@ -0,0 +1,169 @@
+/*=================================================
+* FileName: ReplicatedClockTests.cpp
+*
+* Created by: Sails of War contributors
+* Project name: Sails of War
+* Unreal Engine version: 4.22
+* Created on: 2026/10/18
+*
+* Last Edited on: 2026/10/18
+* Last Edited by: Sails of War contributors
+*
+* -------------------------------------------------
+* Created for: Sails Of War - http://sailsofwargame.com/
+* -------------------------------------------------
+* For parts referencing UE4 code, the following copyright applies:
+* Copyright 1998-2020 Epic Games, Inc. All Rights Reserved.
+*
+* Feel free to use this software in any commercial/free game.
+* Selling this as a plugin/item, in whole or part, is not allowed.
+* =================================================*/
+
+//Project Includes:
+#include "Libraries/Buoyancy/PawnSystem/ReplicatedClock.h"
+
+//Engine Includes:
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace ReplicatedClockTests
+{
+	static const float BaseRoundTrip = 0.08f; //Seconds, split evenly between the legs
+
+	//A server clock that's Offset ahead of the local one and gains Skew seconds per local second
+	struct FSyntheticServer
+	{
+		float Offset = 0.0f;
+		float Skew = 0.0f;
+
+		float GetServerTime(float LocalTime) const { return LocalTime + Offset + Skew * LocalTime; }
+	};
+
+	/**
+	*	Ping the server and add the answer to the clock
+	*	@param	bQueued - True to add queuing delay to the legs, 50 to 100ms each and not the same both ways - too slow to be fit
+	*	@return	float - the local time the answer arrived
+	*/
+	static float Ping(FReplicatedClock& Clock, const FSyntheticServer& Server, float LocalSendTime, bool bQueued, FRandomStream& Random, const FClockSyncSettings& Settings)
+	{
+		const float Outbound = BaseRoundTrip * 0.5f + (bQueued ? Random.FRandRange(0.05f, 0.1f) : 0.0f);
+		const float Inbound = BaseRoundTrip * 0.5f + (bQueued ? Random.FRandRange(0.05f, 0.1f) : 0.0f);
+		const float LocalReceiveTime = LocalSendTime + Outbound + Inbound;
+		Clock.AddSample(LocalSendTime, Server.GetServerTime(LocalSendTime + Outbound), LocalReceiveTime, Settings);
+		return LocalReceiveTime;
+	}
+
+	//Replace the whole sample window with unqueued pings, so the estimate is the server's alone
+	static float PingWindow(FReplicatedClock& Clock, const FSyntheticServer& Server, float LocalTime, FRandomStream& Random, const FClockSyncSettings& Settings)
+	{
+		for (int32 Index = 0; Index < Settings.SampleWindow; Index++)
+		{
+			Ping(Clock, Server, LocalTime, false, Random, Settings);
+			LocalTime += Settings.FastPingInterval;
+		}
+
+		return LocalTime;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FReplicatedClockConvergenceTest, "SailsOfWar.Buoyancy.ReplicatedClock.Convergence", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FReplicatedClockConvergenceTest::RunTest(const FString& Parameters)
+{
+	using namespace ReplicatedClockTests;
+
+	const FClockSyncSettings Settings;
+	FSyntheticServer Server;
+	Server.Offset = 1234.5f;
+	Server.Skew = 0.0002f; //200 ppm, a poor crystal
+
+	//Every other ping queued on either leg, the unqueued ones anchor the offset and the skew
+	FRandomStream Random(7);
+	FReplicatedClock Clock;
+	float LocalTime = 10.0f;
+	for (int32 Index = 0; Index < Settings.SampleWindow; Index++)
+	{
+		TestFalse(TEXT("The clock isn't converged until the window is full"), Clock.IsConverged(Settings));
+		Ping(Clock, Server, LocalTime, Index % 2 == 1, Random, Settings);
+		LocalTime += Settings.PingInterval;
+	}
+
+	TestTrue(TEXT("The clock converges once the window is full"), Clock.IsConverged(Settings));
+	TestEqual(TEXT("The round trip is the unqueued one"), Clock.GetRoundTripTime(), BaseRoundTrip, 0.0005f);
+	TestEqual(TEXT("The skew is fit through the unqueued pings"), Clock.GetSkew(), Server.Skew, 0.00002f);
+	TestEqual(TEXT("The estimate matches the server now"), Clock.GetEstimatedTime(LocalTime), Server.GetServerTime(LocalTime), 0.002f);
+	TestEqual(TEXT("The skew keeps the estimate on the server a while later"), Clock.GetEstimatedTime(LocalTime + 10.0f), Server.GetServerTime(LocalTime + 10.0f), 0.003f);
+
+	//Jitter alone, every ping queued after the window filled, doesn't move the offset past the fastest ping's
+	FReplicatedClock JitteredClock;
+	LocalTime = 10.0f;
+	Ping(JitteredClock, Server, LocalTime, false, Random, Settings);
+	for (int32 Index = 1; Index < Settings.SampleWindow; Index++)
+	{
+		LocalTime += Settings.FastPingInterval;
+		Ping(JitteredClock, Server, LocalTime, true, Random, Settings);
+	}
+
+	TestEqual(TEXT("Queued pings don't pull the offset off the fastest one"), JitteredClock.GetEstimatedTime(LocalTime), Server.GetServerTime(LocalTime), 0.002f);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FReplicatedClockSlewTest, "SailsOfWar.Buoyancy.ReplicatedClock.Slew", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FReplicatedClockSlewTest::RunTest(const FString& Parameters)
+{
+	using namespace ReplicatedClockTests;
+
+	const FClockSyncSettings Settings;
+	const float FrameTime = 1.0f / 60.0f;
+	FSyntheticServer Server;
+	Server.Offset = 100.0f;
+
+	FRandomStream Random(11);
+	FReplicatedClock Clock;
+	float LocalTime = PingWindow(Clock, Server, 0.0f, Random, Settings);
+	TestEqual(TEXT("The first time is the estimate"), Clock.GetTime(LocalTime, Settings), Clock.GetEstimatedTime(LocalTime), 0.0001f);
+
+	//Steps under the threshold are slewed at no more than MaxSlewRate, so the time never runs backwards
+	const float SmallSteps[] = { Settings.SnapThreshold * 0.5f, -Settings.SnapThreshold * 0.5f };
+	for (const float Step : SmallSteps)
+	{
+		Server.Offset += Step;
+		LocalTime = PingWindow(Clock, Server, LocalTime, Random, Settings);
+
+		float LastTime = Clock.GetTime(LocalTime, Settings);
+		bool bBounded = true;
+		const int32 NumFrames = FMath::CeilToInt(FMath::Abs(Step) / Settings.MaxSlewRate / FrameTime) + 60;
+		for (int32 Frame = 0; Frame < NumFrames; Frame++)
+		{
+			LocalTime += FrameTime;
+			const float Time = Clock.GetTime(LocalTime, Settings);
+			const float Elapsed = Time - LastTime;
+			bBounded &= Elapsed >= FrameTime * (1.0f - Settings.MaxSlewRate) - 0.0001f && Elapsed <= FrameTime * (1.0f + Settings.MaxSlewRate) + 0.0001f;
+			LastTime = Time;
+		}
+
+		TestTrue(FString::Printf(TEXT("A %.2fs step is slewed at a bounded rate"), Step), bBounded);
+		TestEqual(FString::Printf(TEXT("A %.2fs step is slewed out"), Step), LastTime, Clock.GetEstimatedTime(LocalTime), 0.001f);
+	}
+
+	//Steps past the threshold jump straight to the estimate, a clock that ran ahead jumps back as well - further than the window's pings took
+	const float LargeSteps[] = { Settings.SnapThreshold * 4.0f, -Settings.SnapThreshold * 4.0f };
+	for (const float Step : LargeSteps)
+	{
+		const float Before = Clock.GetTime(LocalTime, Settings);
+		Server.Offset += Step;
+		LocalTime = PingWindow(Clock, Server, LocalTime, Random, Settings);
+
+		const float Elapsed = Settings.FastPingInterval * Settings.SampleWindow;
+		const float Time = Clock.GetTime(LocalTime, Settings);
+		TestEqual(FString::Printf(TEXT("A %.2fs step snaps to the estimate"), Step), Time, Clock.GetEstimatedTime(LocalTime), 0.0001f);
+		TestEqual(FString::Printf(TEXT("A %.2fs step moves the time by the step"), Step), Time - Before, Elapsed + Step, 0.001f);
+	}
+
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
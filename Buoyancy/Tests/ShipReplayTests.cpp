@@ -0,0 +1,222 @@
+/*=================================================
+* FileName: ShipReplayTests.cpp
+*
+* Created by: Sails of War contributors
+* Project name: Sails of War
+* Unreal Engine version: 4.22
+* Created on: 2026/10/18
+*
+* Last Edited on: 2026/10/18
+* Last Edited by: Sails of War contributors
+*
+* -------------------------------------------------
+* Created for: Sails Of War - http://sailsofwargame.com/
+* -------------------------------------------------
+* For parts referencing UE4 code, the following copyright applies:
+* Copyright 1998-2020 Epic Games, Inc. All Rights Reserved.
+*
+* Feel free to use this software in any commercial/free game.
+* Selling this as a plugin/item, in whole or part, is not allowed.
+* =================================================*/
+
+//Project Includes:
+#include "Libraries/Buoyancy/PawnSystem/ShipReplay.h"
+
+//Engine Includes:
+#include "Misc/AutomationTest.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "HAL/FileManager.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace ShipReplayTests
+{
+	static const uint32 NumShips = 2;
+	static const float RecordDuration = 3.5f; //Seconds, several chunks at the test's chunk duration
+	static const float RecordInterval = 0.05f;
+
+	static bool IsSameSnapshot(const FQuantizedMovementSnapshot& A, const FQuantizedMovementSnapshot& B)
+	{
+		return A.Location == B.Location && A.Rotation == B.Rotation && A.LinearVelocity == B.LinearVelocity && A.AngularVelocity == B.AngularVelocity
+			&& A.TimeStampMs == B.TimeStampMs && A.RotationLargestIndex == B.RotationLargestIndex && A.EventFlag == B.EventFlag && A.Precision == B.Precision;
+	}
+
+	/* Record two ships sailing in circles, the second changes its position precision halfway so it needs a keyframe mid-chunk */
+	static void RecordShips(const FString& Path, TArray<FShipReplayRecord>& OutRecorded)
+	{
+		FShipReplaySettings Settings;
+		Settings.bEnableRecording = true;
+		Settings.ChunkDuration = 1.0f;
+
+		FShipReplayWriter Writer;
+		if (!Writer.Open(Path, Settings))
+			return;
+
+		const int32 NumSteps = FMath::CeilToInt(RecordDuration / RecordInterval);
+		for (int32 Step = 0; Step < NumSteps; Step++)
+		{
+			for (uint32 ShipId = 0; ShipId < NumShips; ShipId++)
+			{
+				//Ships are a few milliseconds apart, so the chunk's records sort the same way they were recorded
+				const float Time = 60.0f + Step * RecordInterval + ShipId * 0.005f;
+				const float Angle = Time * 0.2f + ShipId;
+				FMovementSnapshot Snapshot = FMovementSnapshot(
+					FVector(-FMath::Sin(Angle), FMath::Cos(Angle), 0.0f) * 400.0f,
+					FVector(0.0f, 0.0f, 11.5f),
+					FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.01f * FMath::Sin(Time)) * 2000.0f,
+					FRotator(FMath::Sin(Time) * 5.0f, FMath::RadiansToDegrees(Angle), FMath::Cos(Time) * 10.0f).Quaternion(),
+					Time);
+				Snapshot.Quantization.PositionPrecision = (ShipId == 1 && Step >= NumSteps / 2) ? ESnapshotPositionPrecision::Millimeter : ESnapshotPositionPrecision::Centimeter;
+
+				const FQuantizedMovementSnapshot Quantized = FQuantizedMovementSnapshot::Quantize(Snapshot);
+				Writer.Record(ShipId, FString::Printf(TEXT("Ship%u"), ShipId), Quantized);
+				OutRecorded.Emplace(ShipId, Quantized);
+			}
+		}
+
+		Writer.Close();
+	}
+
+	/* Read every chunk of a recording and compare it to what was recorded */
+	static void TestRecording(FAutomationTestBase& Test, const TCHAR* What, const FString& Path, const TArray<FShipReplayRecord>& Recorded)
+	{
+		FShipReplayReader Reader;
+		if (!Test.TestTrue(FString::Printf(TEXT("%s: opens"), What), Reader.Open(Path)))
+			return;
+
+		Test.TestTrue(FString::Printf(TEXT("%s: spans several chunks"), What), Reader.GetNumChunks() > 2);
+
+		TArray<FShipReplayRecord> Read;
+		TArray<FShipReplayRecord> ChunkRecords;
+		for (int32 ChunkIndex = 0; ChunkIndex < Reader.GetNumChunks(); ChunkIndex++)
+		{
+			Test.TestTrue(FString::Printf(TEXT("%s: chunk %d reads"), What, ChunkIndex), Reader.ReadChunk(ChunkIndex, ChunkRecords));
+			Read.Append(ChunkRecords);
+		}
+
+		if (!Test.TestEqual(FString::Printf(TEXT("%s: record count"), What), Read.Num(), Recorded.Num()))
+			return;
+
+		for (int32 Index = 0; Index < Recorded.Num(); Index++)
+		{
+			if (Read[Index].ShipId != Recorded[Index].ShipId || !IsSameSnapshot(Read[Index].Snapshot, Recorded[Index].Snapshot))
+			{
+				Test.AddError(FString::Printf(TEXT("%s: record %d doesn't match what was recorded"), What, Index));
+				return;
+			}
+		}
+
+		const FString* ShipName = Reader.GetShipNames().Find(1);
+		Test.TestTrue(FString::Printf(TEXT("%s: ship names are read from the keyframes"), What), ShipName != nullptr && *ShipName == TEXT("Ship1"));
+		Test.TestEqual(FString::Printf(TEXT("%s: seeking finds the chunk holding a time"), What), Reader.FindChunk(Reader.GetChunk(1).StartTimeMs / 1000.0f + 0.01f), 1);
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FShipReplayRoundTripTest, "SailsOfWar.Buoyancy.ShipReplay.RoundTrip", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FShipReplayRoundTripTest::RunTest(const FString& Parameters)
+{
+	using namespace ShipReplayTests;
+
+	const FString Path = FPaths::Combine(FPaths::AutomationTransientDir(), TEXT("ShipReplayRoundTrip.sowreplay"));
+	const FString ScanPath = FPaths::Combine(FPaths::AutomationTransientDir(), TEXT("ShipReplayRoundTripScan.sowreplay"));
+
+	TArray<FShipReplayRecord> Recorded;
+	RecordShips(Path, Recorded);
+	if (!TestTrue(TEXT("The recording was written"), Recorded.Num() > 0))
+		return false;
+
+	TestRecording(*this, TEXT("Indexed"), Path, Recorded);
+
+	//A recording that was never closed has no index or footer, and may end in a torn chunk
+	TArray<uint8> Bytes;
+	if (!TestTrue(TEXT("The recording loads"), FFileHelper::LoadFileToArray(Bytes, *Path)) || !TestTrue(TEXT("The recording has a footer"), Bytes.Num() > 12))
+		return false;
+
+	int64 IndexOffset = 0;
+	FMemory::Memcpy(&IndexOffset, Bytes.GetData() + Bytes.Num() - 12, sizeof(IndexOffset));
+	if (!TestTrue(TEXT("The footer points into the recording"), IndexOffset > 0 && IndexOffset < Bytes.Num()))
+		return false;
+
+	Bytes.SetNum(IndexOffset);
+	//A whole chunk header whose records never made it to disk
+	const uint8 TornChunk[] = { 0x43, 0x48, 0x4E, 0x4B, 0x10, 0x27, 0, 0, 0x10, 0x27, 0, 0, 0x04, 0, 0, 0, 0x20, 0x03, 0, 0 };
+	Bytes.Append(TornChunk, ARRAY_COUNT(TornChunk));
+	TestTrue(TEXT("The unclosed recording saves"), FFileHelper::SaveArrayToFile(Bytes, *ScanPath));
+	TestRecording(*this, TEXT("Scanned"), ScanPath, Recorded);
+
+	IFileManager::Get().Delete(*Path);
+	IFileManager::Get().Delete(*ScanPath);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FShipReplaySeekTest, "SailsOfWar.Buoyancy.ShipReplay.Seek", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FShipReplaySeekTest::RunTest(const FString& Parameters)
+{
+	using namespace ShipReplayTests;
+
+	const FString Path = FPaths::Combine(FPaths::AutomationTransientDir(), TEXT("ShipReplaySeek.sowreplay"));
+	FShipReplaySettings Settings;
+	Settings.bEnableRecording = true;
+	Settings.ChunkDuration = 1.0f;
+
+	//The second ship's clock lags by a second and a half, its only snapshot starts the third chunk before the second one
+	FShipReplayWriter Writer;
+	if (!TestTrue(TEXT("The recording opens"), Writer.Open(Path, Settings)))
+		return false;
+
+	const int32 NumSteps = FMath::CeilToInt(RecordDuration / RecordInterval);
+	for (int32 Step = 0; Step < NumSteps; Step++)
+	{
+		const float Time = 60.0f + Step * RecordInterval;
+		Writer.Record(1, TEXT("Ship1"), FQuantizedMovementSnapshot::Quantize(FMovementSnapshot(FVector::ZeroVector, FVector::ZeroVector, FVector(Time, 0.0f, 0.0f), FQuat::Identity, Time)));
+		if (Step == FMath::RoundToInt(2.0f / RecordInterval))
+			Writer.Record(2, TEXT("Ship2"), FQuantizedMovementSnapshot::Quantize(FMovementSnapshot(FVector::ZeroVector, FVector::ZeroVector, FVector::ZeroVector, FQuat::Identity, Time - 1.5f)));
+	}
+
+	Writer.Close();
+
+	FShipReplayReader Reader;
+	if (!TestTrue(TEXT("The recording reads"), Reader.Open(Path)) || !TestTrue(TEXT("The recording spans several chunks"), Reader.GetNumChunks() > 3))
+		return false;
+
+	TestTrue(TEXT("The lagging ship starts the third chunk before the second"), Reader.GetChunk(2).StartTimeMs < Reader.GetChunk(1).StartTimeMs);
+	bool bEndsSorted = true;
+	for (int32 ChunkIndex = 1; ChunkIndex < Reader.GetNumChunks(); ChunkIndex++)
+	{
+		bEndsSorted &= Reader.GetChunk(ChunkIndex).EndTimeMs >= Reader.GetChunk(ChunkIndex - 1).EndTimeMs;
+	}
+	TestTrue(TEXT("The chunks' ends never decrease"), bEndsSorted);
+
+	TestEqual(TEXT("A time before the recording seeks to the first chunk"), Reader.FindChunk(10.0f), 0);
+	TestEqual(TEXT("A time past the recording seeks to the last chunk"), Reader.FindChunk(100.0f), Reader.GetNumChunks() - 1);
+
+	//The chunk found holds the first ship's snapshot at the time, and every chunk before it only holds older snapshots
+	const uint32 SeekTimesMs[] = { 61200, 62000, 62500 };
+	TArray<FShipReplayRecord> Records;
+	for (const uint32 SeekTimeMs : SeekTimesMs)
+	{
+		const int32 Found = Reader.FindChunk(SeekTimeMs / 1000.0f);
+		bool bOlderBefore = true;
+		for (int32 ChunkIndex = 0; ChunkIndex < Found; ChunkIndex++)
+		{
+			Reader.ReadChunk(ChunkIndex, Records);
+			for (const FShipReplayRecord& Record : Records)
+				bOlderBefore &= Record.Snapshot.TimeStampMs < SeekTimeMs;
+		}
+
+		TestTrue(FString::Printf(TEXT("Chunks before the one found for %ums are older"), SeekTimeMs), bOlderBefore);
+		TestTrue(FString::Printf(TEXT("The chunk found for %ums reads"), SeekTimeMs), Reader.ReadChunk(Found, Records));
+		TestTrue(FString::Printf(TEXT("The chunk found for %ums holds the time"), SeekTimeMs), Records.ContainsByPredicate([SeekTimeMs](const FShipReplayRecord& Record)
+		{
+			return Record.ShipId == 1 && Record.Snapshot.TimeStampMs == SeekTimeMs;
+		}));
+	}
+
+	IFileManager::Get().Delete(*Path);
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
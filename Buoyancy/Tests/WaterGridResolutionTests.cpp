@@ -0,0 +1,122 @@
+/*=================================================
+* FileName: WaterGridResolutionTests.cpp
+*
+* Created by: Sails of War contributors
+* Project name: Sails of War
+* Unreal Engine version: 4.22
+* Created on: 2026/10/18
+*
+* Last Edited on: 2026/10/18
+* Last Edited by: Sails of War contributors
+*
+* -------------------------------------------------
+* Created for: Sails Of War - http://sailsofwargame.com/
+* -------------------------------------------------
+* For parts referencing UE4 code, the following copyright applies:
+* Copyright 1998-2020 Epic Games, Inc. All Rights Reserved.
+*
+* Feel free to use this software in any commercial/free game.
+* Selling this as a plugin/item, in whole or part, is not allowed.
+* =================================================*/
+
+//Project Includes:
+#include "Libraries/Buoyancy/PawnSystem/NetworkedBuoyantPawnMovementComponent.h"
+
+//Engine Includes:
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace WaterGridResolutionTests
+{
+	//A single long crested wave, travelling along Direction
+	struct FSinusoid
+	{
+		float Amplitude = 50.0f;
+		float Wavelength = 0.0f;
+		FVector Direction = FVector(1.0f, 0.0f, 0.0f);
+		float Phase = 0.3f;
+
+		float GetHeight(const FVector& Location) const { return Amplitude * FMath::Sin((2.0f * PI * (Location | Direction) / Wavelength) + Phase); }
+	};
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FWaterGridResolutionWavelengthTest, "SailsOfWar.Buoyancy.WaterGridResolution.Wavelength", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FWaterGridResolutionWavelengthTest::RunTest(const FString& Parameters)
+{
+	using namespace WaterGridResolutionTests;
+
+	const FWaterGridResolution Resolution;
+	const FVector Center(12345.0f, -6789.0f, 0.0f);
+	TArray<float> Heights;
+
+	//Transects spanning a whole number of periods, a partial period weights the slope and the curvature unevenly
+	const float TransectLength = Resolution.ProbeSpacing * (Resolution.NumProbeSamples - 1);
+	const float Periods[] = { 3.0f, 4.0f, 5.0f };
+	const FVector Directions[] = { FVector(1.0f, 0.0f, 0.0f), FVector(0.0f, 1.0f, 0.0f) };
+	for (const float NumPeriods : Periods)
+	{
+		for (const FVector& Direction : Directions)
+		{
+			FSinusoid Wave;
+			Wave.Wavelength = TransectLength / NumPeriods;
+			Wave.Direction = Direction;
+
+			const float Estimate = Resolution.EstimateShortestWavelength([&Wave](const FVector& Location) { return Wave.GetHeight(Location); }, Center, Heights);
+			TestEqual(FString::Printf(TEXT("A %.0f cm wave along %s is measured at its wavelength"), Wave.Wavelength, *Direction.ToString()), Estimate, Wave.Wavelength, Wave.Wavelength * 0.05f);
+		}
+	}
+
+	//Flat water and ripples too low to matter count as calm
+	TestEqual(TEXT("Flat water has no wavelength"), Resolution.EstimateShortestWavelength([](const FVector& Location) { return 0.0f; }, Center, Heights), 0.0f);
+
+	FSinusoid Ripple;
+	Ripple.Wavelength = TransectLength / 4.0f;
+	Ripple.Amplitude = Resolution.MinSignificantSlope * Ripple.Wavelength / (4.0f * PI); //Well under the significant rms slope
+	TestEqual(TEXT("Water calmer than MinSignificantSlope has no wavelength"), Resolution.EstimateShortestWavelength([&Ripple](const FVector& Location) { return Ripple.GetHeight(Location); }, Center, Heights), 0.0f);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FWaterGridResolutionCellSizeTest, "SailsOfWar.Buoyancy.WaterGridResolution.CellSize", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FWaterGridResolutionCellSizeTest::RunTest(const FString& Parameters)
+{
+	FWaterGridResolution Resolution;
+
+	//Within every limit the cell follows the waves
+	const int32 CellSize = Resolution.PickCellSize(1200.0f, 3000.0f);
+	TestEqual(TEXT("The cell resolves the wavelength"), CellSize, 200);
+
+	//The budget holds for every hull, wave and budget, even where it has to win over the waves and the hull
+	const int32 Budgets[] = { 16, 100, 400, 1000 };
+	const int32 Steps[] = { 1, 25 };
+	for (const int32 Budget : Budgets)
+	{
+		for (const int32 Step : Steps)
+		{
+			Resolution.MaxGridSamples = Budget;
+			Resolution.CellSizeStep = Step;
+
+			bool bWithinBudget = true;
+			bool bOnStep = true;
+			for (float HullSize = 100.0f; HullSize <= 20000.0f; HullSize += 37.0f)
+			{
+				for (float Wavelength = 0.0f; Wavelength <= 10000.0f; Wavelength += 250.0f)
+				{
+					const int32 Picked = Resolution.PickCellSize(Wavelength, HullSize);
+					bWithinBudget &= FWaterGridResolution::GetMaxGridVertices(HullSize, Picked) <= Budget;
+					bOnStep &= Picked % Step == 0;
+				}
+			}
+
+			TestTrue(FString::Printf(TEXT("%d samples, %d cm steps: the grid stays within the budget"), Budget, Step), bWithinBudget);
+			TestTrue(FString::Printf(TEXT("%d samples, %d cm steps: the cell is a multiple of the step"), Budget, Step), bOnStep);
+		}
+	}
+
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS